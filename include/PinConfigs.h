@@ -15,9 +15,16 @@
 #define D2_PIN (4)
 #define D3_PIN (5)
 
+// RTC INT (PCF8563 INT / MCP79411 MFP, open drain active low), -1 = not connected
+// Board with the line wired: build_flags = -DRTC_INT_PIN=<gpio>
+#ifndef RTC_INT_PIN
+#define RTC_INT_PIN (-1)
+#endif
+
 // Analog In
 #define A1_PIN (1)
 #define A2_PIN (2)
 
 const int o_pin[] = { O1_PIN, O2_PIN, O3_PIN, O4_PIN };
 
+const int a_pin[] = { A1_PIN, A2_PIN };
@@ -158,6 +158,227 @@ bool ArtronShop_RTC::write(struct tm* timeinfo) {
     return true;
 }
 
+// PCF8563 registers
+#define PCF8563_CTRL2       0x01
+#define PCF8563_ALARM_MIN   0x09
+#define PCF8563_TIMER_CTRL  0x0E
+#define PCF8563_TIMER       0x0F
+#define PCF8563_TIE         (1 << 0)
+#define PCF8563_AIE         (1 << 1)
+#define PCF8563_TF          (1 << 2)
+#define PCF8563_AF          (1 << 3)
+#define PCF8563_TI_TP       (1 << 4) // 0 = INT follow TF
+#define PCF8563_AE          (1 << 7) // 1 = alarm field disabled
+
+// MCP79411 registers
+#define MCP79411_CONTROL    0x07
+#define MCP79411_ALM0SEC    0x0A
+#define MCP79411_ALM0WKDAY  0x0D
+#define MCP79411_ALM0EN     (1 << 4)
+#define MCP79411_ALM0IF     (1 << 3)
+#define MCP79411_MSK_ALL    (0x07 << 4) // Match sec, min, hour, weekday, date, month
+
+bool ArtronShop_RTC::setAlarm(struct tm* timeinfo) {
+    if (!timeinfo) {
+        return false;
+    }
+
+    if (this->type == PCF8563) {
+        uint8_t buff[4];
+        buff[0] = DECtoBCD(timeinfo->tm_min) & 0x7F;
+        buff[1] = DECtoBCD(timeinfo->tm_hour) & 0x3F;
+        buff[2] = DECtoBCD(timeinfo->tm_mday) & 0x3F;
+        buff[3] = PCF8563_AE; // Weekday not used
+
+        this->wire->beginTransmission(this->devAddr);
+        this->wire->write(PCF8563_ALARM_MIN);
+        this->wire->write(buff, 4);
+        if (this->wire->endTransmission() != 0) {
+            return false;
+        }
+
+        uint8_t ctrl2;
+        if (!readReg(PCF8563_CTRL2, &ctrl2)) {
+            return false;
+        }
+        ctrl2 = (ctrl2 | PCF8563_AIE | PCF8563_TF) & ~PCF8563_AF; // Write 1 to TF keep it unchanged
+        return writeReg(PCF8563_CTRL2, ctrl2);
+    }
+
+    if (this->type == MCP79411) {
+        uint8_t buff[6];
+        buff[0] = DECtoBCD(timeinfo->tm_sec) & 0x7F;
+        buff[1] = DECtoBCD(timeinfo->tm_min) & 0x7F;
+        buff[2] = DECtoBCD(timeinfo->tm_hour) & 0x3F;
+        buff[3] = MCP79411_MSK_ALL | (DECtoBCD(timeinfo->tm_wday) & 0x07); // Weekday as write() keep it, ALMPOL = 0 (MFP low when alarm), clear ALM0IF
+        buff[4] = DECtoBCD(timeinfo->tm_mday) & 0x3F;
+        buff[5] = DECtoBCD(timeinfo->tm_mon + 1) & 0x1F;
+
+        this->wire->beginTransmission(this->devAddr);
+        this->wire->write(MCP79411_ALM0SEC);
+        this->wire->write(buff, 6);
+        if (this->wire->endTransmission() != 0) {
+            return false;
+        }
+
+        uint8_t control;
+        if (!readReg(MCP79411_CONTROL, &control)) {
+            return false;
+        }
+        return writeReg(MCP79411_CONTROL, control | MCP79411_ALM0EN);
+    }
+
+    return false;
+}
+
+bool ArtronShop_RTC::disableAlarm() {
+    if (this->type == PCF8563) {
+        uint8_t ctrl2;
+        if (!readReg(PCF8563_CTRL2, &ctrl2)) {
+            return false;
+        }
+        return writeReg(PCF8563_CTRL2, (ctrl2 | PCF8563_TF) & ~(PCF8563_AIE | PCF8563_AF));
+    }
+
+    if (this->type == MCP79411) {
+        uint8_t control;
+        if (!readReg(MCP79411_CONTROL, &control)) {
+            return false;
+        }
+        return writeReg(MCP79411_CONTROL, control & ~MCP79411_ALM0EN) && clearAlarmFlag();
+    }
+
+    return false;
+}
+
+bool ArtronShop_RTC::getAlarmFlag(bool *fired) {
+    uint8_t value;
+    if (this->type == PCF8563) {
+        if (!readReg(PCF8563_CTRL2, &value)) {
+            return false;
+        }
+        *fired = value & PCF8563_AF;
+        return true;
+    }
+
+    if (this->type == MCP79411) {
+        if (!readReg(MCP79411_ALM0WKDAY, &value)) {
+            return false;
+        }
+        *fired = value & MCP79411_ALM0IF;
+        return true;
+    }
+
+    return false;
+}
+
+bool ArtronShop_RTC::clearAlarmFlag() {
+    uint8_t value;
+    if (this->type == PCF8563) {
+        if (!readReg(PCF8563_CTRL2, &value)) {
+            return false;
+        }
+        return writeReg(PCF8563_CTRL2, (value | PCF8563_TF) & ~PCF8563_AF);
+    }
+
+    if (this->type == MCP79411) {
+        if (!readReg(MCP79411_ALM0WKDAY, &value)) {
+            return false;
+        }
+        return writeReg(MCP79411_ALM0WKDAY, value & ~MCP79411_ALM0IF);
+    }
+
+    return false;
+}
+
+bool ArtronShop_RTC::setTimer(uint32_t seconds) {
+    if ((this->type != PCF8563) || (seconds == 0)) {
+        return false;
+    }
+
+    uint8_t timerCtrl, count;
+    if (seconds <= 255) {
+        timerCtrl = 0x80 | 0x02; // TE, 1 Hz
+        count = seconds;
+    } else if (seconds <= (255UL * 60UL)) {
+        timerCtrl = 0x80 | 0x03; // TE, 1/60 Hz
+        count = (seconds + 59) / 60;
+    } else {
+        return false;
+    }
+
+    if (!writeReg(PCF8563_TIMER_CTRL, 0x03) || !writeReg(PCF8563_TIMER, count)) { // Stop, then load
+        return false;
+    }
+
+    uint8_t ctrl2;
+    if (!readReg(PCF8563_CTRL2, &ctrl2)) {
+        return false;
+    }
+    ctrl2 = (ctrl2 | PCF8563_TIE | PCF8563_AF) & ~(PCF8563_TF | PCF8563_TI_TP); // Write 1 to AF keep it unchanged
+    if (!writeReg(PCF8563_CTRL2, ctrl2)) {
+        return false;
+    }
+    return writeReg(PCF8563_TIMER_CTRL, timerCtrl);
+}
+
+bool ArtronShop_RTC::stopTimer() {
+    if (this->type != PCF8563) {
+        return false;
+    }
+
+    uint8_t ctrl2;
+    if (!writeReg(PCF8563_TIMER_CTRL, 0x03) || !readReg(PCF8563_CTRL2, &ctrl2)) {
+        return false;
+    }
+    return writeReg(PCF8563_CTRL2, (ctrl2 | PCF8563_AF) & ~(PCF8563_TIE | PCF8563_TF));
+}
+
+bool ArtronShop_RTC::getTimerFlag(bool *fired) {
+    uint8_t ctrl2;
+    if ((this->type != PCF8563) || !readReg(PCF8563_CTRL2, &ctrl2)) {
+        return false;
+    }
+    *fired = ctrl2 & PCF8563_TF;
+    return true;
+}
+
+bool ArtronShop_RTC::clearTimerFlag() {
+    uint8_t ctrl2;
+    if ((this->type != PCF8563) || !readReg(PCF8563_CTRL2, &ctrl2)) {
+        return false;
+    }
+    return writeReg(PCF8563_CTRL2, (ctrl2 | PCF8563_AF) & ~PCF8563_TF);
+}
+
+RTC_Type ArtronShop_RTC::getType() {
+    return this->type;
+}
+
+int ArtronShop_RTC::getAddress() {
+    return this->devAddr;
+}
+
+bool ArtronShop_RTC::readReg(uint8_t reg, uint8_t *value) {
+    this->wire->beginTransmission(this->devAddr);
+    this->wire->write(reg);
+    if (this->wire->endTransmission() != 0) {
+        return false;
+    }
+    if (this->wire->requestFrom(this->devAddr, 1) != 1) {
+        return false;
+    }
+    *value = this->wire->read();
+    return true;
+}
+
+bool ArtronShop_RTC::writeReg(uint8_t reg, uint8_t value) {
+    this->wire->beginTransmission(this->devAddr);
+    this->wire->write(reg);
+    this->wire->write(value);
+    return this->wire->endTransmission() == 0;
+}
+
 bool ArtronShop_RTC::CheckI2CDevice(int addr) {
     Wire.beginTransmission(addr);
     return Wire.endTransmission() == 0;
@@ -22,6 +22,8 @@ class ArtronShop_RTC {
         uint8_t DECtoBCD(uint8_t n) ;
 
         bool CheckI2CDevice(int addr) ;
+        bool readReg(uint8_t reg, uint8_t *value) ;
+        bool writeReg(uint8_t reg, uint8_t value) ;
 
     public:
         ArtronShop_RTC(TwoWire *bus = &Wire, RTC_Type type = UNKNOW);
@@ -30,6 +32,22 @@ class ArtronShop_RTC {
         bool read(struct tm *timeinfo) ;
         bool write(struct tm *timeinfo) ;
 
+        // Alarm, INT pin go low when match (PCF8563: minute, hour, day / MCP79411: full date and time)
+        // DS1338 has no alarm, return false
+        bool setAlarm(struct tm *timeinfo) ;
+        bool disableAlarm() ;
+        bool getAlarmFlag(bool *fired) ;
+        bool clearAlarmFlag() ;
+
+        // Countdown timer, INT pin go low when reach 0 (PCF8563 only, 1 - 255 sec or 1 - 255 min)
+        bool setTimer(uint32_t seconds) ;
+        bool stopTimer() ;
+        bool getTimerFlag(bool *fired) ;
+        bool clearTimerFlag() ;
+
+        RTC_Type getType() ;
+        int getAddress() ;
+
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+// ===================================================================
+// Native (host) build only, just enough Arduino API for the hardware
+// independent modules. Time is simulated: it only move on delay() or
+// NativeHal_advance(), so a run is deterministic and faster than real,
+// unless NativeHal_useRealTime() (network harness against a live server).
+// ===================================================================
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <stdarg.h>
+#include "esp_log.h"
+#include "WString.h"
+
+using std::min;
+using std::max;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+long random(long howmax);               // [0, howmax), rand() so a run is repeatable
+long random(long howmin, long howmax);
+
+void NativeHal_advance(uint32_t ms);    // Move the simulated clock
+void NativeHal_setMillis(uint64_t ms);
+void NativeHal_useRealTime();           // millis / micros follow the host clock, delay sleep
+
+// Single thread on the host, critical sections are no-op
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void) (mux))
+#define portEXIT_CRITICAL(mux) ((void) (mux))
+typedef void *TaskHandle_t;
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return (TaskHandle_t) 1; }
+
+// Serial is stdout
+class NativeSerial {
+public:
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  size_t print(const char *text) { return fputs(text, stdout) >= 0 ? strlen(text) : 0; }
+  size_t println(const char *text = "") { return print(text) + print("\n"); }
+};
+extern NativeSerial Serial;
+
+struct NativeAllocStats {
+  uint64_t count; // malloc / calloc / realloc calls since start
+  uint64_t bytes; // Requested in those calls, free not subtracted
+};
+bool NativeHal_allocStats(NativeAllocStats *stats); // false if this libc can not be counted (glibc only)
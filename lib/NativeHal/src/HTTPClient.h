@@ -0,0 +1,75 @@
+#pragma once
+
+// Native (host) build only, HTTP/1.1 client with the ESP32 HTTPClient calls and error codes
+// HttpTransport use. One request per connection (Connection: close), http:// only.
+
+#include "Arduino.h"
+#include "WiFiClient.h"
+
+#define HTTPC_ERROR_CONNECTION_REFUSED  (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED  (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED       (-4)
+#define HTTPC_ERROR_CONNECTION_LOST     (-5)
+#define HTTPC_ERROR_NO_STREAM           (-6)
+#define HTTPC_ERROR_NO_HTTP_SERVER      (-7)
+#define HTTPC_ERROR_TOO_LESS_RAM        (-8)
+#define HTTPC_ERROR_ENCODING            (-9)
+#define HTTPC_ERROR_STREAM_WRITE        (-10)
+#define HTTPC_ERROR_READ_TIMEOUT        (-11)
+
+#define HTTPCLIENT_DEFAULT_TCP_TIMEOUT  5000
+
+typedef enum {
+  HTTP_CODE_OK = 200,
+  HTTP_CODE_CREATED = 201,
+  HTTP_CODE_ACCEPTED = 202,
+  HTTP_CODE_NO_CONTENT = 204,
+  HTTP_CODE_BAD_REQUEST = 400,
+  HTTP_CODE_UNAUTHORIZED = 401,
+  HTTP_CODE_NOT_FOUND = 404,
+  HTTP_CODE_TOO_MANY_REQUESTS = 429,
+  HTTP_CODE_INTERNAL_SERVER_ERROR = 500,
+  HTTP_CODE_SERVICE_UNAVAILABLE = 503,
+} t_http_codes;
+
+class HTTPClient {
+public:
+  bool begin(WiFiClient &client, const String &url); // client may already be connected
+  bool begin(const String &url);
+  void end();
+
+  void setTimeout(uint16_t timeout) { this->timeout = timeout; }
+  void addHeader(const String &name, const String &value);
+  void collectHeaders(const char *headerKeys[], const size_t headerKeysCount); // Before sendRequest, up to 4
+  String header(const char *name); // Collected response header, "" if absent
+
+  int sendRequest(const char *method, uint8_t *payload = NULL, size_t size = 0);
+  int GET() { return sendRequest("GET"); }
+  int POST(const String &payload) { return sendRequest("POST", (uint8_t *) payload.c_str(), payload.length()); }
+  String getString(); // Body, Content-Length / chunked / until close
+  int getSize() { return contentLength; }
+
+  static String errorToString(int error);
+
+private:
+  bool readLine(String *line);
+  int readByte(); // -1 = closed or timeout (timedOut set)
+
+  WiFiClient ownClient;
+  WiFiClient *client = NULL;
+  String host;
+  String path;
+  uint16_t port = 80;
+  uint16_t timeout = HTTPCLIENT_DEFAULT_TCP_TIMEOUT;
+  String headers;
+  int contentLength = -1;
+  bool chunked = false;
+  bool timedOut = false;
+  const char *collectKeys[4];
+  String collectValues[4];
+  size_t collectCount = 0;
+  uint8_t buffer[1024];
+  size_t bufferLength = 0;
+  size_t bufferPos = 0;
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+// Native (host) build only, IPv4 address as the Arduino core hold it
+
+#include <stdint.h>
+
+class IPAddress {
+public:
+  IPAddress() { }
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : address((uint32_t) a | b << 8 | c << 16 | (uint32_t) d << 24) { }
+  explicit IPAddress(uint32_t networkOrder) : address(networkOrder) { }
+
+  operator uint32_t() const { return address; } // Network byte order
+  uint8_t operator[](int index) const { return (address >> (index * 8)) & 0xFF; }
+
+private:
+  uint32_t address = 0;
+};
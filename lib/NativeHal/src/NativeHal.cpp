@@ -0,0 +1,108 @@
+#include "Arduino.h"
+
+#include <chrono>
+#include <thread>
+
+static uint64_t simulatedMillis = 0;
+static bool realTime = false;
+static std::chrono::steady_clock::time_point realStart;
+
+NativeSerial Serial;
+
+static uint64_t realMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - realStart).count();
+}
+
+uint32_t millis() {
+  return realTime ? (uint32_t) (realMicros() / 1000) : (uint32_t) simulatedMillis;
+}
+
+uint32_t micros() {
+  return realTime ? (uint32_t) realMicros() : (uint32_t) (simulatedMillis * 1000);
+}
+
+void delay(uint32_t ms) {
+  if (realTime) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  } else {
+    simulatedMillis += ms;
+  }
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  if (in_max == in_min) {
+    return out_min;
+  }
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+long random(long howmax) {
+  return howmax > 0 ? rand() % howmax : 0;
+}
+
+long random(long howmin, long howmax) {
+  return howmax > howmin ? howmin + random(howmax - howmin) : howmin;
+}
+
+void NativeHal_advance(uint32_t ms) {
+  simulatedMillis += ms;
+}
+
+void NativeHal_setMillis(uint64_t ms) {
+  simulatedMillis = ms;
+}
+
+void NativeHal_useRealTime() {
+  realStart = std::chrono::steady_clock::now();
+  realTime = true;
+}
+
+size_t NativeSerial::printf(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  int n = vprintf(format, args);
+  va_end(args);
+  return n > 0 ? n : 0;
+}
+
+#if defined(__GLIBC__)
+
+// Wrap the glibc allocator, operator new and ArduinoJson's pool go through malloc too
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+static NativeAllocStats allocStats = { 0, 0 };
+
+extern "C" void *malloc(size_t size) __THROW {
+  allocStats.count++;
+  allocStats.bytes += size;
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) __THROW {
+  allocStats.count++;
+  allocStats.bytes += count * size;
+  return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) __THROW {
+  allocStats.count++;
+  allocStats.bytes += size;
+  return __libc_realloc(ptr, size);
+}
+
+bool NativeHal_allocStats(NativeAllocStats *stats) {
+  *stats = allocStats;
+  return true;
+}
+
+#else
+
+bool NativeHal_allocStats(NativeAllocStats *stats) {
+  stats->count = 0;
+  stats->bytes = 0;
+  return false;
+}
+
+#endif
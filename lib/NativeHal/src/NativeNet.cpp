@@ -0,0 +1,304 @@
+#include "WiFi.h"
+#include "HTTPClient.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <strings.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+NativeWiFi WiFi;
+
+// ---------------- WiFi ----------------
+int NativeWiFi::hostByName(const char *host, IPAddress &ip) {
+  struct addrinfo hints = {};
+  struct addrinfo *result = NULL;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host, NULL, &hints, &result) != 0 || !result) {
+    return 0;
+  }
+  ip = IPAddress((uint32_t) ((struct sockaddr_in *) result->ai_addr)->sin_addr.s_addr);
+  freeaddrinfo(result);
+  return 1;
+}
+
+// ---------------- WiFiClient ----------------
+int WiFiClient::connect(IPAddress ip, uint16_t port, int32_t timeout) {
+  stop();
+  fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return 0;
+  }
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+  struct sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = (uint32_t) ip;
+
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK); // Connect with timeout
+  int ret = ::connect(fd, (struct sockaddr *) &address, sizeof(address));
+  if (ret < 0 && errno == EINPROGRESS) {
+    struct pollfd p = { fd, POLLOUT, 0 };
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (poll(&p, 1, timeout) == 1 && getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0) {
+      ret = 0;
+    }
+  }
+  if (ret < 0) {
+    stop();
+    return 0;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+  return 1;
+}
+
+int WiFiClient::connect(const char *host, uint16_t port, int32_t timeout) {
+  IPAddress ip;
+  if (!WiFi.hostByName(host, ip)) {
+    return 0;
+  }
+  return connect(ip, port, timeout);
+}
+
+size_t WiFiClient::write(const uint8_t *buffer, size_t size) {
+  size_t sent = 0;
+  while (fd >= 0 && sent < size) {
+#ifdef MSG_NOSIGNAL
+    ssize_t n = send(fd, buffer + sent, size - sent, MSG_NOSIGNAL);
+#else
+    ssize_t n = send(fd, buffer + sent, size - sent, 0);
+#endif
+    if (n <= 0) {
+      break;
+    }
+    sent += n;
+  }
+  return sent;
+}
+
+int WiFiClient::read(uint8_t *buffer, size_t size, uint32_t timeout) {
+  if (fd < 0) {
+    return 0;
+  }
+  struct pollfd p = { fd, POLLIN, 0 };
+  if (poll(&p, 1, timeout) != 1) {
+    return -1;
+  }
+  ssize_t n = recv(fd, buffer, size, 0);
+  return (n < 0) ? -1 : (int) n;
+}
+
+void WiFiClient::stop() {
+  if (fd >= 0) {
+    close(fd);
+    fd = -1;
+  }
+}
+
+// ---------------- HTTPClient ----------------
+bool HTTPClient::begin(WiFiClient &client, const String &url) {
+  if (!begin(url)) {
+    return false;
+  }
+  this->client = &client;
+  return true;
+}
+
+bool HTTPClient::begin(const String &url) {
+  if (!url.startsWith("http://")) {
+    return false;
+  }
+  int hostEnd = url.indexOf('/', 7);
+  if (hostEnd < 0) {
+    hostEnd = url.length();
+  }
+  int colon = url.indexOf(':', 7);
+  if (colon >= 0 && colon < hostEnd) {
+    host = url.substring(7, colon);
+    port = url.substring(colon + 1, hostEnd).toInt();
+  } else {
+    host = url.substring(7, hostEnd);
+    port = 80;
+  }
+  path = (hostEnd < (int) url.length()) ? url.substring(hostEnd) : String("/");
+  client = &ownClient;
+  headers = "";
+  contentLength = -1;
+  chunked = false;
+  bufferLength = bufferPos = 0;
+  return true;
+}
+
+void HTTPClient::end() {
+  if (client) {
+    client->stop();
+  }
+  client = NULL;
+}
+
+void HTTPClient::addHeader(const String &name, const String &value) {
+  headers += name + ": " + value + "\r\n";
+}
+
+void HTTPClient::collectHeaders(const char *headerKeys[], const size_t headerKeysCount) {
+  collectCount = std::min(headerKeysCount, (size_t) 4);
+  for (size_t i = 0; i < collectCount; i++) {
+    collectKeys[i] = headerKeys[i];
+    collectValues[i] = "";
+  }
+}
+
+String HTTPClient::header(const char *name) {
+  for (size_t i = 0; i < collectCount; i++) {
+    if (strcasecmp(collectKeys[i], name) == 0) {
+      return collectValues[i];
+    }
+  }
+  return String();
+}
+
+int HTTPClient::readByte() {
+  if (bufferPos >= bufferLength) {
+    int n = client->read(buffer, sizeof(buffer), timeout);
+    if (n <= 0) {
+      timedOut = (n < 0);
+      return -1;
+    }
+    bufferLength = n;
+    bufferPos = 0;
+  }
+  return buffer[bufferPos++];
+}
+
+bool HTTPClient::readLine(String *line) {
+  *line = "";
+  while (true) {
+    int c = readByte();
+    if (c < 0) {
+      return false;
+    }
+    if (c == '\n') {
+      return true;
+    }
+    if (c != '\r') {
+      *line += (char) c;
+    }
+  }
+}
+
+int HTTPClient::sendRequest(const char *method, uint8_t *payload, size_t size) {
+  if (!client) {
+    return HTTPC_ERROR_NOT_CONNECTED;
+  }
+  if (!client->connected() && !client->connect(host.c_str(), port, timeout)) {
+    return HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+
+  String request = String(method) + " " + path + " HTTP/1.1\r\nHost: " + host + "\r\n" +
+                   "User-Agent: ESP32HTTPClient\r\nConnection: close\r\n" +
+                   "Content-Length: " + String((unsigned int) (payload ? size : 0)) + "\r\n" + headers + "\r\n";
+  if (client->write((const uint8_t *) request.c_str(), request.length()) != request.length()) {
+    return HTTPC_ERROR_SEND_HEADER_FAILED;
+  }
+  if (payload && size && client->write(payload, size) != size) {
+    return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+  }
+
+  String line;
+  timedOut = false;
+  if (!readLine(&line)) {
+    return timedOut ? HTTPC_ERROR_READ_TIMEOUT : HTTPC_ERROR_CONNECTION_LOST; // Closed without a response = dropped
+  }
+  int space = line.indexOf(' ');
+  if (!line.startsWith("HTTP/1.") || space < 0) {
+    return HTTPC_ERROR_NO_HTTP_SERVER;
+  }
+  int code = line.substring(space + 1).toInt();
+
+  while (readLine(&line) && line.length() > 0) {
+    int colon = line.indexOf(':');
+    if (colon < 0) {
+      continue;
+    }
+    String name = line.substring(0, colon);
+    int start = colon + 1;
+    while (start < (int) line.length() && line[start] == ' ') {
+      start++;
+    }
+    String value = line.substring(start);
+    for (size_t i = 0; i < collectCount; i++) {
+      if (strcasecmp(name.c_str(), collectKeys[i]) == 0) {
+        collectValues[i] = value;
+      }
+    }
+    if (strcasecmp(name.c_str(), "Content-Length") == 0) {
+      contentLength = value.toInt();
+    } else if (strcasecmp(name.c_str(), "Transfer-Encoding") == 0 && value.indexOf("chunked") >= 0) {
+      chunked = true;
+    }
+  }
+  return code > 0 ? code : HTTPC_ERROR_NO_HTTP_SERVER;
+}
+
+String HTTPClient::getString() {
+  String body;
+  if (!client) {
+    return body;
+  }
+
+  if (chunked) {
+    String line;
+    while (readLine(&line)) {
+      long chunk = strtol(line.c_str(), NULL, 16);
+      if (chunk <= 0) {
+        break;
+      }
+      for (long i = 0; i < chunk; i++) {
+        int c = readByte();
+        if (c < 0) {
+          return body;
+        }
+        body += (char) c;
+      }
+      readLine(&line); // CRLF after the chunk
+    }
+    return body;
+  }
+
+  for (int i = 0; contentLength < 0 || i < contentLength; i++) {
+    int c = readByte();
+    if (c < 0) {
+      break;
+    }
+    body += (char) c;
+  }
+  return body;
+}
+
+String HTTPClient::errorToString(int error) {
+  switch (error) {
+    case HTTPC_ERROR_CONNECTION_REFUSED:  return "connection refused";
+    case HTTPC_ERROR_SEND_HEADER_FAILED:  return "send header failed";
+    case HTTPC_ERROR_SEND_PAYLOAD_FAILED: return "send payload failed";
+    case HTTPC_ERROR_NOT_CONNECTED:       return "not connected";
+    case HTTPC_ERROR_CONNECTION_LOST:     return "connection lost";
+    case HTTPC_ERROR_NO_STREAM:           return "no stream";
+    case HTTPC_ERROR_NO_HTTP_SERVER:      return "no HTTP server";
+    case HTTPC_ERROR_TOO_LESS_RAM:        return "too less ram";
+    case HTTPC_ERROR_ENCODING:            return "Transfer-Encoding not supported";
+    case HTTPC_ERROR_STREAM_WRITE:        return "Stream write error";
+    case HTTPC_ERROR_READ_TIMEOUT:        return "read Timeout";
+    default:                              return String();
+  }
+}
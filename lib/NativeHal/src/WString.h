@@ -0,0 +1,55 @@
+#pragma once
+
+// Native (host) build only, the part of Arduino String the shared sources use
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+class String {
+public:
+  String() { }
+  String(const char *text) : value(text ? text : "") { }
+  String(const std::string &text) : value(text) { }
+  explicit String(int number) : value(std::to_string(number)) { }
+  explicit String(unsigned int number) : value(std::to_string(number)) { }
+  explicit String(long number) : value(std::to_string(number)) { }
+  explicit String(unsigned long number) : value(std::to_string(number)) { }
+
+  const char *c_str() const { return value.c_str(); }
+  unsigned int length() const { return value.length(); }
+  char operator[](unsigned int index) const { return index < value.length() ? value[index] : 0; }
+
+  int indexOf(char c, unsigned int from = 0) const { return find(value.find(c, from)); }
+  int indexOf(const char *text, unsigned int from = 0) const { return find(value.find(text, from)); }
+  int indexOf(const String &text, unsigned int from = 0) const { return find(value.find(text.value, from)); }
+  bool startsWith(const char *prefix) const { return value.compare(0, strlen(prefix), prefix) == 0; }
+  bool endsWith(const char *suffix) const {
+    size_t n = strlen(suffix);
+    return value.length() >= n && value.compare(value.length() - n, n, suffix) == 0;
+  }
+  String substring(unsigned int from) const { return from < value.length() ? String(value.substr(from)) : String(); }
+  String substring(unsigned int from, unsigned int to) const {
+    return (from < to && from < value.length()) ? String(value.substr(from, to - from)) : String();
+  }
+  long toInt() const { return atol(value.c_str()); }
+  bool reserve(unsigned int size) { value.reserve(size); return true; }
+
+  String &operator+=(const String &text) { value += text.value; return *this; }
+  String &operator+=(const char *text) { value += text; return *this; }
+  String &operator+=(char c) { value += c; return *this; }
+  bool concat(const char *text, unsigned int length) { value.append(text, length); return true; }
+
+  bool operator==(const String &other) const { return value == other.value; }
+  bool operator==(const char *other) const { return value == other; }
+  bool operator!=(const String &other) const { return value != other.value; }
+  bool operator!=(const char *other) const { return value != other; }
+
+  friend String operator+(const String &a, const String &b) { return String(a.value + b.value); }
+  friend String operator+(const String &a, const char *b) { return String(a.value + b); }
+
+private:
+  static int find(size_t position) { return position == std::string::npos ? -1 : (int) position; }
+
+  std::string value;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+// Native (host) build only, the host network is always "connected"
+
+#include "Arduino.h"
+#include "IPAddress.h"
+#include "WiFiClient.h"
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_CONNECTED = 3,
+  WL_DISCONNECTED = 6,
+} wl_status_t;
+
+class NativeWiFi {
+public:
+  wl_status_t status() { return WL_CONNECTED; }
+  bool isConnected() { return true; }
+  int8_t RSSI() { return -55; }
+  int hostByName(const char *host, IPAddress &ip); // getaddrinfo, 1 = ok
+};
+extern NativeWiFi WiFi;
@@ -0,0 +1,24 @@
+#pragma once
+
+// Native (host) build only, blocking POSIX TCP socket with the WiFiClient calls HttpTransport use
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+class WiFiClient {
+public:
+  WiFiClient() { }
+  ~WiFiClient() { stop(); }
+  WiFiClient(const WiFiClient &) = delete;
+  WiFiClient &operator=(const WiFiClient &) = delete;
+
+  int connect(IPAddress ip, uint16_t port, int32_t timeout); // timeout ms, 1 = ok
+  int connect(const char *host, uint16_t port, int32_t timeout);
+  size_t write(const uint8_t *buffer, size_t size);
+  int read(uint8_t *buffer, size_t size, uint32_t timeout); // Wait up to timeout ms, 0 = closed, -1 = timeout / error
+  uint8_t connected() { return fd >= 0; }
+  void stop();
+
+private:
+  int fd = -1;
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdio.h>
+
+// Native (host) build only, ESP_LOGx to stderr so stdout stay clean for tool output
+#ifndef NATIVE_LOG_LEVEL
+#define NATIVE_LOG_LEVEL 3 // 1 error .. 5 verbose
+#endif
+
+#define NATIVE_LOG(level, letter, tag, format, ...) \
+    do { if ((level) <= NATIVE_LOG_LEVEL) fprintf(stderr, letter " (%s) " format "\n", tag, ##__VA_ARGS__); } while (0)
+
+#define ESP_LOGE(tag, format, ...) NATIVE_LOG(1, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) NATIVE_LOG(2, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) NATIVE_LOG(3, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) NATIVE_LOG(4, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) NATIVE_LOG(5, "V", tag, format, ##__VA_ARGS__)
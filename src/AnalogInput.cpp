@@ -0,0 +1,177 @@
+#include <Arduino.h>
+#include "AnalogInput.h"
+#include "PinConfigs.h"
+#include "SystemHealth.h"
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+
+static const char * TAG = "AnalogInput";
+
+#define ANALOG_INPUT_COUNT (sizeof(a_pin) / sizeof(a_pin[0]))
+
+typedef struct {
+  int8_t channel;   // ADC1 channel, -1 = pin not on ADC1
+  uint32_t sum;     // Accumulate in the current window
+  uint32_t count;
+  uint16_t average; // Last window result
+  uint32_t samples;
+  uint32_t timestamp;
+} AnalogChannel;
+
+static AnalogChannel channels[ANALOG_INPUT_COUNT];
+static esp_adc_cal_characteristics_t adcChars;
+static portMUX_TYPE channelsMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t analogTaskHandle = NULL;
+static bool running = false;
+
+static int AnalogInput_indexOf(int pin) {
+  for (int i = 0; i < ANALOG_INPUT_COUNT; i++) {
+    if (a_pin[i] == pin) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static void AnalogInput_task(void *) {
+  static uint8_t frame[ANALOG_FRAME_SIZE];
+  uint32_t windowStart = millis();
+
+  while (1) {
+    uint32_t length = 0;
+    esp_err_t err = adc_digi_read_bytes(frame, sizeof(frame), &length, ADC_MAX_DELAY); // Block until DMA frame done
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) { // INVALID_STATE = pool overflow, data still usable
+      ESP_LOGW(TAG, "ADC read error %d", err);
+      continue;
+    }
+
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length; i += SOC_ADC_DIGI_RESULT_BYTES) {
+      adc_digi_output_data_t *result = (adc_digi_output_data_t *) &frame[i];
+      for (int n = 0; n < ANALOG_INPUT_COUNT; n++) {
+        if (channels[n].channel == result->type2.channel) {
+          channels[n].sum += result->type2.data;
+          channels[n].count++;
+          break;
+        }
+      }
+    }
+
+    if ((millis() - windowStart) < ANALOG_OVERSAMPLE_WINDOW) {
+      continue;
+    }
+    windowStart = millis();
+
+    portENTER_CRITICAL(&channelsMux);
+    for (int n = 0; n < ANALOG_INPUT_COUNT; n++) {
+      if (channels[n].count > 0) {
+        channels[n].average = channels[n].sum / channels[n].count;
+        channels[n].samples = channels[n].count;
+        channels[n].timestamp = windowStart;
+      }
+      channels[n].sum = 0;
+      channels[n].count = 0;
+    }
+    portEXIT_CRITICAL(&channelsMux);
+  }
+}
+
+bool AnalogInput_init() {
+  if (running) {
+    return true;
+  }
+
+  uint16_t channelMask = 0;
+  adc_digi_pattern_config_t pattern[ANALOG_INPUT_COUNT];
+  int patternCount = 0;
+  memset(channels, 0, sizeof(channels));
+  for (int i = 0; i < ANALOG_INPUT_COUNT; i++) {
+    int ch = digitalPinToAnalogChannel(a_pin[i]);
+    if ((ch < 0) || (ch >= SOC_ADC_CHANNEL_NUM(0))) { // Continuous mode use ADC1 only
+      ESP_LOGE(TAG, "Pin %d is not on ADC1", a_pin[i]);
+      channels[i].channel = -1;
+      continue;
+    }
+    channels[i].channel = ch;
+    channelMask |= BIT(ch);
+
+    pattern[patternCount].atten = ADC_ATTEN_DB_11; // 0 - 3.1 V
+    pattern[patternCount].channel = ch;
+    pattern[patternCount].unit = 0; // ADC1
+    pattern[patternCount].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    patternCount++;
+  }
+  if (patternCount == 0) {
+    return false;
+  }
+
+  adc_digi_init_config_t initConfig = {
+    .max_store_buf_size = ANALOG_FRAME_SIZE * 4,
+    .conv_num_each_intr = ANALOG_FRAME_SIZE,
+    .adc1_chan_mask = channelMask,
+    .adc2_chan_mask = 0,
+  };
+  if (adc_digi_initialize(&initConfig) != ESP_OK) {
+    ESP_LOGE(TAG, "ADC DMA init fail");
+    return false;
+  }
+
+  adc_digi_configuration_t digiConfig = {
+    .conv_limit_en = false,
+    .conv_limit_num = 250,
+    .pattern_num = (uint32_t) patternCount,
+    .adc_pattern = pattern,
+    .sample_freq_hz = ANALOG_SAMPLE_FREQ,
+    .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+    .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+  };
+  if (adc_digi_controller_configure(&digiConfig) != ESP_OK) {
+    ESP_LOGE(TAG, "ADC DMA config fail");
+    adc_digi_deinitialize();
+    return false;
+  }
+
+  esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 1100, &adcChars);
+
+  xTaskCreatePinnedToCore(AnalogInput_task, "AnalogTask", ANALOG_TASK_STACK_SIZE, NULL, ANALOG_TASK_PRIORITY, &analogTaskHandle, ANALOG_TASK_CORE);
+  SystemHealth::registerTask(analogTaskHandle, "AnalogTask", ANALOG_TASK_STACK_SIZE);
+  adc_digi_start();
+  running = true;
+
+  ESP_LOGI(TAG, "ADC continuous mode %d Hz, %d channel(s)", ANALOG_SAMPLE_FREQ, patternCount);
+  return true;
+}
+
+bool AnalogInput_isRunning() {
+  return running;
+}
+
+bool AnalogInput_getRaw(int pin, uint16_t *raw) {
+  int i = AnalogInput_indexOf(pin);
+  if ((!running) || (i < 0) || (!raw)) {
+    return false;
+  }
+
+  portENTER_CRITICAL(&channelsMux);
+  bool ready = channels[i].samples > 0;
+  *raw = channels[i].average;
+  portEXIT_CRITICAL(&channelsMux);
+
+  return ready;
+}
+
+bool AnalogInput_getMilliVolts(int pin, uint32_t *mv) {
+  uint16_t raw;
+  if ((!mv) || (!AnalogInput_getRaw(pin, &raw))) {
+    return false;
+  }
+  *mv = esp_adc_cal_raw_to_voltage(raw, &adcChars);
+  return true;
+}
+
+uint32_t AnalogInput_getSampleCount(int pin) {
+  int i = AnalogInput_indexOf(pin);
+  if (i < 0) {
+    return 0;
+  }
+  return channels[i].samples;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ===================================================================
+// Analog input (A1, A2) in ADC continuous mode
+// ADC1 DMA run in the background, a task average every conversion over
+// ANALOG_OVERSAMPLE_WINDOW ms so the last value can be read at any time.
+// ===================================================================
+
+#define ANALOG_SAMPLE_FREQ        5000  // Hz, all channel together
+#define ANALOG_FRAME_SIZE         256   // byte per DMA frame
+#define ANALOG_OVERSAMPLE_WINDOW  200   // ms, average window
+#define ANALOG_TASK_STACK_SIZE    3072
+#define ANALOG_TASK_PRIORITY      4
+#define ANALOG_TASK_CORE          0
+
+bool AnalogInput_init() ; // Start continuous mode on every pin in a_pin[]
+bool AnalogInput_isRunning() ;
+bool AnalogInput_getRaw(int pin, uint16_t *raw) ; // Oversampled value, same 12 bit scale as analogRead()
+bool AnalogInput_getMilliVolts(int pin, uint32_t *mv) ; // Calibrated with eFuse data
+uint32_t AnalogInput_getSampleCount(int pin) ; // Conversions in the last window
@@ -1,6 +1,9 @@
 #include "ApiClient.h"
 #include <WiFi.h>
 #include <time.h>
+#include "TimeService.h"
+#include "HttpTransport.h"
+#include "SystemHealth.h"
 
 static const char* TAG = "ApiClient";
 
@@ -9,6 +12,10 @@ void ApiClient::init() {
     ESP_LOGI(TAG, "DotNet Base URL: %s", DOTNET_BASE_URL);
     ESP_LOGI(TAG, "Available endpoints:");
     ESP_LOGI(TAG, "  - Telemetry: %s", ENDPOINT_TELEMETRY);
+#if TELEMETRY_MQTT_ENABLE
+    ESP_LOGI(TAG, "Telemetry over MQTT %s (MessagePack schema %d), HTTP as fallback",
+             TELEMETRY_MQTT_TOPIC, TELEMETRY_SCHEMA_VERSION);
+#endif
     // Log endpoints อื่นๆ เมื่อเพิ่มในอนาคต
 }
 
@@ -34,13 +41,18 @@ bool ApiClient::sendTelemetryToDotNetAPI(
     bool success = false;
 
     // Build JSON payload
-    String payload = buildDotNetPayload(temp_c, hum_rh, hum_dirt, light_lux, water_delta_l, energy_delta_kwh);
+    char payload[API_PAYLOAD_SIZE];
+    if (!buildDotNetPayload(temp_c, hum_rh, hum_dirt, light_lux, water_delta_l, energy_delta_kwh,
+                            payload, sizeof(payload))) {
+        ESP_LOGE(TAG, "Telemetry payload too large");
+        return false;
+    }
 
     ESP_LOGD(TAG, "Sending telemetry to DotNet API...");
-    ESP_LOGV(TAG, "Payload: %s", payload.c_str());
+    ESP_LOGV(TAG, "Payload: %s", payload);
 
     // Use helper function to send to telemetry endpoint
-    return sendToDotNetEndpoint(ENDPOINT_TELEMETRY, payload.c_str());
+    return sendToDotNetEndpoint(ENDPOINT_TELEMETRY, payload);
 }
 
 bool ApiClient::sendToCustomAPI(
@@ -53,42 +65,65 @@ bool ApiClient::sendToCustomAPI(
         return false;
     }
 
-    HTTPClient http;
     bool success = false;
 
     ESP_LOGD(TAG, "Sending to Custom API: %s", url);
     ESP_LOGV(TAG, "Payload: %s", jsonPayload);
 
-    http.begin(url);
-    http.setTimeout(DOTNET_API_TIMEOUT);
-    http.addHeader("Content-Type", "application/json");
-    
-    if (apiKey != nullptr && strlen(apiKey) > 0) {
-        http.addHeader("X-API-KEY", apiKey);
-    }
-
-    int httpCode = http.POST(jsonPayload);
+    String response;
+    int httpCode = HttpTransport::request("POST", url, apiKey, jsonPayload, &response, DOTNET_API_TIMEOUT);
 
     if (httpCode > 0) {
         ESP_LOGI(TAG, "HTTP Response code: %d", httpCode);
         
         if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_CREATED || httpCode == HTTP_CODE_ACCEPTED) {
-            String response = http.getString();
             ESP_LOGD(TAG, "Response: %s", response.c_str());
             success = true;
         } else {
-            String response = http.getString();
             ESP_LOGW(TAG, "HTTP Error: %d, Response: %s", httpCode, response.c_str());
         }
     } else {
-        ESP_LOGE(TAG, "HTTP Error: %s", http.errorToString(httpCode).c_str());
+        ESP_LOGE(TAG, "HTTP Error: %s", HTTPClient::errorToString(httpCode).c_str());
     }
 
-    http.end();
     return success;
 }
 
-String ApiClient::buildDotNetPayload(
+size_t ApiClient::buildDotNetPayload(
+    float temp_c,
+    float hum_rh,
+    float hum_dirt,
+    float light_lux,
+    float water_delta_l,
+    float energy_delta_kwh,
+    char* output,
+    size_t size
+) {
+    String timestamp = getCurrentTimestamp();
+
+    TelemetryPayload data;
+    fillTelemetry(&data, temp_c, hum_rh, hum_dirt, light_lux, water_delta_l, energy_delta_kwh);
+    data.ts = timestamp.c_str();
+    return ApiPayload::buildTelemetry(&data, output, size);
+}
+
+size_t ApiClient::buildTelemetryBinary(
+    float temp_c,
+    float hum_rh,
+    float hum_dirt,
+    float light_lux,
+    float water_delta_l,
+    float energy_delta_kwh,
+    uint8_t* output,
+    size_t size
+) {
+    TelemetryPayload data;
+    fillTelemetry(&data, temp_c, hum_rh, hum_dirt, light_lux, water_delta_l, energy_delta_kwh);
+    return ApiPayload::buildTelemetryMsgPack(&data, output, size);
+}
+
+void ApiClient::fillTelemetry(
+    TelemetryPayload* data,
     float temp_c,
     float hum_rh,
     float hum_dirt,
@@ -96,33 +131,31 @@ String ApiClient::buildDotNetPayload(
     float water_delta_l,
     float energy_delta_kwh
 ) {
-    // Create JSON document
-    const size_t capacity = JSON_OBJECT_SIZE(12) + 220;
-    DynamicJsonDocument doc(capacity);
-
-    doc["id"] = 0;
-    doc["site_id"] = SITE_ID;
-    doc["room_id"] = ROOM_ID;
-    doc["ts"] = getCurrentTimestamp();
-    doc["temp_c"] = round(temp_c * 10) / 10.0;  // Round to 1 decimal
-    doc["hum_rh"] = round(hum_rh * 10) / 10.0;  // Round to 1 decimal
-    doc["hum_dirt"] = round(hum_dirt * 10) / 10.0;  // Round to 1 decimal
-    doc["light_lux"] = round(light_lux * 100) / 100.0;  // Round to 2 decimals
-    doc["water_delta_l"] = water_delta_l;
-    doc["energy_delta_kwh"] = energy_delta_kwh;
-    doc["rssi"] = getWiFiRSSI();
-    doc["device"] = DEVICE_NAME;
-
-    String output;
-    serializeJson(doc, output);
-    return output;
+    data->temp_c = temp_c;
+    data->hum_rh = hum_rh;
+    data->hum_dirt = hum_dirt;
+    data->light_lux = light_lux;
+    data->water_delta_l = water_delta_l;
+    data->energy_delta_kwh = energy_delta_kwh;
+    data->ts = NULL;
+    data->ts_unix = (uint32_t) TimeService::now();
+    data->rssi = getWiFiRSSI();
+
+    HeapStats heap;
+    SystemHealth::getInternalHeap(&heap);
+    data->heap_free = heap.free;
+    data->heap_min = heap.min_free;
+    data->heap_block = heap.largest_block;
+    SystemHealth::getPsramHeap(&heap);
+    data->psram_free = heap.free;
+    data->stack_min = SystemHealth::getMinStackFree();
 }
 
 String ApiClient::getCurrentTimestamp() {
     struct tm timeinfo;
     char buffer[30];
     
-    if (!getLocalTime(&timeinfo)) {
+    if (!TimeService::getLocalTime(&timeinfo)) {
         ESP_LOGW(TAG, "Failed to obtain time, using epoch");
         return "1970-01-01T00:00:00.000Z";
     }
@@ -152,7 +185,6 @@ bool ApiClient::sendToDotNetEndpoint(
         return false;
     }
 
-    HTTPClient http;
     bool success = false;
 
     // Build full URL
@@ -161,29 +193,22 @@ bool ApiClient::sendToDotNetEndpoint(
     ESP_LOGD(TAG, "Sending to: %s", fullUrl.c_str());
     ESP_LOGV(TAG, "Payload: %s", jsonPayload);
 
-    http.begin(fullUrl);
-    http.setTimeout(DOTNET_API_TIMEOUT);
-    http.addHeader("Content-Type", "application/json");
-    http.addHeader("X-API-KEY", DOTNET_API_KEY);
-
-    int httpCode = http.POST(jsonPayload);
+    String response;
+    int httpCode = HttpTransport::request("POST", fullUrl, DOTNET_API_KEY, jsonPayload, &response, DOTNET_API_TIMEOUT);
 
     if (httpCode > 0) {
         ESP_LOGI(TAG, "HTTP Response code: %d", httpCode);
         
         if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_CREATED || httpCode == HTTP_CODE_ACCEPTED) {
-            String response = http.getString();
             ESP_LOGD(TAG, "Response: %s", response.c_str());
             success = true;
         } else {
-            String response = http.getString();
             ESP_LOGW(TAG, "HTTP Error: %d, Response: %s", httpCode, response.c_str());
         }
     } else {
-        ESP_LOGE(TAG, "HTTP Error: %s", http.errorToString(httpCode).c_str());
+        ESP_LOGE(TAG, "HTTP Error: %s", HTTPClient::errorToString(httpCode).c_str());
     }
 
-    http.end();
     return success;
 }
 
@@ -3,13 +3,25 @@
 #include <Arduino.h>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
+#include "ApiPayload.h"
 
 // API Configuration
 #define API_ENABLE_DOTNET       1  // Enable/Disable .NET API
 #define API_ENABLE_NETPIE       1  // Enable/Disable NETPIE MQTT
 
-// .NET API Settings
+// Telemetry over the NETPIE MQTT session (MessagePack, schema in ApiPayload.h),
+// POST ENDPOINT_TELEMETRY only when MQTT is down or the publish fail.
+// Off until the server side subscribe TELEMETRY_MQTT_TOPIC, nothing store
+// those messages yet and the publish succeed, so data would be lost.
+#ifndef TELEMETRY_MQTT_ENABLE
+#define TELEMETRY_MQTT_ENABLE   0
+#endif
+#define TELEMETRY_MQTT_TOPIC    "@msg/telemetry"
+
+// .NET API Settings, base URL can be set from build_flags (e.g. tools/mock_api_server.py)
+#ifndef DOTNET_BASE_URL
 #define DOTNET_BASE_URL         "http://203.159.93.240/minapi/v1"
+#endif
 #define DOTNET_API_KEY          "DD5B523CF73EF3386DB2DE4A7AEDD"
 #define DOTNET_API_TIMEOUT      5000  // 5 seconds
 
@@ -21,12 +33,6 @@
 // #define ENDPOINT_ALERTS         "/api/alerts"
 // #define ENDPOINT_CONTROL        "/api/control"
 
-// Device Configuration
-#define SITE_ID                 "site1"
-#define ROOM_ID                 "roomA"
-#define DEVICE_NAME             "ESP32"
-#define USER_ID                 "2"      // User ID สำหรับ Automation API
-
 class ApiClient {
 public:
     static void init();
@@ -38,6 +44,20 @@ public:
         float water_delta_l = 0.0,
         float energy_delta_kwh = 0.0
     );
+
+
+    // Same sample as sendTelemetryToDotNetAPI, MessagePack for TELEMETRY_MQTT_TOPIC
+    // (output of TELEMETRY_BINARY_SIZE), 0 if it does not fit
+    static size_t buildTelemetryBinary(
+        float temp_c,
+        float hum_rh,
+        float hum_dirt,
+        float light_lux,
+        float water_delta_l,
+        float energy_delta_kwh,
+        uint8_t* output,
+        size_t size
+    );
     
     // สำหรับขยาย API อื่นๆ ในอนาคต
     static bool sendToCustomAPI(
@@ -53,7 +73,18 @@ public:
     );
 
 private:
-    static String buildDotNetPayload(
+    static size_t buildDotNetPayload(
+        float temp_c,
+        float hum_rh,
+        float hum_dirt,
+        float light_lux,
+        float water_delta_l,
+        float energy_delta_kwh,
+        char* output,
+        size_t size
+    );
+    static void fillTelemetry(
+        TelemetryPayload* data,
         float temp_c,
         float hum_rh,
         float hum_dirt,
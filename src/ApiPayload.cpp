@@ -0,0 +1,385 @@
+#include "ApiPayload.h"
+#include <math.h>
+#include <string.h>
+#include <esp_log.h>
+
+static const char* TAG = "ApiPayload";
+
+size_t ApiPayload::serialize(const JsonDocument& doc, char* output, size_t size) {
+    if (doc.overflowed()) {
+        return 0;
+    }
+    size_t length = serializeJson(doc, output, size);
+    if (length + 1 >= size) { // Truncated (or exactly full, keep room to tell them apart)
+        output[0] = '\0';
+        return 0;
+    }
+    return length;
+}
+
+size_t ApiPayload::buildTelemetry(const TelemetryPayload* data, char* output, size_t size) {
+    const size_t capacity = JSON_OBJECT_SIZE(17) + 220;
+    DynamicJsonDocument doc(capacity);
+
+    doc["id"] = 0;
+    doc["site_id"] = SITE_ID;
+    doc["room_id"] = ROOM_ID;
+    doc["ts"] = data->ts;
+    doc["temp_c"] = round(data->temp_c * 10) / 10.0;       // Round to 1 decimal
+    doc["hum_rh"] = round(data->hum_rh * 10) / 10.0;       // Round to 1 decimal
+    doc["hum_dirt"] = round(data->hum_dirt * 10) / 10.0;   // Round to 1 decimal
+    doc["light_lux"] = round(data->light_lux * 100) / 100.0; // Round to 2 decimals
+    doc["water_delta_l"] = data->water_delta_l;
+    doc["energy_delta_kwh"] = data->energy_delta_kwh;
+    doc["rssi"] = data->rssi;
+    doc["device"] = DEVICE_NAME;
+
+    // Memory headroom (bytes), detail per task is on SYSTEM_HEALTH_MQTT_TOPIC
+    doc["heap_free"] = data->heap_free;
+    doc["heap_min"] = data->heap_min;
+    doc["heap_block"] = data->heap_block;
+    doc["psram_free"] = data->psram_free;
+    doc["stack_min"] = data->stack_min;
+
+    return serialize(doc, output, size);
+}
+
+size_t ApiPayload::buildTelemetryMsgPack(const TelemetryPayload* data, uint8_t* output, size_t size) {
+    StaticJsonDocument<JSON_ARRAY_SIZE(TELEMETRY_SCHEMA_FIELDS)> doc;
+    JsonArray fields = doc.to<JsonArray>();
+
+    fields.add(TELEMETRY_SCHEMA_VERSION);
+    fields.add(data->ts_unix);
+    fields.add((int32_t) lround(data->temp_c * 10));
+    fields.add((int32_t) lround(data->hum_rh * 10));
+    fields.add((int32_t) lround(data->hum_dirt * 10));
+    fields.add((int32_t) lround(data->light_lux * 100));
+    fields.add((int32_t) lround(data->water_delta_l * 1000));
+    fields.add((int32_t) lround(data->energy_delta_kwh * 10000));
+    fields.add(data->rssi);
+    fields.add(data->heap_free);
+    fields.add(data->heap_min);
+    fields.add(data->heap_block);
+    fields.add(data->psram_free);
+    fields.add(data->stack_min);
+
+    if (doc.overflowed() || measureMsgPack(doc) > size) {
+        return 0;
+    }
+    return serializeMsgPack(doc, output, size);
+}
+
+size_t ApiPayload::buildRelayTrigger(bool turn_on, const char* control_mode, const char* trigger_type,
+                                     int timer_id, float trigger_value, float threshold_value,
+                                     const char* message, char* output, size_t size) {
+    const size_t capacity = JSON_OBJECT_SIZE(15) + 512;
+    DynamicJsonDocument doc(capacity);
+
+    doc["userId"] = USER_ID;
+    doc["siteId"] = SITE_ID;
+    doc["roomId"] = ROOM_ID;
+    doc["action"] = turn_on ? "turn_on" : "turn_off";
+    doc["controlMode"] = control_mode;
+    doc["triggerType"] = trigger_type;
+    doc["source"] = "esp32";
+
+    if (timer_id >= 0) {
+        doc["timerId"] = timer_id;
+    }
+
+    if (trigger_value != 0.0f) {
+        doc["triggerValue"] = trigger_value;
+    }
+
+    if (threshold_value != 0.0f) {
+        doc["thresholdValue"] = threshold_value;
+    }
+
+    if (message) {
+        doc["message"] = message;
+    }
+
+    return serialize(doc, output, size);
+}
+
+size_t ApiPayload::buildStatus(int relay_id, bool current_state, const char* control_mode,
+                               bool timer_active, bool sensor_active, const char* trigger_type,
+                               char* output, size_t size) {
+    const size_t capacity = JSON_OBJECT_SIZE(12) + 256;
+    DynamicJsonDocument doc(capacity);
+
+    doc["userId"] = USER_ID;
+    doc["siteId"] = SITE_ID;
+    doc["roomId"] = ROOM_ID;
+    doc["relayId"] = relay_id;
+    doc["currentState"] = current_state;
+    doc["controlMode"] = control_mode;
+    doc["timerActive"] = timer_active;
+    doc["sensorActive"] = sensor_active;
+
+    if (trigger_type) {
+        doc["triggerType"] = trigger_type;
+    }
+
+    return serialize(doc, output, size);
+}
+
+size_t ApiPayload::buildLogEvent(int relay_id, const char* event_type, const char* event_source,
+                                 bool old_state, bool new_state, int timer_id, float trigger_value,
+                                 const char* message, char* output, size_t size) {
+    const size_t capacity = JSON_OBJECT_SIZE(15) + 512;
+    DynamicJsonDocument doc(capacity);
+
+    doc["userId"] = USER_ID;
+    doc["siteId"] = SITE_ID;
+    doc["roomId"] = ROOM_ID;
+    doc["relayId"] = relay_id;
+    doc["eventType"] = event_type;
+    doc["eventSource"] = event_source;
+    doc["oldState"] = old_state;
+    doc["newState"] = new_state;
+
+    if (timer_id >= 0) {
+        doc["timerId"] = timer_id;
+    }
+
+    if (trigger_value != 0.0f) {
+        doc["triggerValue"] = trigger_value;
+    }
+
+    if (message) {
+        doc["message"] = message;
+    }
+
+    return serialize(doc, output, size);
+}
+
+size_t ApiPayload::buildSwitchState(int id, int state, uint32_t version, const char* origin,
+                                    char* output, size_t size) {
+    StaticJsonDocument<JSON_OBJECT_SIZE(4)> doc;
+    doc["id"] = id;
+    doc["state"] = (state == 1) ? "on" : "off";
+    if (version) {
+        doc["version"] = version;
+    }
+    if (origin) {
+        doc["origin"] = origin;
+    }
+    return serialize(doc, output, size);
+}
+
+bool ApiPayload::parseSwitchStates(const char* json, size_t length, int* states, uint32_t* versions, int count) {
+    DynamicJsonDocument doc(1536); // 4 x {id, name, state, version, origin, updatedAt}
+    DeserializationError error = deserializeJson(doc, json, length);
+    if (error) {
+        ESP_LOGE(TAG, "JSON parsing failed: %s", error.c_str());
+        return false;
+    }
+
+    if (!(doc["success"] | false) || !doc["data"].is<JsonArray>()) {
+        ESP_LOGW(TAG, "API returned success=false or invalid data");
+        return false;
+    }
+
+    for (JsonObject item : doc["data"].as<JsonArray>()) {
+        int id = item["id"] | 0;
+        const char* state = item["state"] | "";
+        if (id >= 1 && id <= count) {
+            states[id - 1] = stateFromString(state);
+            if (versions) {
+                versions[id - 1] = item["version"] | 0u;
+            }
+            ESP_LOGD(TAG, "Switch %d: %s v%lu (%s)", id, state, (unsigned long)(item["version"] | 0u),
+                     item["origin"] | "-");
+        }
+    }
+    return true;
+}
+
+bool ApiPayload::parseSwitchState(const char* json, size_t length, int* state) {
+    DynamicJsonDocument doc(512);
+    DeserializationError error = deserializeJson(doc, json, length);
+    if (error) {
+        ESP_LOGE(TAG, "JSON parsing failed: %s", error.c_str());
+        return false;
+    }
+
+    if (!(doc["success"] | false)) {
+        return false;
+    }
+    *state = stateFromString(doc["data"]["state"] | "");
+    return true;
+}
+
+bool ApiPayload::parseAutomationSync(const char* json, size_t length, AutomationSyncData* data) {
+    data->timer_count = 0;
+    data->sensor_count = 0;
+    data->sync_token[0] = '\0';
+    for (int i = 0; i < POLL_COUNT; i++) {
+        data->intervals[i] = -1;
+    }
+
+    // Room for max timers / sensors with a few extra fields each. JSON_*_SIZE follow the
+    // pointer size, so a response that fit on the ESP32 also fit on the host.
+    const size_t capacity = JSON_OBJECT_SIZE(3) + JSON_OBJECT_SIZE(5) + JSON_OBJECT_SIZE(POLL_COUNT) +
+                            JSON_ARRAY_SIZE(data->max_timers) +
+                            data->max_timers * (JSON_OBJECT_SIZE(10) + JSON_ARRAY_SIZE(7)) +
+                            JSON_ARRAY_SIZE(data->max_sensors) +
+                            data->max_sensors * JSON_OBJECT_SIZE(12) +
+                            1536; // Strings
+    DynamicJsonDocument doc(capacity);
+
+    DeserializationError error = deserializeJson(doc, json, length);
+    if (error) {
+        ESP_LOGE(TAG, "JSON parse error: %s", error.c_str());
+        return false;
+    }
+
+    if (!doc["success"].as<bool>()) {
+        ESP_LOGW(TAG, "Sync failed: %s", doc["error"]["message"] | "unknown");
+        return false;
+    }
+
+    const char* token = doc["data"]["syncToken"];
+    if (token) {
+        strncpy(data->sync_token, token, sizeof(data->sync_token) - 1);
+        data->sync_token[sizeof(data->sync_token) - 1] = '\0';
+    }
+
+    // "intervals": {"switchPoll": 5, "sync": 60, ...} seconds, 0 = device default
+    JsonObject intervals = doc["data"]["intervals"];
+    if (!intervals.isNull()) {
+        for (int i = 0; i < POLL_COUNT; i++) {
+            JsonVariant value = intervals[intervalKey((PollInterval)i)];
+            if (value.is<int>() && value.as<int>() >= 0) {
+                data->intervals[i] = value.as<int>();
+            }
+        }
+    }
+
+    for (JsonObject timer : doc["data"]["timers"].as<JsonArray>()) {
+        if (data->timer_count >= data->max_timers) {
+            break;
+        }
+
+        AutomationTimer& t = data->timers[data->timer_count];
+        memset(&t, 0, sizeof(t));
+        // Use API-provided relayId as-is (API/web UI uses 0-based relay IDs)
+        t.relay_id = timer["relayId"];
+        t.timer_id = timer["timerId"];
+        t.enabled = timer["enabled"];
+
+        JsonArray days = timer["days"].as<JsonArray>();
+        for (int i = 0; i < 7 && i < (int)days.size(); i++) {
+            t.days[i] = days[i].as<int>() == 1;
+        }
+
+        t.time_on = AutomationSchedule::timeStringToMinutes(timer["timeOn"].as<const char *>());
+        t.time_off = AutomationSchedule::timeStringToMinutes(timer["timeOff"].as<const char *>());
+
+        data->timer_count++;
+    }
+
+    if (!data->sensors) {
+        return true;
+    }
+
+    for (JsonObject sensor : doc["data"]["sensors"].as<JsonArray>()) {
+        if (data->sensor_count >= data->max_sensors) {
+            break;
+        }
+
+        AutomationSensor& s = data->sensors[data->sensor_count];
+        s.relay_id = sensor["relayId"];
+        strncpy(s.sensor_type, sensor["sensorType"] | "", sizeof(s.sensor_type) - 1);
+        s.sensor_type[sizeof(s.sensor_type) - 1] = '\0';
+        s.enabled = sensor["enabled"];
+        s.min_value = sensor["minValue"];
+        s.max_value = sensor["maxValue"];
+        strncpy(s.control_mode, sensor["controlMode"] | "", sizeof(s.control_mode) - 1);
+        s.control_mode[sizeof(s.control_mode) - 1] = '\0';
+        const char* action = sensor["actionOnTrigger"];
+        if (action) {
+            normalizeAction(action, s.action, sizeof(s.action));
+        }
+        else
+            s.action[0] = '\0'; // Follow the threshold, see AutomationEngine::decideSensor
+        s.hysteresis = sensor["hysteresis"] | 2.0f;
+
+        data->sensor_count++;
+    }
+    return true;
+}
+
+const char* ApiPayload::intervalKey(PollInterval interval) {
+    switch (interval) {
+    case POLL_SWITCH:
+        return "switchPoll";
+    case POLL_AUTOMATION_SYNC:
+        return "sync";
+    case POLL_TELEMETRY:
+        return "telemetry";
+    case POLL_TIMER_CHECK:
+        return "timerCheck";
+    case POLL_SENSOR_CHECK:
+        return "sensorCheck";
+    default:
+        return "";
+    }
+}
+
+int ApiPayload::stateFromString(const char* state) {
+    return (state && strcmp(state, "on") == 0) ? 1 : 0;
+}
+
+bool ApiPayload::parseSeconds(const char* text, uint32_t* seconds) {
+    if (!text) {
+        return false;
+    }
+    while (*text == ' ' || *text == '\t') {
+        text++;
+    }
+    uint64_t value = 0;
+    const char* digits = text;
+    while (*text >= '0' && *text <= '9') {
+        value = value * 10 + (*text - '0');
+        if (value > UINT32_MAX) {
+            return false;
+        }
+        text++;
+    }
+    while (*text == ' ' || *text == '\t') {
+        text++;
+    }
+    if (text == digits || *text != '\0' || value == 0) {
+        return false;
+    }
+    *seconds = (uint32_t)value;
+    return true;
+}
+
+void ApiPayload::normalizeAction(const char* src, char* dst, size_t dstSize) {
+    if (!dst || dstSize == 0) {
+        return;
+    }
+    if (!src || !*src) {
+        strncpy(dst, "turn_on", dstSize - 1);
+        dst[dstSize - 1] = '\0';
+        return;
+    }
+    strncpy(dst, src, dstSize - 1);
+    dst[dstSize - 1] = '\0';
+    for (char* p = dst; *p; ++p) {
+        if (*p >= 'A' && *p <= 'Z') {
+            *p = *p - 'A' + 'a';
+        } else if (*p == '-' || *p == ' ') {
+            *p = '_';
+        }
+    }
+    if (strcmp(dst, "on") == 0 || strcmp(dst, "turnon") == 0) {
+        strncpy(dst, "turn_on", dstSize - 1);
+    } else if (strcmp(dst, "off") == 0 || strcmp(dst, "turnoff") == 0) {
+        strncpy(dst, "turn_off", dstSize - 1);
+    }
+    dst[dstSize - 1] = '\0';
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <ArduinoJson.h>
+#include "AutomationEngine.h"
+#include "PollIntervals.h"
+
+// ===================================================================
+// JSON payloads of the REST clients (no Arduino dependency)
+// Builders serialize into the caller buffer and return the length,
+// 0 if it does not fit. Parsers take the raw response body.
+// Also built in [env:native], NativeBench.cpp time them on the host.
+// ===================================================================
+
+// Device Configuration
+#define SITE_ID                 "site1"
+#define ROOM_ID                 "roomA"
+#define DEVICE_NAME             "ESP32"
+#define USER_ID                 "2"      // User ID สำหรับ Automation API
+
+#define API_PAYLOAD_SIZE        768      // Build buffer, fit the largest document below
+#define API_SYNC_TOKEN_SIZE     32
+
+// Binary telemetry (TELEMETRY_MQTT_TOPIC), a MessagePack array by position, schema 1:
+//  [0] schema (1)          [5] light x100 (klux, as light_lux)  [10] heap_min
+//  [1] ts, unix s (0 = no  [6] water_delta, ml                  [11] heap_block
+//      clock yet)          [7] energy_delta, 0.1 Wh             [12] psram_free
+//  [2] temp_c x10          [8] rssi, dBm                        [13] stack_min
+//  [3] hum_rh x10          [9] heap_free
+//  [4] hum_dirt x10
+// All integers (MessagePack pick the smallest width), site / room / device are the
+// NETPIE device it arrive from. New fields only go at the end, with a new schema.
+#define TELEMETRY_SCHEMA_VERSION    1
+#define TELEMETRY_SCHEMA_FIELDS     14
+#define TELEMETRY_BINARY_SIZE       96      // Build buffer, schema 1 is 60 bytes at most
+
+// ApiClient::sendTelemetryToDotNetAPI
+struct TelemetryPayload {
+    float temp_c;
+    float hum_rh;
+    float hum_dirt;
+    float light_lux;
+    float water_delta_l;
+    float energy_delta_kwh;
+    const char* ts;         // "2025-10-11T20:23:16.000Z"
+    int rssi;
+    uint32_t heap_free;
+    uint32_t heap_min;
+    uint32_t heap_block;
+    uint32_t psram_free;
+    uint32_t stack_min;
+    uint32_t ts_unix;       // Binary payload only, 0 = clock not set
+};
+
+// AutomationApiClient::syncFromAPI, set the arrays and max before parse
+struct AutomationSyncData {
+    AutomationTimer* timers;
+    int max_timers;
+    int timer_count;
+    AutomationSensor* sensors; // NULL = do not keep sensors
+    int max_sensors;
+    int sensor_count;
+    char sync_token[API_SYNC_TOKEN_SIZE]; // "" if none
+    int32_t intervals[POLL_COUNT];        // "intervals" hints in seconds, -1 = not sent
+};
+
+class ApiPayload {
+public:
+    static size_t buildTelemetry(const TelemetryPayload* data, char* output, size_t size);
+    // MessagePack, schema above
+    static size_t buildTelemetryMsgPack(const TelemetryPayload* data, uint8_t* output, size_t size);
+    static size_t buildRelayTrigger(bool turn_on, const char* control_mode, const char* trigger_type,
+                                    int timer_id, float trigger_value, float threshold_value,
+                                    const char* message, char* output, size_t size);
+    static size_t buildStatus(int relay_id, bool current_state, const char* control_mode,
+                              bool timer_active, bool sensor_active, const char* trigger_type,
+                              char* output, size_t size);
+    static size_t buildLogEvent(int relay_id, const char* event_type, const char* event_source,
+                                bool old_state, bool new_state, int timer_id, float trigger_value,
+                                const char* message, char* output, size_t size);
+    // PUT /api/switch/{id}, version 0 / origin NULL = not sent (SwitchSync.h)
+    static size_t buildSwitchState(int id, int state, uint32_t version, const char* origin,
+                                   char* output, size_t size);
+
+    // GET /api/switch, states[id - 1] = 0 / 1 for id 1..count, versions[id - 1] = 0 if
+    // the server doesn't send one, versions NULL = don't keep
+    static bool parseSwitchStates(const char* json, size_t length, int* states, uint32_t* versions, int count);
+    // GET /api/switch/{id}
+    static bool parseSwitchState(const char* json, size_t length, int* state);
+    // GET /api/automation/sync, false on bad JSON or success = false
+    static bool parseAutomationSync(const char* json, size_t length, AutomationSyncData* data);
+
+    static const char* intervalKey(PollInterval interval); // "switchPoll", "sync", ... in "intervals"
+    static int stateFromString(const char* state); // "on" -> 1, else 0
+    // Retry-After / X-Poll-Interval header, only a positive integer of seconds (surrounding
+    // spaces allowed). "", "0", "-5", "1.5", "30s", an HTTP-date or > UINT32_MAX -> false
+    static bool parseSeconds(const char* text, uint32_t* seconds);
+    static void normalizeAction(const char* src, char* dst, size_t dstSize); // "On" / "turn-on" -> "turn_on"
+
+private:
+    static size_t serialize(const JsonDocument& doc, char* output, size_t size);
+};
@@ -0,0 +1,203 @@
+#include "ApiWorker.h"
+#include "SwitchApiClient.h"
+#include "HttpTransport.h"
+#include "AutomationApiClient.h"
+#include "SystemHealth.h"
+#include "Trace.h"
+
+static const char* TAG = "ApiWorker";
+
+static portMUX_TYPE countMux = portMUX_INITIALIZER_UNLOCKED;
+
+QueueHandle_t ApiWorker::queue = NULL;
+TaskHandle_t ApiWorker::taskHandle = NULL;
+ApiWorkerSwitchCallback ApiWorker::switchCallback = NULL;
+volatile uint32_t ApiWorker::latestSwitchVersion[4] = {0, 0, 0, 0};
+volatile int ApiWorker::queuedSwitchJobs = 0;
+
+void ApiWorker::begin() {
+    if (queue) {
+        return;
+    }
+
+    queue = xQueueCreate(API_WORKER_QUEUE_LENGTH, sizeof(ApiJob));
+    if (!queue) {
+        ESP_LOGE(TAG, "Create queue fail");
+        return;
+    }
+
+    xTaskCreatePinnedToCore(task, "ApiWorker", API_WORKER_STACK_SIZE, NULL,
+                            API_WORKER_PRIORITY, &taskHandle, API_WORKER_CORE);
+    SystemHealth::registerTask(taskHandle, "ApiWorker", API_WORKER_STACK_SIZE);
+    ESP_LOGI(TAG, "ApiWorker started (queue=%d)", API_WORKER_QUEUE_LENGTH);
+}
+
+bool ApiWorker::queueSwitchState(int relay_id, int state, uint32_t version, const char* origin) {
+    if (relay_id < 0 || relay_id >= 4) {
+        return false;
+    }
+
+    ApiJob job = {};
+    job.type = API_JOB_SWITCH_STATE;
+    job.relay_id = relay_id;
+    job.new_state = state ? true : false;
+    job.version = version;
+    strncpy(job.event_source, origin ? origin : "", sizeof(job.event_source) - 1);
+
+    // Remember the newest version so older queued jobs for the same relay are skipped
+    if (version >= latestSwitchVersion[relay_id]) {
+        latestSwitchVersion[relay_id] = version;
+    }
+    return enqueue(job);
+}
+
+bool ApiWorker::queueLogEvent(int relay_id, const char* event_type, const char* event_source,
+                              bool old_state, bool new_state) {
+    ApiJob job = {};
+    job.type = API_JOB_LOG_EVENT;
+    job.relay_id = relay_id;
+    job.old_state = old_state;
+    job.new_state = new_state;
+    strncpy(job.event_type, event_type ? event_type : "", sizeof(job.event_type) - 1);
+    strncpy(job.event_source, event_source ? event_source : "", sizeof(job.event_source) - 1);
+    return enqueue(job);
+}
+
+void ApiWorker::onSwitchStateResult(ApiWorkerSwitchCallback callback) {
+    switchCallback = callback;
+}
+
+int ApiWorker::pending() {
+    return queue ? uxQueueMessagesWaiting(queue) : 0;
+}
+
+bool ApiWorker::enqueue(const ApiJob& job) {
+    if (!queue) {
+        ESP_LOGW(TAG, "Not started, drop job type=%d relay=%d", job.type, job.relay_id);
+        drop(job);
+        return false;
+    }
+
+    countSwitchJob(job, 1); // Before the send, the worker may take it at once
+    if (xQueueSend(queue, &job, 0) == pdTRUE) {
+        return true;
+    }
+
+    // Queue full (link is down or slow): drop the oldest job, keep the newest
+    ApiJob dropped;
+    if (xQueueReceive(queue, &dropped, 0) == pdTRUE) {
+        ESP_LOGW(TAG, "Queue full, drop oldest job type=%d relay=%d", dropped.type, dropped.relay_id);
+        countSwitchJob(dropped, -1);
+        drop(dropped);
+    }
+    if (xQueueSend(queue, &job, 0) == pdTRUE) {
+        return true;
+    }
+    countSwitchJob(job, -1);
+    drop(job);
+    return false;
+}
+
+void ApiWorker::countSwitchJob(const ApiJob& job, int delta) {
+    if (job.type == API_JOB_SWITCH_STATE) {
+        portENTER_CRITICAL(&countMux);
+        queuedSwitchJobs += delta;
+        portEXIT_CRITICAL(&countMux);
+    }
+}
+
+void ApiWorker::drop(const ApiJob& job) {
+    // The owner of a switch job waits for its result, a dropped one is a failed PUT
+    if (job.type == API_JOB_SWITCH_STATE && switchCallback) {
+        switchCallback(job.relay_id, job.new_state ? 1 : 0, job.version, false);
+    }
+}
+
+// Wait for a token like a switch job, but give up as soon as a switch job is queued
+// behind this one, relay changes go first
+bool ApiWorker::reserveLogToken() {
+    uint32_t start = millis();
+    while (!HttpTransport::waitForToken(API_WORKER_TOKEN_SLICE)) {
+        if (queuedSwitchJobs > 0 || millis() - start >= API_WORKER_TOKEN_WAIT) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ApiWorker::process(const ApiJob& job) {
+    TRACE_SCOPE(job.type == API_JOB_SWITCH_STATE ? "worker.switch" : "worker.log");
+
+    if (job.type == API_JOB_SWITCH_STATE) {
+        // Relay changes shouldn't be dropped by the rate limit like a poll: reserve a token,
+        // the PUT spend it (the stale check below then skip a state superseded while waiting)
+        bool reserved = HttpTransport::waitForToken(API_WORKER_TOKEN_WAIT);
+        if (!reserved) {
+            ESP_LOGW(TAG, "No rate budget after %d ms", API_WORKER_TOKEN_WAIT);
+        }
+
+        int state = job.new_state ? 1 : 0;
+        if (job.version < latestSwitchVersion[job.relay_id]) {
+            // The newer job carries the final state, its ack covers this version too
+            ESP_LOGD(TAG, "Skip stale switch job relay=%d v%lu", job.relay_id, (unsigned long) job.version);
+            return;
+        }
+
+        int switchId = RELAY_ID_TO_SWITCH_ID(job.relay_id);
+        const char* origin = job.event_source[0] ? job.event_source : NULL;
+        bool conflict = false;
+        bool success = SwitchApiClient::updateSwitchState(switchId, state, job.version, origin, &conflict);
+        if (!success && !conflict && reserved && HttpTransport::isAvailable(HTTP_EP_SWITCH) &&
+            HttpTransport::waitForToken(API_WORKER_TOKEN_WAIT)) {
+            // retry once with its own token, not when the first one was rate limited (no reservation),
+            // the failure just opened the circuit or the server has a newer version
+            ESP_LOGW(TAG, "Retry update switch %d", switchId);
+            success = SwitchApiClient::updateSwitchState(switchId, state, job.version, origin, &conflict);
+        }
+
+        if (success) {
+            ESP_LOGI(TAG, "Updated switch %d to API: %s (v%lu %s)", switchId, state ? "ON" : "OFF",
+                     (unsigned long) job.version, origin ? origin : "-");
+        } else if (conflict) {
+            ESP_LOGI(TAG, "Switch %d v%lu superseded on the server", switchId, (unsigned long) job.version);
+        } else {
+            ESP_LOGW(TAG, "Failed to update switch %d to API after retry", switchId);
+        }
+
+        if (switchCallback) {
+            switchCallback(job.relay_id, state, job.version, success);
+        }
+    } else if (job.type == API_JOB_LOG_EVENT) {
+#if defined(AUTOMATION_API_ENABLE) && AUTOMATION_API_ENABLE
+        if (!reserveLogToken()) {
+            if (queuedSwitchJobs > 0) {
+                // Back to the end of the queue, after the switch jobs
+                if (xQueueSend(queue, &job, 0) != pdTRUE) {
+                    ESP_LOGW(TAG, "Queue full, drop log job relay=%d", job.relay_id);
+                }
+                return;
+            }
+            ESP_LOGW(TAG, "No rate budget after %d ms", API_WORKER_TOKEN_WAIT);
+        }
+        AutomationApiClient::logEvent(job.relay_id,
+                                      job.event_type,
+                                      job.event_source,
+                                      job.old_state,
+                                      job.new_state,
+                                      -1,
+                                      0.0f,
+                                      NULL);
+#endif
+    }
+}
+
+void ApiWorker::task(void* arg) {
+    ApiJob job;
+    while (1) {
+        if (xQueueReceive(queue, &job, portMAX_DELAY) == pdTRUE) {
+            countSwitchJob(job, -1);
+            process(job);
+            HttpTransport::releaseToken(); // Skipped job / no request sent, don't keep the token
+        }
+    }
+}
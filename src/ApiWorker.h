@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ===================================================================
+// Background worker for network side effects
+// UI / MQTT handlers toggle the relay immediately and hand the HTTP
+// work (Switch API update, Automation log) to this queue so that a bad
+// link never blocks LVGL or the main loop.
+// ===================================================================
+
+#define API_WORKER_QUEUE_LENGTH     16
+#define API_WORKER_STACK_SIZE       6144
+#define API_WORKER_PRIORITY         2
+#define API_WORKER_CORE             0
+#define API_WORKER_TOKEN_WAIT       30000   // ms, wait for HttpTransport rate budget before a job
+#define API_WORKER_TOKEN_SLICE      500     // ms, a log job check for queued switch jobs this often while waiting
+
+enum ApiJobType : uint8_t {
+    API_JOB_SWITCH_STATE,
+    API_JOB_LOG_EVENT,
+};
+
+struct ApiJob {
+    ApiJobType type;
+    int8_t relay_id;        // 0-3
+    bool old_state;
+    bool new_state;
+    uint32_t version;       // SwitchSync version of a switch job
+    char event_type[12];    // "turn_on" / "turn_off"
+    char event_source[24];  // "MANUAL_MQTT", "AUTO_API_TIMER", ... / origin of a switch job
+};
+
+// Called from the worker task after a Switch API update finished (also on conflict / skip),
+// or from the caller of queueSwitchState when a full queue drop a switch job (success = false)
+typedef void (*ApiWorkerSwitchCallback)(int relay_id, int state, uint32_t version, bool success);
+
+class ApiWorker {
+public:
+    static void begin();
+
+    /**
+     * @brief Queue a Switch API update (relay 0-3 -> switch 1-4)
+     * @param version SwitchSync version of the state, a queued job with a lower one is skipped
+     * @param origin What changed the relay ("MQTT", "TIMER", ...)
+     * @return true if the job was queued
+     */
+    static bool queueSwitchState(int relay_id, int state, uint32_t version, const char* origin);
+
+    /**
+     * @brief Queue an Automation API log event
+     * @return true if the job was queued
+     */
+    static bool queueLogEvent(int relay_id, const char* event_type, const char* event_source,
+                              bool old_state, bool new_state);
+
+    static void onSwitchStateResult(ApiWorkerSwitchCallback callback);
+    static int pending();
+
+private:
+    static bool enqueue(const ApiJob& job);
+    static void drop(const ApiJob& job);
+    static void countSwitchJob(const ApiJob& job, int delta);
+    static bool reserveLogToken();
+    static void process(const ApiJob& job);
+    static void task(void* arg);
+
+    static QueueHandle_t queue;
+    static TaskHandle_t taskHandle;
+    static ApiWorkerSwitchCallback switchCallback;
+    static volatile uint32_t latestSwitchVersion[4];
+    static volatile int queuedSwitchJobs;   // In the queue, a waiting log job yield to them
+};
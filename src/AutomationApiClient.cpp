@@ -3,72 +3,12 @@
 #include "ApiClient.h"
 #include <WiFi.h>
 #include <time.h>
+#include "HttpTransport.h"
+#include "PollIntervals.h"
+#include "Trace.h"
 
 static const char *TAG = "AutomationAPI";
 
-// ------------------ Helpers for robust string handling ------------------
-static void toLowercase(char *s)
-{
-    if (!s)
-        return;
-    for (char *p = s; *p; ++p)
-    {
-        if (*p >= 'A' && *p <= 'Z')
-            *p = *p - 'A' + 'a';
-    }
-}
-
-static void normalizeActionString(const char *src, char *dst, size_t dstSize)
-{
-    if (!dst || dstSize == 0)
-        return;
-    if (!src || !*src)
-    {
-        strncpy(dst, "turn_on", dstSize - 1);
-        dst[dstSize - 1] = '\0';
-        return;
-    }
-    strncpy(dst, src, dstSize - 1);
-    dst[dstSize - 1] = '\0';
-    toLowercase(dst);
-    for (char *p = dst; *p; ++p)
-    {
-        if (*p == '-' || *p == ' ')
-            *p = '_';
-    }
-    if (strcmp(dst, "on") == 0 || strcmp(dst, "turnon") == 0)
-    {
-        strncpy(dst, "turn_on", dstSize - 1);
-    }
-    else if (strcmp(dst, "off") == 0 || strcmp(dst, "turnoff") == 0)
-    {
-        strncpy(dst, "turn_off", dstSize - 1);
-    }
-    dst[dstSize - 1] = '\0';
-}
-
-static bool isActionTurnOff(const char *action)
-{
-    if (!action)
-        return false;
-    return (strcmp(action, "turn_off") == 0 || strcmp(action, "off") == 0);
-}
-
-static int sensorTypeToIndex(const char *sensor_type)
-{
-    if (!sensor_type)
-        return -1;
-    if (strcmp(sensor_type, "temperature") == 0)
-        return 0;
-    if (strcmp(sensor_type, "soil_moisture") == 0)
-        return 1;
-    if (strcmp(sensor_type, "humidity") == 0)
-        return 2;
-    if (strcmp(sensor_type, "light") == 0)
-        return 3;
-    return -1;
-}
-
 // Static member initialization
 AutomationTimer AutomationApiClient::local_timers[12] = {};
 int AutomationApiClient::local_timer_count = 0;
@@ -111,6 +51,7 @@ void AutomationApiClient::init()
 
 bool AutomationApiClient::syncFromAPI()
 {
+    TRACE_SCOPE("automation.sync");
     if (!AUTOMATION_API_ENABLE)
     {
         ESP_LOGD(TAG, "Automation API is disabled");
@@ -136,92 +77,51 @@ bool AutomationApiClient::syncFromAPI()
         return false;
     }
 
-    const size_t capacity = JSON_OBJECT_SIZE(10) + JSON_ARRAY_SIZE(20) * 2 + 2048;
-    DynamicJsonDocument doc(capacity);
-
-    DeserializationError error = deserializeJson(doc, response);
-    if (error)
+    AutomationSyncData data;
+    data.timers = local_timers;
+    data.max_timers = 12;
+#if AUTOMATION_CACHE_SENSORS
+    data.sensors = local_sensors;
+#else
+    data.sensors = nullptr;
+#endif
+    data.max_sensors = 16;
+    if (!ApiPayload::parseAutomationSync(response.c_str(), response.length(), &data))
     {
-        ESP_LOGE(TAG, "JSON parse error: %s", error.c_str());
         return false;
     }
 
-    if (!doc["success"].as<bool>())
+    // Server interval hints, a hint not sent keep the current one (0 = back to default)
+    for (int i = 0; i < POLL_COUNT; i++)
     {
-        ESP_LOGW(TAG, "Sync failed: %s", doc["error"]["message"].as<const char *>());
-        return false;
+        if (data.intervals[i] >= 0)
+        {
+            PollIntervals::hint((PollInterval)i, data.intervals[i]);
+        }
     }
 
-    const char *token = doc["data"]["syncToken"];
-    if (token && strcmp(token, sync_token) == 0)
+    if (data.sync_token[0] && strcmp(data.sync_token, sync_token) == 0)
     {
         ESP_LOGI(TAG, "[AUTO] Sync token unchanged; forcing reload of timers/sensors");
         last_sync_time = millis();
     }
-    if (token)
+    if (data.sync_token[0])
     {
-        strncpy(sync_token, token, sizeof(sync_token) - 1);
+        strncpy(sync_token, data.sync_token, sizeof(sync_token) - 1);
     }
 
-    JsonArray timers = doc["data"]["timers"].as<JsonArray>();
-    if (timers.size() == 0)
+    if (data.timer_count == 0)
     {
         clearLocalCache();
         ESP_LOGI(TAG, "No timers from API, local cache cleared");
     }
-    local_timer_count = 0;
-    for (JsonObject timer : timers)
-    {
-        if (local_timer_count >= 12)
-            break;
-
-        AutomationTimer &t = local_timers[local_timer_count];
-        // Use API-provided relayId as-is (API/web UI uses 0-based relay IDs)
-        t.relay_id = timer["relayId"];
-        t.timer_id = timer["timerId"];
-        t.enabled = timer["enabled"];
-
-        JsonArray days = timer["days"].as<JsonArray>();
-        for (int i = 0; i < 7 && i < days.size(); i++)
-        {
-            t.days[i] = days[i].as<int>() == 1;
-        }
-
-        const char *time_on = timer["timeOn"];
-        const char *time_off = timer["timeOff"];
-        // Parse time strings into minutes
-        t.time_on = timeStringToMinutes(time_on);
-        t.time_off = timeStringToMinutes(time_off);
-
-        local_timer_count++;
-    }
-
+    local_timer_count = data.timer_count;
     ESP_LOGI(TAG, "Loaded %d timers from API", local_timer_count);
 
-    JsonArray sensors = doc["data"]["sensors"].as<JsonArray>();
+    local_sensor_count = data.sensor_count;
 #if AUTOMATION_CACHE_SENSORS
-    local_sensor_count = 0;
-    for (JsonObject sensor : sensors)
-    {
-        if (local_sensor_count >= 16)
-            break;
-        AutomationSensor &s = local_sensors[local_sensor_count];
-        s.relay_id = sensor["relayId"];
-        strncpy(s.sensor_type, sensor["sensorType"].as<const char *>(), sizeof(s.sensor_type) - 1);
-        s.sensor_type[sizeof(s.sensor_type) - 1] = '\0';
-        s.enabled = sensor["enabled"];
-        s.min_value = sensor["minValue"];
-        s.max_value = sensor["maxValue"];
-        strncpy(s.control_mode, sensor["controlMode"].as<const char *>(), sizeof(s.control_mode) - 1);
-        s.control_mode[sizeof(s.control_mode) - 1] = '\0';
-        const char *actionOnTrigger = sensor["actionOnTrigger"];
-        normalizeActionString(actionOnTrigger, s.action, sizeof(s.action));
-        s.hysteresis = sensor["hysteresis"];
-        local_sensor_count++;
-    }
     ESP_LOGI(TAG, "Loaded %d sensors from API", local_sensor_count);
 #else
-    local_sensor_count = 0;
     ESP_LOGI(TAG, "Skipping caching sensors (AUTOMATION_CACHE_SENSORS=0)");
 #endif
 
@@ -264,26 +164,18 @@ AutomationTimer *AutomationApiClient::getLocalTimer(int relay_id, int timer_id)
 bool AutomationApiClient::isTimerActive(int relay_id, int timer_id,
                                         int current_minutes, int day_of_week)
 {
-    AutomationTimer *timer = getLocalTimer(relay_id, timer_id);
-    if (!timer || !timer->enabled)
-    {
-        return false;
-    }
-
-    // Check if disabled (3000 = disabled marker)
-    if (IS_TIMER_DISABLED(timer->time_on, timer->time_off))
-    {
-        return false;
-    }
+    return AutomationSchedule::isTimerActive(getLocalTimer(relay_id, timer_id), current_minutes, day_of_week);
+}
 
-    // Check day of week (0=Monday, 6=Sunday)
-    if (day_of_week < 0 || day_of_week > 6 || !timer->days[day_of_week])
-    {
-        return false;
-    }
+void AutomationApiClient::getRelayRules(int relay_id, AutomationRelayRules *rules)
+{
+    AutomationEngine::resolve(relay_id, local_timers, local_timer_count, local_sensors, local_sensor_count, rules);
+}
 
-    // Check time range
-    return (current_minutes >= timer->time_on && current_minutes < timer->time_off);
+// Next time_on / time_off of any enabled timer, for RTC alarm
+int AutomationApiClient::getMinutesToNextTimerEdge(int current_minutes, int day_of_week)
+{
+    return AutomationSchedule::getMinutesToNextEdge(local_timers, local_timer_count, current_minutes, day_of_week);
 }
 
 // ===================================================================
@@ -334,7 +226,7 @@ bool AutomationApiClient::checkSensorTrigger(int relay_id, const char *sensor_ty
     char endpoint[128];
     snprintf(endpoint, sizeof(endpoint), "%s?userId=%s", ENDPOINT_AUTOMATION_SENSORS, USER_ID);
     bool got = sendGetRequest(endpoint, response);
-    const char *action = "turn_on";
+    AutomationDecision decision = AUTOMATION_TURN_ON;
     bool found = false;
 
     if (got)
@@ -355,63 +247,31 @@ bool AutomationApiClient::checkSensorTrigger(int relay_id, const char *sensor_ty
                 if (en && rid == relay_id && stype && strcmp(stype, sensor_type) == 0 && controlMode)
                 {
                     found = true;
-                    if (strcmp(controlMode, "max_trigger") == 0)
-                    {
-                        float maxValue = item["maxValue"] | 0.0f;
-                        float hysteresis = item["hysteresis"] | 2.0f;
-                        if (current_value > maxValue + hysteresis)
-                        {
-                            action = item["actionOnTrigger"] | "turn_on";
-                        }
-                        else
-                        {
-                            action = item["actionOnTrigger"] | "turn_off";
-                        }
-                    }
-                    else if (strcmp(controlMode, "min_trigger") == 0)
-                    {
-                        float minValue = item["minValue"] | 0.0f;
-                        float hysteresis = item["hysteresis"] | 2.0f;
-                        if (current_value < minValue + hysteresis)
-                        {
-                            action = item["actionOnTrigger"] | "turn_on";
-                        }
-                        else
-                        {
-                            action = item["actionOnTrigger"] | "turn_off";
-                        }
-                    }
-                    else if (strcmp(controlMode, "range") == 0)
-                    {
-                        float minValue = item["minValue"] | 0.0f;
-                        float maxValue = item["maxValue"] | 0.0f;
-                        float hysteresis = item["hysteresis"] | 2.0f;
-                        if (current_value < minValue + hysteresis || current_value > maxValue + hysteresis)
-                        {
-                            action = item["actionOnTrigger"] | "turn_on";
-                        }
-                        else
-                        {
-                            action = item["actionOnTrigger"] | "turn_off";
-                        }
-                    }
+                    AutomationSensor sensor = {};
+                    sensor.relay_id = rid;
+                    strncpy(sensor.sensor_type, stype, sizeof(sensor.sensor_type) - 1);
+                    sensor.enabled = true;
+                    sensor.min_value = item["minValue"] | 0.0f;
+                    sensor.max_value = item["maxValue"] | 0.0f;
+                    sensor.hysteresis = item["hysteresis"] | 2.0f;
+                    strncpy(sensor.control_mode, controlMode, sizeof(sensor.control_mode) - 1);
+                    const char *action = item["actionOnTrigger"];
+                    if (action)
+                        ApiPayload::normalizeAction(action, sensor.action, sizeof(sensor.action));
+                    decision = AutomationEngine::decideSensor(&sensor, current_value);
                     break; // เจอ sensor ที่ตรงแล้ว ไม่ต้องวนต่อ
                 }
             }
         }
     }
 
-    char normalizedAction[16];
-    normalizeActionString(action, normalizedAction, sizeof(normalizedAction));
-    bool turnOffOnTrigger = isActionTurnOff(normalizedAction);
-
     if (should_turn_on)
-        *should_turn_on = !turnOffOnTrigger;
+        *should_turn_on = (decision == AUTOMATION_TURN_ON);
     if (action_on_trigger)
-        *action_on_trigger = action;
+        *action_on_trigger = AutomationEngine::decisionName(decision);
 
     ESP_LOGI(TAG, "Sensor ACTIVE (RT) relay=%d type=%s value=%.2f action=%s shouldTurnOn=%d found=%d",
-             relay_id, sensor_type, current_value, normalizedAction, should_turn_on ? (*should_turn_on) : -1, found);
+             relay_id, sensor_type, current_value, AutomationEngine::decisionName(decision), should_turn_on ? (*should_turn_on) : -1, found);
 
     return found;
 }
@@ -425,46 +285,20 @@ bool AutomationApiClient::triggerRelay(int relay_id, bool turn_on,
                                        int timer_id, float trigger_value,
                                        float threshold_value, const char *message)
 {
-    const size_t capacity = JSON_OBJECT_SIZE(15) + 512;
-    DynamicJsonDocument doc(capacity);
-
-    doc["userId"] = USER_ID; // à¹€à¸›à¸¥à¸µà¹ˆà¸¢à¸™à¹€à¸›à¹‡à¸™ USER_ID
-    doc["siteId"] = SITE_ID;
-    doc["roomId"] = ROOM_ID;
-    doc["action"] = turn_on ? "turn_on" : "turn_off";
-    doc["controlMode"] = control_mode;
-    doc["triggerType"] = trigger_type;
-    doc["source"] = "esp32";
-
-    if (timer_id >= 0)
-    {
-        doc["timerId"] = timer_id;
-    }
-
-    if (trigger_value != 0.0f)
+    char payload[API_PAYLOAD_SIZE];
+    if (!ApiPayload::buildRelayTrigger(turn_on, control_mode, trigger_type, timer_id,
+                                       trigger_value, threshold_value, message, payload, sizeof(payload)))
     {
-        doc["triggerValue"] = trigger_value;
-    }
-
-    if (threshold_value != 0.0f)
-    {
-        doc["thresholdValue"] = threshold_value;
-    }
-
-    if (message)
-    {
-        doc["message"] = message;
+        ESP_LOGE(TAG, "triggerRelay payload too large");
+        return false;
     }
 
-    String payload;
-    serializeJson(doc, payload);
-
     char endpoint[128];
     snprintf(endpoint, sizeof(endpoint), "%s/%d/trigger",
              ENDPOINT_AUTOMATION_RELAY_TRIGGER, relay_id);
 
     String response;
-    bool success = sendPostRequest(endpoint, payload.c_str(), response);
+    bool success = sendPostRequest(endpoint, payload, response);
 
     if (success)
     {
@@ -508,28 +342,16 @@ bool AutomationApiClient::updateStatus(int relay_id, bool current_state,
                                        const char *control_mode, bool timer_active,
                                        bool sensor_active, const char *trigger_type)
 {
-    const size_t capacity = JSON_OBJECT_SIZE(12) + 256;
-    DynamicJsonDocument doc(capacity);
-
-    doc["userId"] = USER_ID; // เปลี่ยนไปใช้ USER_ID
-    doc["siteId"] = SITE_ID;
-    doc["roomId"] = ROOM_ID;
-    doc["relayId"] = relay_id;
-    doc["currentState"] = current_state;
-    doc["controlMode"] = control_mode;
-    doc["timerActive"] = timer_active;
-    doc["sensorActive"] = sensor_active;
-
-    if (trigger_type)
+    char payload[API_PAYLOAD_SIZE];
+    if (!ApiPayload::buildStatus(relay_id, current_state, control_mode, timer_active,
+                                 sensor_active, trigger_type, payload, sizeof(payload)))
     {
-        doc["triggerType"] = trigger_type;
+        ESP_LOGE(TAG, "updateStatus payload too large");
+        return false;
     }
 
-    String payload;
-    serializeJson(doc, payload);
-
     String response;
-    bool success = sendPostRequest(ENDPOINT_AUTOMATION_STATUS, payload.c_str(), response);
+    bool success = sendPostRequest(ENDPOINT_AUTOMATION_STATUS, payload, response);
 
     // Update local cache
     if (success && relay_id >= 0 && relay_id < 4)
@@ -650,38 +472,16 @@ bool AutomationApiClient::logEvent(int relay_id, const char *event_type,
                                    const char *event_source, bool old_state, bool new_state,
                                    int timer_id, float trigger_value, const char *message)
 {
-    const size_t capacity = JSON_OBJECT_SIZE(15) + 512;
-    DynamicJsonDocument doc(capacity);
-
-    doc["userId"] = USER_ID; // เปลี่ยนไปใช้ USER_ID
-    doc["siteId"] = SITE_ID;
-    doc["roomId"] = ROOM_ID;
-    doc["relayId"] = relay_id;
-    doc["eventType"] = event_type;
-    doc["eventSource"] = event_source;
-    doc["oldState"] = old_state;
-    doc["newState"] = new_state;
-
-    if (timer_id >= 0)
+    char payload[API_PAYLOAD_SIZE];
+    if (!ApiPayload::buildLogEvent(relay_id, event_type, event_source, old_state, new_state,
+                                   timer_id, trigger_value, message, payload, sizeof(payload)))
     {
-        doc["timerId"] = timer_id;
-    }
-
-    if (trigger_value != 0.0f)
-    {
-        doc["triggerValue"] = trigger_value;
-    }
-
-    if (message)
-    {
-        doc["message"] = message;
+        ESP_LOGE(TAG, "logEvent payload too large");
+        return false;
     }
 
-    String payload;
-    serializeJson(doc, payload);
-
     String response;
-    bool success = sendPostRequest(ENDPOINT_AUTOMATION_LOGS, payload.c_str(), response);
+    bool success = sendPostRequest(ENDPOINT_AUTOMATION_LOGS, payload, response);
     if (success)
     {
         ESP_LOGI(TAG, "logEvent sent: relay=%d type=%s source=%s old=%d new=%d", relay_id, event_type, event_source, old_state, new_state);
@@ -689,7 +489,7 @@ bool AutomationApiClient::logEvent(int relay_id, const char *event_type,
     else
     {
         ESP_LOGW(TAG, "logEvent failed: relay=%d type=%s source=%s", relay_id, event_type, event_source);
-        ESP_LOGV(TAG, "Payload: %s", payload.c_str());
+        ESP_LOGV(TAG, "Payload: %s", payload);
         ESP_LOGV(TAG, "Response: %s", response.c_str());
     }
     return success;
@@ -750,31 +550,17 @@ bool AutomationApiClient::checkSensorAPI(int relay_id, const char *sensor_type,
 
 int AutomationApiClient::timeStringToMinutes(const char *time_str)
 {
-    // "08:00:00" -> 480
-    int hour = 0, minute = 0;
-    if (sscanf(time_str, "%d:%d", &hour, &minute) == 2)
-    {
-        return hour * 60 + minute;
-    }
-    return 0;
+    return AutomationSchedule::timeStringToMinutes(time_str);
 }
 
 void AutomationApiClient::minutesToTimeString(int minutes, char *output)
 {
-    // 480 -> "08:00:00"
-    int hour = minutes / 60;
-    int min = minutes % 60;
-    snprintf(output, 16, "%02d:%02d:00", hour, min);
+    AutomationSchedule::minutesToTimeString(minutes, output);
 }
 
 int AutomationApiClient::getDayOfWeek(struct tm *timeinfo)
 {
-    // tm_wday: 0=Sunday, 1=Monday, ..., 6=Saturday
-    // Convert to: 0=Monday, 1=Tuesday, ..., 6=Sunday
-    int day = timeinfo->tm_wday - 1;
-    if (day < 0)
-        day = 6; // Sunday
-    return day;
+    return AutomationSchedule::getDayOfWeek(timeinfo);
 }
 
 void AutomationApiClient::clearLocalCache()
@@ -805,23 +591,16 @@ bool AutomationApiClient::sendGetRequest(const char *endpoint, String &response)
         return false;
     }
 
-    HTTPClient http;
     String fullUrl = buildFullUrl(endpoint);
 
     ESP_LOGD(TAG, "GET %s", fullUrl.c_str());
 
-    http.begin(fullUrl);
-    http.setTimeout(5000);
-    http.addHeader("X-API-KEY", DOTNET_API_KEY); //  ApiClient.h
-
-    int httpCode = http.GET();
+    int httpCode = HttpTransport::request("GET", fullUrl, DOTNET_API_KEY, NULL, &response, 5000); //  ApiClient.h
 
     if (httpCode > 0)
     {
         if (httpCode == HTTP_CODE_OK)
         {
-            response = http.getString();
-            http.end();
             return true;
         }
         else
@@ -831,10 +610,9 @@ bool AutomationApiClient::sendGetRequest(const char *endpoint, String &response)
     }
     else
     {
-        ESP_LOGE(TAG, "HTTP Error: %s", http.errorToString(httpCode).c_str());
+        ESP_LOGE(TAG, "HTTP Error: %s", HTTPClient::errorToString(httpCode).c_str());
     }
 
-    http.end();
     return false;
 }
 
@@ -846,41 +624,31 @@ bool AutomationApiClient::sendPostRequest(const char *endpoint, const char *payl
         return false;
     }
 
-    HTTPClient http;
     String fullUrl = buildFullUrl(endpoint);
 
     ESP_LOGD(TAG, "POST %s", fullUrl.c_str());
     ESP_LOGV(TAG, "Payload: %s", payload);
 
-    http.begin(fullUrl);
-    http.setTimeout(5000);
-    http.addHeader("Content-Type", "application/json");
-    http.addHeader("X-API-KEY", DOTNET_API_KEY);
-
-    int httpCode = http.POST(payload);
+    int httpCode = HttpTransport::request("POST", fullUrl, DOTNET_API_KEY, payload, &response, 5000);
 
     if (httpCode > 0)
     {
         if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_CREATED)
         {
-            response = http.getString();
             ESP_LOGD(TAG, "Response: %s", response.c_str());
-            http.end();
             return true;
         }
         else
         {
             ESP_LOGW(TAG, "HTTP Error: %d", httpCode);
-            response = http.getString();
             ESP_LOGW(TAG, "Response: %s", response.c_str());
         }
     }
     else
     {
-        ESP_LOGE(TAG, "HTTP Error: %s", http.errorToString(httpCode).c_str());
+        ESP_LOGE(TAG, "HTTP Error: %s", HTTPClient::errorToString(httpCode).c_str());
     }
 
-    http.end();
     return false;
 }
 
@@ -5,6 +5,8 @@
 #include <Arduino.h>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
+#include "AutomationSchedule.h"
+#include "ApiPayload.h"
 
 // ===================================================================
 // Automation API Client for ESP32
@@ -25,28 +27,6 @@
 #define ENDPOINT_AUTOMATION_RELAY_TRIGGER "/api/automation/relay"
 #define ENDPOINT_AUTOMATION_LOGS        "/api/automation/logs"
 
-// Timer Structure (ESP32 local storage)
-struct AutomationTimer {
-    uint8_t relay_id;       // 0-3
-    uint8_t timer_id;       // 0-2
-    bool enabled;
-    bool days[7];           // Mon-Sun (0=Monday, 6=Sunday)
-    uint16_t time_on;       // Minutes from midnight (0-1439)
-    uint16_t time_off;      // Minutes from midnight (0-1439)
-    char description[64];
-};
-
-struct AutomationSensor {
-    uint8_t relay_id;
-    char sensor_type[20];
-    bool enabled;
-    float min_value;
-    float max_value;
-    char control_mode[20];
-    float hysteresis;
-    char action[10];
-};
-
 struct AutomationStatus {
     uint8_t relay_id;
     bool current_state;
@@ -67,9 +47,11 @@ public:
     static int getLocalTimerCount();
     static AutomationTimer* getLocalTimer(int relay_id, int timer_id);
     static bool isTimerActive(int relay_id, int timer_id, int current_minutes, int day_of_week);
+    static int getMinutesToNextTimerEdge(int current_minutes, int day_of_week); // -1 if no timer
     static bool getSensors();
     static int getLocalSensorCount();
     static AutomationSensor* getLocalSensor(int relay_id, const char* sensor_type);
+    static void getRelayRules(int relay_id, AutomationRelayRules* rules); // For AutomationEngine, valid until the next sync
     static bool checkSensorTrigger(int relay_id, const char* sensor_type, float current_value, bool* should_turn_on, String* action_on_trigger);
     static bool triggerRelay(
         int relay_id,
@@ -130,8 +112,6 @@ private:
 #define RELAY_ID_TO_SWITCH_ID(relay_id) ((relay_id) + 1)
 #define SWITCH_ID_TO_RELAY_ID(switch_id) ((switch_id) - 1)
 
-#define IS_TIMER_DISABLED(time_on, time_off) ((time_on) >= 3000 && (time_off) >= 3000)
-
 #define LOG_AUTOMATION(tag, format, ...) ESP_LOGI(tag, "[AUTO] " format, ##__VA_ARGS__)
 #define LOG_AUTOMATION_ERROR(tag, format, ...) ESP_LOGE(tag, "[AUTO] " format, ##__VA_ARGS__)
 
@@ -0,0 +1,115 @@
+#include "AutomationEngine.h"
+#include <string.h>
+
+static const char* const INPUT_NAMES[AUTOMATION_IN_COUNT] = {
+    "temperature",
+    "soil_moisture",
+    "humidity",
+    "light",
+};
+
+void AutomationEngine::resolve(int relay_id, const AutomationTimer *timers, int timer_count,
+                               const AutomationSensor *sensors, int sensor_count, AutomationRelayRules *rules)
+{
+    memset(rules, 0, sizeof(AutomationRelayRules));
+
+    for (int timer_id = 0; timer_id < AUTOMATION_TIMERS_PER_RELAY; timer_id++)
+    {
+        for (int i = 0; i < timer_count; i++)
+        {
+            if (timers[i].relay_id == relay_id && timers[i].timer_id == timer_id)
+            {
+                if (timers[i].enabled)
+                {
+                    rules->timers[rules->timer_count++] = &timers[i];
+                }
+                break;
+            }
+        }
+    }
+
+    for (int input = 0; input < AUTOMATION_IN_COUNT; input++)
+    {
+        for (int i = 0; i < sensor_count; i++)
+        {
+            if (sensors[i].relay_id == relay_id && strcmp(sensors[i].sensor_type, INPUT_NAMES[input]) == 0)
+            {
+                if (sensors[i].enabled)
+                {
+                    rules->sensors[input] = &sensors[i];
+                }
+                break;
+            }
+        }
+    }
+}
+
+bool AutomationEngine::isTimerActive(const AutomationRelayRules *rules, int current_minutes, int day_of_week)
+{
+    for (int t = 0; t < rules->timer_count; t++)
+    {
+        if (AutomationSchedule::isTimerActive(rules->timers[t], current_minutes, day_of_week))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+AutomationDecision AutomationEngine::decideTimers(const AutomationRelayRules *rules, int current_minutes, int day_of_week)
+{
+    if (rules->timer_count == 0)
+    {
+        return AUTOMATION_NONE; // Don't force state for relays with no timers
+    }
+    return isTimerActive(rules, current_minutes, day_of_week) ? AUTOMATION_TURN_ON : AUTOMATION_TURN_OFF;
+}
+
+AutomationDecision AutomationEngine::decideSensor(const AutomationSensor *sensor, float value)
+{
+    bool triggered;
+    if (strcmp(sensor->control_mode, "max_trigger") == 0)
+    {
+        triggered = value > sensor->max_value + sensor->hysteresis;
+    }
+    else if (strcmp(sensor->control_mode, "min_trigger") == 0)
+    {
+        triggered = value < sensor->min_value + sensor->hysteresis;
+    }
+    else if (strcmp(sensor->control_mode, "range") == 0)
+    {
+        triggered = value < sensor->min_value + sensor->hysteresis || value > sensor->max_value + sensor->hysteresis;
+    }
+    else
+    {
+        return AUTOMATION_TURN_ON;
+    }
+
+    if (sensor->action[0])
+    {
+        if (strcmp(sensor->action, "turn_on") == 0)
+            return AUTOMATION_TURN_ON;
+        if (strcmp(sensor->action, "turn_off") == 0)
+            return AUTOMATION_TURN_OFF;
+        return AUTOMATION_NONE;
+    }
+    return triggered ? AUTOMATION_TURN_ON : AUTOMATION_TURN_OFF;
+}
+
+const char *AutomationEngine::inputName(int input)
+{
+    return (input >= 0 && input < AUTOMATION_IN_COUNT) ? INPUT_NAMES[input] : "";
+}
+
+const char *AutomationEngine::decisionName(AutomationDecision decision)
+{
+    switch (decision)
+    {
+    case AUTOMATION_TURN_ON:
+        return "turn_on";
+    case AUTOMATION_TURN_OFF:
+        return "turn_off";
+    default:
+        return "none";
+    }
+}
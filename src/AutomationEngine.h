@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "AutomationSchedule.h"
+
+// ===================================================================
+// Relay decisions of the automation (no Arduino dependency)
+// What checkAndTriggerTimers / checkAndTriggerSensors decide, without
+// the relay / API side, so NativeReplay.cpp can run the same code on
+// recorded or synthetic traces.
+// ===================================================================
+
+struct AutomationSensor {
+    uint8_t relay_id;
+    char sensor_type[20];
+    bool enabled;
+    float min_value;
+    float max_value;
+    char control_mode[20];  // "max_trigger", "min_trigger", "range"
+    float hysteresis;
+    char action[10];        // actionOnTrigger, "" = follow the threshold
+};
+
+// Sensor inputs, in the order checkAndTriggerSensors evaluate them
+enum AutomationInput {
+    AUTOMATION_IN_TEMPERATURE = 0,
+    AUTOMATION_IN_SOIL,
+    AUTOMATION_IN_HUMIDITY,
+    AUTOMATION_IN_LIGHT,
+    AUTOMATION_IN_COUNT
+};
+
+enum AutomationDecision {
+    AUTOMATION_NONE = 0,
+    AUTOMATION_TURN_ON,
+    AUTOMATION_TURN_OFF
+};
+
+#define AUTOMATION_TIMERS_PER_RELAY 3
+
+// Lookups for one relay, done once per sync instead of every check
+struct AutomationRelayRules {
+    const AutomationTimer* timers[AUTOMATION_TIMERS_PER_RELAY];  // Enabled only
+    int timer_count;
+    const AutomationSensor* sensors[AUTOMATION_IN_COUNT];       // Enabled only, NULL = none
+};
+
+class AutomationEngine {
+public:
+    // First timer_id 0..2 / sensor_type match win, like getLocalTimer / getLocalSensor
+    static void resolve(int relay_id, const AutomationTimer* timers, int timer_count,
+                        const AutomationSensor* sensors, int sensor_count, AutomationRelayRules* rules);
+
+    // A timer window is open, sensors are skipped (priority timer > sensor)
+    static bool isTimerActive(const AutomationRelayRules* rules, int current_minutes, int day_of_week);
+
+    // ON inside a window, OFF outside, NONE if the relay has no enabled timer
+    static AutomationDecision decideTimers(const AutomationRelayRules* rules, int current_minutes, int day_of_week);
+
+    // max_trigger: value > max + hysteresis, min_trigger: value < min + hysteresis,
+    // range: outside [min, max] + hysteresis. An action set on the rule is returned
+    // whether or not it triggered (checkSensorTrigger), unknown mode = ON.
+    static AutomationDecision decideSensor(const AutomationSensor* sensor, float value);
+
+    static const char* inputName(int input);              // sensor_type, "temperature" ..
+    static const char* decisionName(AutomationDecision decision); // "turn_on" / "turn_off" / "none"
+};
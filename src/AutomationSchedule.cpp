@@ -0,0 +1,100 @@
+#include "AutomationSchedule.h"
+#include <stdio.h>
+
+int AutomationSchedule::timeStringToMinutes(const char *time_str)
+{
+    // "08:00:00" -> 480
+    int hour = 0, minute = 0;
+    if (time_str && sscanf(time_str, "%d:%d", &hour, &minute) == 2)
+    {
+        return hour * 60 + minute;
+    }
+    return 0;
+}
+
+void AutomationSchedule::minutesToTimeString(int minutes, char *output)
+{
+    // 480 -> "08:00:00", 3000 (disabled marker) -> "50:00:00"
+    if (minutes < 0)
+    {
+        minutes = 0;
+    }
+    int hour = (minutes / 60) % 100; // Always 2 digits, fit the 16 byte output
+    int min = minutes % 60;
+    snprintf(output, 16, "%02d:%02d:00", hour, min);
+}
+
+int AutomationSchedule::getDayOfWeek(const struct tm *timeinfo)
+{
+    // tm_wday: 0=Sunday, 1=Monday, ..., 6=Saturday
+    // Convert to: 0=Monday, 1=Tuesday, ..., 6=Sunday
+    int day = timeinfo->tm_wday - 1;
+    if (day < 0)
+        day = 6; // Sunday
+    return day;
+}
+
+bool AutomationSchedule::isTimerActive(const AutomationTimer *timer, int current_minutes, int day_of_week)
+{
+    if (!timer || !timer->enabled)
+    {
+        return false;
+    }
+
+    // Check if disabled (3000 = disabled marker)
+    if (IS_TIMER_DISABLED(timer->time_on, timer->time_off))
+    {
+        return false;
+    }
+
+    // Check day of week (0=Monday, 6=Sunday)
+    if (day_of_week < 0 || day_of_week > 6)
+    {
+        return false;
+    }
+
+    if (timer->time_off < timer->time_on)
+    {
+        // Overnight: the part after midnight belong to the day it started
+        int yesterday = (day_of_week + 6) % 7;
+        return (timer->days[day_of_week] && current_minutes >= timer->time_on) ||
+               (timer->days[yesterday] && current_minutes < timer->time_off);
+    }
+
+    // Check time range
+    return timer->days[day_of_week] && current_minutes >= timer->time_on && current_minutes < timer->time_off;
+}
+
+int AutomationSchedule::getMinutesToNextEdge(const AutomationTimer *timers, int count, int current_minutes, int day_of_week)
+{
+    int next = -1;
+    for (int t = 0; t < count; t++)
+    {
+        const AutomationTimer *timer = &timers[t];
+        if (!timer->enabled || IS_TIMER_DISABLED(timer->time_on, timer->time_off))
+        {
+            continue;
+        }
+
+        // Edges belong to the day the timer start, an overnight time_off is the day after.
+        // Start from yesterday for an overnight time_off still to come today
+        int offDay = (timer->time_off < timer->time_on) ? 1440 : 0;
+        for (int day = -1; day <= 7; day++)
+        {
+            if (!timer->days[(day_of_week + day + 7) % 7])
+            {
+                continue;
+            }
+            int edges[2] = {timer->time_on, timer->time_off + offDay};
+            for (int i = 0; i < 2; i++)
+            {
+                int minutes = (day * 1440) + edges[i] - current_minutes;
+                if (minutes > 0 && (next < 0 || minutes < next))
+                {
+                    next = minutes;
+                }
+            }
+        }
+    }
+    return next;
+}
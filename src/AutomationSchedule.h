@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+// ===================================================================
+// Timer schedule math (no Arduino dependency)
+// Minutes are counted from midnight, day of week 0 = Monday .. 6 = Sunday
+// time_off < time_on is an overnight timer: it runs from time_on on an
+// enabled day to time_off the day after, that day needn't be enabled
+// ===================================================================
+
+#define IS_TIMER_DISABLED(time_on, time_off) ((time_on) >= 3000 && (time_off) >= 3000)
+
+// Timer Structure (ESP32 local storage)
+struct AutomationTimer {
+    uint8_t relay_id;       // 0-3
+    uint8_t timer_id;       // 0-2
+    bool enabled;
+    bool days[7];           // Mon-Sun (0=Monday, 6=Sunday)
+    uint16_t time_on;       // Minutes from midnight (0-1439)
+    uint16_t time_off;      // Minutes from midnight (0-1439)
+    char description[64];
+};
+
+class AutomationSchedule {
+public:
+    static int timeStringToMinutes(const char* time_str);   // "08:00:00" -> 480, 0 if not a time
+    static void minutesToTimeString(int minutes, char* output); // 480 -> "08:00:00", output >= 16 byte
+    static int getDayOfWeek(const struct tm* timeinfo);     // tm_wday (0 = Sunday) -> 0 = Monday
+
+    // Enabled, not the 3000 marker, day match and time_on <= minutes < time_off
+    // (overnight: time_on <= minutes on the day, or minutes < time_off the day after)
+    static bool isTimerActive(const AutomationTimer* timer, int current_minutes, int day_of_week);
+
+    // Minutes until the next time_on / time_off of any timer in the list, -1 if none
+    static int getMinutesToNextEdge(const AutomationTimer* timers, int count, int current_minutes, int day_of_week);
+};
@@ -0,0 +1,98 @@
+#include "DeviceConfig.h"
+#include <stdlib.h>
+#include <string.h>
+
+static bool fits(const char *value, size_t max, bool required)
+{
+    if (!value)
+    {
+        return !required;
+    }
+    size_t length = strlen(value);
+    return length <= max && (length > 0 || !required);
+}
+
+static long readPort(JsonVariantConst port)
+{
+    if (port.is<long>())
+    {
+        return port.as<long>();
+    }
+    const char *text = port.as<const char *>();
+    if (!text || !*text)
+    {
+        return -1;
+    }
+    char *end;
+    long value = strtol(text, &end, 10);
+    return *end == '\0' ? value : -1;
+}
+
+void DeviceConfig::read(JsonVariantConst json, DeviceConfigFields *fields)
+{
+    fields->server = json["server"].as<const char *>();
+    fields->client = json["client"].as<const char *>();
+    fields->user = json["user"].as<const char *>();
+    fields->pass = json["pass"].as<const char *>();
+    fields->ssid = json["ssid"].as<const char *>();
+    fields->password = json["password"].as<const char *>();
+    fields->port = readPort(json["port"]);
+}
+
+DeviceConfigResult DeviceConfig::check(const DeviceConfigFields *fields)
+{
+    if (!fields->client)
+    {
+        return DEVICE_CONFIG_NONE;
+    }
+    if (!fits(fields->client, DEVICE_CONFIG_FIELD_MAX, true))
+    {
+        return DEVICE_CONFIG_BAD_CLIENT;
+    }
+    if (!fits(fields->server, DEVICE_CONFIG_FIELD_MAX, true))
+    {
+        return DEVICE_CONFIG_BAD_SERVER;
+    }
+    if (fields->port < 1 || fields->port > 65535)
+    {
+        return DEVICE_CONFIG_BAD_PORT;
+    }
+    if (!fits(fields->user, DEVICE_CONFIG_FIELD_MAX, false) || !fits(fields->pass, DEVICE_CONFIG_FIELD_MAX, false))
+    {
+        return DEVICE_CONFIG_BAD_CREDENTIALS;
+    }
+    if (!fits(fields->ssid, DEVICE_CONFIG_SSID_MAX, false))
+    {
+        return DEVICE_CONFIG_BAD_SSID;
+    }
+    if (!fits(fields->password, DEVICE_CONFIG_PASSWORD_MAX, false))
+    {
+        return DEVICE_CONFIG_BAD_PASSWORD;
+    }
+    return DEVICE_CONFIG_OK;
+}
+
+const char *DeviceConfig::resultName(DeviceConfigResult result)
+{
+    switch (result)
+    {
+    case DEVICE_CONFIG_OK:
+        return "ok";
+    case DEVICE_CONFIG_NONE:
+        return "none";
+    case DEVICE_CONFIG_BAD_CLIENT:
+        return "bad client";
+    case DEVICE_CONFIG_BAD_SERVER:
+        return "bad server";
+    case DEVICE_CONFIG_BAD_PORT:
+        return "bad port";
+    case DEVICE_CONFIG_BAD_CREDENTIALS:
+        return "bad user / pass";
+    case DEVICE_CONFIG_BAD_SSID:
+        return "bad ssid";
+    case DEVICE_CONFIG_BAD_PASSWORD:
+        return "bad password";
+    default:
+        return "?";
+    }
+}
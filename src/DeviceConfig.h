@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <ArduinoJson.h>
+
+// ===================================================================
+// Device config sent by the web installer over serial (no Arduino
+// dependency), saved as CONFIG_FILE before restart:
+// {"server":"mqtt.netpie.io","port":1883,"client":"..","user":"..",
+//  "pass":"..","ssid":"..","password":".."}
+// A message without "client" is a command ("restart", "perf" ...),
+// not a config. A config that can't connect is rejected instead of
+// being saved and restarted into.
+// ===================================================================
+
+#define DEVICE_CONFIG_FIELD_MAX     128 // server / client / user / pass
+#define DEVICE_CONFIG_SSID_MAX      32  // 802.11
+#define DEVICE_CONFIG_PASSWORD_MAX  64  // WPA2 passphrase (63) or hex PSK (64)
+
+// Fields as read from the JSON, NULL = missing
+struct DeviceConfigFields {
+    const char* server;
+    const char* client;
+    const char* user;
+    const char* pass;
+    const char* ssid;
+    const char* password;
+    long port;              // -1 = missing / not a number
+};
+
+enum DeviceConfigResult {
+    DEVICE_CONFIG_OK = 0,
+    DEVICE_CONFIG_NONE,             // No "client", not a config
+    DEVICE_CONFIG_BAD_CLIENT,
+    DEVICE_CONFIG_BAD_SERVER,
+    DEVICE_CONFIG_BAD_PORT,
+    DEVICE_CONFIG_BAD_CREDENTIALS,  // user / pass too long
+    DEVICE_CONFIG_BAD_SSID,
+    DEVICE_CONFIG_BAD_PASSWORD
+};
+
+class DeviceConfig {
+public:
+    // "port" can be a number or a numeric string (older installer)
+    static void read(JsonVariantConst json, DeviceConfigFields* fields);
+
+    // client, server and port 1..65535 required, ssid / password optional (set from the UI)
+    static DeviceConfigResult check(const DeviceConfigFields* fields);
+
+    static const char* resultName(DeviceConfigResult result);
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+
+// ===================================================================
+// Pulse count -> water volume (no Arduino dependency)
+// Total pulse count must only go up, a smaller value is ignored.
+// Delta is read first and committed only after it was reported, so
+// a failed upload is sent again with the next interval.
+// ===================================================================
+
+#define FLOW_COUNTER_DEFAULT_PULSES_PER_LITER 450.0f // Used when the configured value is 0 / negative
+
+class FlowCounter {
+  public:
+    FlowCounter(float pulsesPerLiter = FLOW_COUNTER_DEFAULT_PULSES_PER_LITER)
+      : total(0), reported(0), pulsesPerLiter(FLOW_COUNTER_DEFAULT_PULSES_PER_LITER) {
+      setPulsesPerLiter(pulsesPerLiter);
+    }
+
+    // PCNT counter is 16 bit and reset to 0 at highLimit, the ISR count how many times
+    static uint32_t fromPcnt(uint32_t overflows, int16_t count, int16_t highLimit) {
+      return (overflows * (uint32_t) highLimit) + (uint32_t) count;
+    }
+
+    void setPulsesPerLiter(float value) {
+      if (value > 0.0f) {
+        pulsesPerLiter = value;
+      }
+    }
+    float getPulsesPerLiter() const { return pulsesPerLiter; }
+
+    void update(uint32_t totalPulses) {
+      if ((int32_t)(totalPulses - total) > 0) { // Wrap safe
+        total = totalPulses;
+      }
+    }
+
+    uint32_t getTotalPulses() const { return total; }
+    float getTotalLiters() const { return toLiters(total); }
+
+    uint32_t getDeltaPulses() const { return total - reported; } // Not reported yet
+    void commit(uint32_t pulses) { reported += pulses; }
+
+    float toLiters(uint32_t pulses) const { return pulses / pulsesPerLiter; }
+
+  private:
+    uint32_t total;
+    uint32_t reported;
+    float pulsesPerLiter;
+};
@@ -0,0 +1,121 @@
+#include <Arduino.h>
+#include "FlowMeter.h"
+#include "FlowCounter.h"
+#include "PinConfigs.h"
+#include "UserConfigs.h"
+#include <driver/pcnt.h>
+
+static const char * TAG = "FlowMeter";
+
+typedef struct {
+  pcnt_unit_t unit;
+  volatile uint32_t overflow; // High limit reach count, from ISR
+  FlowCounter counter;
+} FlowMeterChannel;
+
+static FlowMeterChannel meters[FLOW_METER_MAX];
+static int meterCount = 0;
+static portMUX_TYPE metersMux = portMUX_INITIALIZER_UNLOCKED;
+
+static void IRAM_ATTR FlowMeter_overflowISR(void *arg) {
+  FlowMeterChannel *meter = (FlowMeterChannel *) arg;
+  uint32_t status = 0;
+  pcnt_get_event_status(meter->unit, &status);
+  if (status & PCNT_EVT_H_LIM) { // Counter reset to 0 by hardware
+    portENTER_CRITICAL_ISR(&metersMux);
+    meter->overflow++;
+    portEXIT_CRITICAL_ISR(&metersMux);
+  }
+}
+
+static uint32_t FlowMeter_readPulses(int index) {
+  int16_t count = 0;
+  portENTER_CRITICAL(&metersMux);
+  pcnt_get_counter_value(meters[index].unit, &count);
+  uint32_t total = FlowCounter::fromPcnt(meters[index].overflow, count, FLOW_PCNT_HIGH_LIMIT);
+  portEXIT_CRITICAL(&metersMux);
+  return total;
+}
+
+bool FlowMeter_init() {
+  static const int pins[] = FLOW_METER_PINS;
+  if (meterCount > 0) {
+    return true;
+  }
+
+  bool isrInstalled = false;
+  for (int i = 0; (i < (int)(sizeof(pins) / sizeof(pins[0]))) && (meterCount < FLOW_METER_MAX); i++) {
+    FlowMeterChannel &meter = meters[meterCount];
+    meter.unit = (pcnt_unit_t) meterCount;
+    meter.overflow = 0;
+    meter.counter = FlowCounter(FLOW_PULSES_PER_LITER);
+
+    pcnt_config_t config = { };
+    config.pulse_gpio_num = pins[i];
+    config.ctrl_gpio_num = PCNT_PIN_NOT_USED;
+    config.lctrl_mode = PCNT_MODE_KEEP;
+    config.hctrl_mode = PCNT_MODE_KEEP;
+    config.pos_mode = PCNT_COUNT_INC; // Count rising edge
+    config.neg_mode = PCNT_COUNT_DIS;
+    config.counter_h_lim = FLOW_PCNT_HIGH_LIMIT;
+    config.counter_l_lim = 0;
+    config.unit = meter.unit;
+    config.channel = PCNT_CHANNEL_0;
+    if (pcnt_unit_config(&config) != ESP_OK) {
+      ESP_LOGE(TAG, "PCNT config fail on pin %d", pins[i]);
+      continue;
+    }
+
+    pcnt_set_filter_value(meter.unit, FLOW_PCNT_FILTER);
+    pcnt_filter_enable(meter.unit);
+    pcnt_event_enable(meter.unit, PCNT_EVT_H_LIM);
+    pcnt_counter_pause(meter.unit);
+    pcnt_counter_clear(meter.unit);
+
+    if (!isrInstalled) {
+      pcnt_isr_service_install(0);
+      isrInstalled = true;
+    }
+    pcnt_isr_handler_add(meter.unit, FlowMeter_overflowISR, &meter);
+    pcnt_intr_enable(meter.unit);
+    pcnt_counter_resume(meter.unit);
+
+    ESP_LOGI(TAG, "Flow meter %d on pin %d, %.1f pulses/L", meterCount, pins[i], FLOW_PULSES_PER_LITER);
+    meterCount++;
+  }
+
+  return meterCount > 0;
+}
+
+int FlowMeter_count() {
+  return meterCount;
+}
+
+void FlowMeter_setPulsesPerLiter(int index, float pulsesPerLiter) {
+  if ((index >= 0) && (index < meterCount)) {
+    meters[index].counter.setPulsesPerLiter(pulsesPerLiter);
+  }
+}
+
+float FlowMeter_getTotalLiters(int index) {
+  if ((index < 0) || (index >= meterCount)) {
+    return 0;
+  }
+  meters[index].counter.update(FlowMeter_readPulses(index));
+  return meters[index].counter.getTotalLiters();
+}
+
+void FlowMeter_getDelta(FlowDelta *delta) {
+  memset(delta, 0, sizeof(FlowDelta));
+  for (int i = 0; i < meterCount; i++) {
+    meters[i].counter.update(FlowMeter_readPulses(i));
+    delta->pulses[i] = meters[i].counter.getDeltaPulses();
+    delta->liters += meters[i].counter.toLiters(delta->pulses[i]);
+  }
+}
+
+void FlowMeter_commitDelta(const FlowDelta *delta) {
+  for (int i = 0; i < meterCount; i++) {
+    meters[i].counter.commit(delta->pulses[i]);
+  }
+}
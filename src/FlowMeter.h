@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ===================================================================
+// Flow meters on the digital inputs, pulses counted by PCNT hardware
+// ===================================================================
+
+#define FLOW_METER_MAX          3     // D1 - D3
+#define FLOW_PCNT_HIGH_LIMIT    10000 // Counter overflow interrupt every 10000 pulses
+#define FLOW_PCNT_FILTER        1023  // APB cycles (12.5 ns), ignore glitch shorter than ~13 us
+
+// Pulses of every meter read at the same time, commit after it was sent
+typedef struct {
+  uint32_t pulses[FLOW_METER_MAX];
+  float liters; // Sum of every meter
+} FlowDelta;
+
+bool FlowMeter_init() ; // Start counting on FLOW_METER_PINS
+int FlowMeter_count() ;
+void FlowMeter_setPulsesPerLiter(int index, float pulsesPerLiter) ;
+float FlowMeter_getTotalLiters(int index) ;
+void FlowMeter_getDelta(FlowDelta *delta) ; // Volume since the last commit
+void FlowMeter_commitDelta(const FlowDelta *delta) ;
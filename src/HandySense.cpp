@@ -12,14 +12,40 @@
 #include <EEPROM.h>
 #include "ArtronShop_RTC.h"
 #include "Sensor.h"
+#include "FlowMeter.h"
 #include "UI.h"
 #include "PinConfigs.h"
 #include "ApiClient.h"
 #include "SwitchApiClient.h"
 #include "AutomationApiClient.h"
+#include "ApiWorker.h"
+#include "TimeService.h"
+#include "I2CBus.h"
+#include "Rs485Bus.h"
+#include "LogBuffer.h"
+#include "Perf.h"
+#include "HttpTransport.h"
+#include "PollIntervals.h"
+#include "SystemHealth.h"
+#include "Trace.h"
+#include "SwitchSync.h"
+#include "DeviceConfig.h"
+#if RTC_INT_PIN >= 0
+#include <driver/gpio.h>
+#include <esp_sleep.h>
+#endif
+
+// ===================== Switch API Control Variables =====================
+// ต้องประกาศก่อน setRelayState ไม่งั้น #if ข้างในจะถูกตัดทิ้งตอน compile
+#define USE_SWITCH_API_CONTROL 2
+// AUTOMATION_API_ENABLE is defined in AutomationApiClient.h - don't redefine here
+
+// สถานะ + version ของแต่ละ switch (relay 0-3) ที่ sync กับ Switch API
+// poll ที่เก่ากว่า version ที่ส่งไปจะถูกทิ้ง relay จึงไม่ toggle กลับไปค่าเดิม
+static SwitchSyncState switchSync[4] = {};
+static portMUX_TYPE switchSyncMux = portMUX_INITIALIZER_UNLOCKED; // ApiWorker ack จาก core 0
+// =====================================================================
 
-// ป้องกัน loop toggle ระหว่าง sensor กับ API sync
-static bool ignoreNextSync[4] = {false, false, false, false};
 // **[แก้ไข]** ใช้ RelayStatus เป็นตัวแปรหลักในการจดจำสถานะของรีเลย์ (0=OFF, 1=ON)
 int RelayStatus[4] = {0, 0, 0, 0};
 
@@ -30,11 +56,16 @@ static void SoilMaxMin_setting(String topic, String message, unsigned int length
 void TaskWifiStatus(void *pvParameters);
 void TaskWaitSerial(void *WaitSerial);
 static void sent_dataTimer(String topic, String message);
+static void publishLogHistory(int kbytes);
+static void publishLogStep();
 static void ControlRelay_Bytimmer();
 /* relay control function removed - timer now only updates time for UI */
 static void TempMaxMin_setting(String topic, String message, unsigned int length);
 void ControlRelay_Bymanual(String topic, String message, unsigned int length);
-static bool updateSwitchStateToAPI(int relayId, int state);
+static bool updateSwitchStateToAPI(int relayId, int state, uint32_t version, const char *origin);
+#if RTC_INT_PIN >= 0
+static void setupRtcAlarm();
+#endif
 // static void syncAllRelaysToAPI();
 int check_sendData_status = 0;
 
@@ -51,11 +82,7 @@ static const char *TAG = "HandySense";
 
 #define CONFIG_FILE "/configs.json"
 
-// ประกาศใช้เวลาบน Internet
-const char *ntpServer = "pool.ntp.org";
-const char *nistTime = "time.nist.gov";
-const long gmtOffset_sec = 7 * 3600;
-const int daylightOffset_sec = 0;
+// เวลาปัจจุบัน (NTP server / timezone อยู่ใน TimeService.h)
 int hourNow, minuteNow, secondNow, dayNow, monthNow, yearNow, weekdayNow;
 int currentTimerNow = 0;
 int dayOfWeekNow = 0;
@@ -87,6 +114,58 @@ ArtronShop_RTC rtc(&Wire, PCF8563);
 WiFiClient espClient;
 PubSubClient client(espClient);
 
+// PubSubClient ไม่ thread-safe: main loop (client.loop + callback, UI, diag) กับ TaskWifiStatus
+// (connect, shadow update) ใช้ client ตัวเดียวกัน ทุกการเรียกต้องถือ mqttMutex
+// recursive เพราะ callback ถูกเรียกจากใน client.loop() แล้ว publish ต่อ
+#define MQTT_LOCK_TIMEOUT 50 // ms, main loop ไม่รอ TaskWifiStatus ที่ค้างอยู่ใน connect
+static SemaphoreHandle_t mqttMutex = NULL;
+
+class MqttLock
+{
+public:
+  MqttLock(TickType_t wait = pdMS_TO_TICKS(MQTT_LOCK_TIMEOUT))
+  {
+    locked = mqttMutex && xSemaphoreTakeRecursive(mqttMutex, wait) == pdTRUE;
+  }
+  ~MqttLock()
+  {
+    if (locked)
+      xSemaphoreGiveRecursive(mqttMutex);
+  }
+
+  bool isLocked() const { return locked; }
+
+private:
+  bool locked;
+};
+
+// ไม่ได้ lock = ส่งไม่สำเร็จ ผู้เรียกส่งใหม่รอบถัดไปเหมือน publish ล้มเหลว
+static bool mqttPublish(const char *topic, const char *payload)
+{
+  MqttLock lock;
+  return lock.isLocked() && client.publish(topic, payload);
+}
+
+bool HandySense_mqttConnected()
+{
+  MqttLock lock;
+  return lock.isLocked() && client.connected();
+}
+
+// สำหรับ TaskWifiStatus ซึ่งเป็นเจ้าของการเชื่อมต่อ: รอ lock จนได้
+// main loop ถือ lock นานไม่ได้แปลว่าหลุด ไม่ต้องเข้า reconnect ใหม่
+static bool mqttConnectedWait()
+{
+  MqttLock lock(portMAX_DELAY);
+  return client.connected();
+}
+
+static bool mqttConnect()
+{
+  MqttLock lock(portMAX_DELAY);
+  return client.connect(mqtt_Client.c_str(), mqtt_username.c_str(), mqtt_password.c_str());
+}
+
 // ประกาศใช้ WiFiUDP
 WiFiUDP ntpUDP;
 NTPClient timeClient(ntpUDP);
@@ -98,8 +177,16 @@ unsigned long previousTime_Temp_soil = 0;
 unsigned long previousTime_brightness = 0;
 
 // ประกาศตัวแปรกำหนดการนับเวลาเริ่มต้น
-unsigned long previousTime_Update_data = 0;
-const unsigned long eventInterval_publishData = 10 * 1000; // ส่งทุก 10 วินาที
+unsigned long previousTime_Update_data = 0; // ส่งทุก PollIntervals::get(POLL_TELEMETRY) (10 วินาที)
+
+// Fleet pacing: ทุกเครื่องใช้ interval เดียวกัน ถ้าบูตพร้อมกัน (ไฟดับ/ไฟมา) จะยิง API พร้อมกันทุกรอบ
+// สุ่ม phase ของ switch poll / telemetry / automation sync ใหม่ทุกครั้งที่ต่อเน็ตได้
+// และถอยแบบ exponential + jitter ตอนต่อ MQTT ไม่ติด
+#define NET_CONNECT_JITTER_MAX   10000 // ms, หน่วง Initial Automation Sync หลังต่อได้
+#define MQTT_RETRY_MIN           500   // ms
+#define MQTT_RETRY_MAX           30000 // ms
+static unsigned long lastSwitchPoll = 0;
+static unsigned long lastAutomationSync = 0;
 
 float difference_soil = 20.00, // ค่าความชื้นดินแตกต่างกัน +-20 % เมื่อไรส่งค่าขึ้น Web app ทันที
     difference_temp = 4.00;    // ค่าอุณหภูมิแตกต่างกัน +- 4 C เมื่อไรส่งค่าขึ้น Web app ทันที
@@ -110,11 +197,7 @@ float humidity = 0;
 float lux_44009 = 0;
 float soil = 0;
 
-// Array สำหรับทำ Movie Arg. ของค่าเซ็นเซอร์ทุก ๆ ค่า
-static float ma_temp[5];
-static float ma_hum[5];
-static float ma_soil[5];
-static float ma_lux[5];
+// ค่าเซ็นเซอร์ผ่าน filter (median / EMA / ตัดค่ากระโดด) มาแล้วจาก SensorRegistry
 
 // สำหรับเก็บค่าเวลาจาก Web App
 int t[20];
@@ -140,6 +223,7 @@ int relay_pin[4] = {O1_PIN, O2_PIN, O3_PIN, O4_PIN};
 // **[แก้ไข]** สร้างฟังก์ชันกลางสำหรับควบคุมรีเลย์ทั้งหมดในที่เดียว
 void setRelayState(int relayId, bool turnOn, const char *source)
 {
+  TRACE_SCOPE("setRelayState");
   if (relayId < 0 || relayId >= 4)
     return;
 
@@ -164,29 +248,31 @@ void setRelayState(int relayId, bool turnOn, const char *source)
 
   // Use explicit HIGH/LOW to avoid ambiguity
   digitalWrite(relay_pin[relayId], turnOn ? HIGH : LOW);
+  TRACE_INSTANT(turnOn ? "relay.on" : "relay.off", relayId);
   UI_updateOutputStatus(relayId, turnOn);
   bool oldState = (RelayStatus[relayId] == 1);
   RelayStatus[relayId] = turnOn ? 1 : 0;
   check_sendData_status = 1; // ตั้งค่าสถานะเพื่อส่งข้อมูลไป MQTT
 
-  // ส่ง log กลับไปที่ Automation API (ถ้าเปิดใช้งาน)
+  // ส่ง log กลับไปที่ Automation API (ถ้าเปิดใช้งาน) ผ่าน background queue
 #if defined(AUTOMATION_API_ENABLE) && AUTOMATION_API_ENABLE
-  AutomationApiClient::logEvent(relayId,
-                                turnOn ? "turn_on" : "turn_off",
-                                source,
-                                oldState,
-                                RelayStatus[relayId],
-                                -1,
-                                0.0f,
-                                NULL);
+  ApiWorker::queueLogEvent(relayId,
+                           turnOn ? "turn_on" : "turn_off",
+                           source,
+                           oldState,
+                           RelayStatus[relayId]);
 #endif
 
-// ถ้าใช้ API Control Mode 2 (Hybrid), ให้อัปเดตสถานะไปที่ API ด้วย
+// ถ้าใช้ API Control Mode 2 (Hybrid), ให้อัปเดตสถานะไปที่ API ด้วย (ทุกที่มา ยกเว้นที่มาจาก API เอง)
 #if USE_SWITCH_API_CONTROL >= 1
-  // Prevent immediate loop: ignore the next API sync for this relay
-  ignoreNextSync[relayId] = true;
-  // Update Switch API (map relay 0..3 -> switch 1..4)
-  updateSwitchStateToAPI(relayId, RelayStatus[relayId]);
+  if (strcmp(source, "API_SYNC") != 0)
+  {
+    portENTER_CRITICAL(&switchSyncMux);
+    uint32_t version = SwitchSync::change(&switchSync[relayId], RelayStatus[relayId]);
+    portEXIT_CRITICAL(&switchSyncMux);
+    // Update Switch API (map relay 0..3 -> switch 1..4)
+    updateSwitchStateToAPI(relayId, RelayStatus[relayId], version, source);
+  }
 #endif
 }
 
@@ -215,16 +301,10 @@ float Max_Temp[4], Min_Temp[4];
 unsigned int status_manual[4];
 
 TaskHandle_t WifiStatus, WaitSerial;
+#define WIFI_STATUS_TASK_STACK_SIZE  4096
+#define WAIT_SERIAL_TASK_STACK_SIZE  8192
 unsigned int oldTimer;
 
-// ===================== Switch API Control Variables =====================
-#define USE_SWITCH_API_CONTROL 2
-// AUTOMATION_API_ENABLE is defined in AutomationApiClient.h - don't redefine here
-// ================================================================
-
-int lastKnownSwitchStates[4] = {0, 0, 0, 0};
-// =====================================================================
-
 // สถานะการเชื่อมต่อ wifi
 #define cannotConnect 0
 #define wifiConnected 1
@@ -242,6 +322,7 @@ unsigned long time_restart = 0;
 /* --------- Callback function get data from web ---------- */
 static void callback(String topic, byte *payload, unsigned int length)
 {
+  TRACE_SCOPE("mqtt.callback");
   ESP_LOGV(TAG, "Message arrived [%s]", topic.c_str());
 
   String message;
@@ -266,20 +347,8 @@ static void callback(String topic, byte *payload, unsigned int length)
     status_manual[1] = 0;
     status_manual[2] = 0;
     status_manual[3] = 0;
+    // Hybrid Mode: setRelayState ส่งสถานะ (พร้อม version) ไป API เองเมื่อ relay เปลี่ยน
     ControlRelay_Bymanual(topic, message, length);
-
-// ========== Hybrid Mode: ส่งสถานะไป API ด้วย ==========
-#if USE_SWITCH_API_CONTROL == 2
-    // ดึง Relay ID จาก topic (เช่น @private/led0 -> 0)
-    int relayId = topic.substring(topic.length() - 1).toInt();
-    if (relayId >= 0 && relayId <= 3)
-    {
-      int state = RelayStatus[relayId]; // 0 or 1
-      ESP_LOGI(TAG, "MQTT changed relay %d to %d, syncing to API...", relayId, state);
-      updateSwitchStateToAPI(relayId, state);
-    }
-#endif
-    // =======================================================
   }
 #endif
   // ================================================================
@@ -294,18 +363,17 @@ static void callback(String topic, byte *payload, unsigned int length)
   {
     SoilMaxMin_setting(topic, message, length);
   }
-  // After loading config, push current relay states to Switch API when WiFi available
-  if (WiFi.status() == WL_CONNECTED)
+  /* ------- topic diagnostics ------- */
+  else if (topic == "@private/diag/log")
   {
-    // syncAllRelaysToAPI();
-    // Sync all relay states to Switch API (MAP 0-3 -> switch 1-4)
-    for (int i = 0; i < 4; i++)
-    {
-      int state = RelayStatus[i];
-      int switchId = RELAY_ID_TO_SWITCH_ID(i);
-      ESP_LOGD(TAG, "syncAllRelaysToAPI: relay %d -> switch %d state=%d", i, switchId, state);
-      updateSwitchStateToAPI(i, state);
-    }
+    publishLogHistory(message.toInt()); // ข้อความ = จำนวน KB ย้อนหลัง
+  }
+  else if (topic == "@private/diag/loglevel")
+  {
+    // ข้อความ "TAG=level" เช่น "Sensor=debug" หรือ "*=warn"
+    int sep = message.indexOf('=');
+    if (sep > 0)
+      LogBuffer::setLevel(message.substring(0, sep).c_str(), message.substring(sep + 1).c_str());
   }
 }
 
@@ -319,12 +387,118 @@ static void sent_dataTimer(String topic, String message)
   _payload += message;
   _payload += "\"}}";
   ESP_LOGV(TAG, "incoming : %s", _payload.c_str());
-  client.publish("@shadow/data/update", (char *)_payload.c_str());
+  mqttPublish("@shadow/data/update", _payload.c_str());
+}
+
+/* ----------------------- Diagnostics: log ย้อนหลัง --------------------------- */
+// ส่งทีละข้อความ (LOG_MQTT_MESSAGE_MAX) ต่อรอบ loop ไม่ถือ client ตลอดการส่งทั้ง ring
+static uint32_t logDumpPosition = 0;
+static uint32_t logDumpEnd = 0;
+
+// เรียกจาก callback: แค่ตั้งช่วงที่จะส่ง publishLogStep() ใน loop เป็นตัวส่ง
+static void publishLogHistory(int kbytes)
+{
+  if (kbytes <= 0)
+    kbytes = LOG_MQTT_DEFAULT_KB;
+
+  uint32_t end = LogBuffer::getWritePosition();
+  uint32_t position = LogBuffer::getOldestPosition();
+  if ((end - position) > (uint32_t)kbytes * 1024)
+    position = end - ((uint32_t)kbytes * 1024);
+  logDumpPosition = position;
+  logDumpEnd = end;
+}
+
+static void publishLogStep()
+{
+  if (logDumpPosition >= logDumpEnd)
+    return;
+  MqttLock lock; // beginPublish ... endPublish ต้องไม่มี publish อื่นแทรก
+  if (!lock.isLocked())
+    return; // ไม่ว่าง ส่งรอบถัดไป
+  if (!client.connected())
+  {
+    logDumpPosition = logDumpEnd; // หลุดแล้ว เลิกส่ง ขอใหม่ได้
+    return;
+  }
+  uint32_t position = max(logDumpPosition, LogBuffer::getOldestPosition()); // ถูกเขียนทับระหว่างส่ง
+  if (position >= logDumpEnd)
+  {
+    logDumpPosition = logDumpEnd;
+    return;
+  }
+  uint32_t messageLen = min((uint32_t)LOG_MQTT_MESSAGE_MAX, logDumpEnd - position);
+  if (!client.beginPublish(LOG_MQTT_TOPIC, messageLen, false))
+  {
+    logDumpPosition = logDumpEnd;
+    return;
+  }
+  char chunk[LOG_DRAIN_CHUNK];
+  uint32_t sent = 0;
+  while (sent < messageLen)
+  {
+    size_t len = LogBuffer::read(position + sent, chunk, min((uint32_t)sizeof(chunk), messageLen - sent));
+    if (len == 0) // ข้อมูลหายไปแล้ว เติมให้ครบความยาวที่ประกาศไว้
+    {
+      len = min((uint32_t)sizeof(chunk), messageLen - sent);
+      memset(chunk, ' ', len);
+    }
+    client.write((const uint8_t *)chunk, len);
+    sent += len;
+  }
+  client.endPublish();
+  logDumpPosition = position + messageLen;
+}
+
+/* ----------------------- Diagnostics: เวลาที่ใช้ของแต่ละส่วน / HTTP --------------------------- */
+static void publishSummary(const char *topic, const char *summary, size_t len)
+{
+  MqttLock lock; // beginPublish ... endPublish ต้องไม่มี publish อื่นแทรก
+  if (!lock.isLocked() || len == 0 || !client.beginPublish(topic, len, false))
+    return;
+  client.write((const uint8_t *)summary, len);
+  client.endPublish();
+}
+
+// ส่งทีละหัวข้อต่อรอบ loop (part 0 .. PERF_SUMMARY_PARTS - 1) ไม่ถือ client ติดกันหลายข้อความ
+#define PERF_SUMMARY_PARTS 5
+static void publishPerfSummary(uint8_t part)
+{
+  static char summary[PERF_SUMMARY_SIZE]; // ใช้ร่วมกันทุกหัวข้อ
+  switch (part)
+  {
+  case 0:
+    publishSummary(PERF_MQTT_TOPIC, summary, Perf::summaryJSON(summary, sizeof(summary)));
+    break;
+  case 1:
+    publishSummary(HTTP_METRICS_MQTT_TOPIC, summary, HttpTransport::summaryJSON(summary, sizeof(summary)));
+    break;
+  case 2:
+    publishSummary(SYSTEM_HEALTH_MQTT_TOPIC, summary, SystemHealth::summaryJSON(summary, sizeof(summary)));
+    break;
+  case 3:
+    publishSummary(I2C_BUS_MQTT_TOPIC, summary, I2CBus::summaryJSON(summary, sizeof(summary)));
+    break;
+  case 4:
+    publishSummary(RS485_MQTT_TOPIC, summary, Rs485Bus::summaryJSON(summary, sizeof(summary)));
+    break;
+  }
+}
+
+// เรียกจาก SystemHealth::update() ใน loop เมื่อ heap / stack ต่ำกว่าเกณฑ์ (ครั้งเดียวจนกว่าจะกลับมาปกติ)
+static void onLowMemory(uint8_t alerts, const char *message)
+{
+  if (!HandySense_mqttConnected())
+    return;
+  char payload[192];
+  int len = snprintf(payload, sizeof(payload), "{\"alert\":%u,\"message\":\"%s\"}", alerts, message);
+  publishSummary(SYSTEM_HEALTH_MQTT_TOPIC, payload, min(len, (int)sizeof(payload) - 1));
 }
 
 /* --------- UpdateData_To_Server --------- */
 static void UpdateData_To_Server()
 {
+  PERF_SCOPE("telemetry");
 #if API_ENABLE_DOTNET
   // ถ้า humidity == -99.0 หรือ temp == 0.0 ไม่ต้องส่งค่าไป API
   if (humidity == -99.0f || temp == 0.0f)
@@ -332,17 +506,44 @@ static void UpdateData_To_Server()
     ESP_LOGW(TAG, "Skip sending to .NET API: humidity=%.1f temp=%.1f", humidity, temp);
     return;
   }
+  FlowDelta water;
+  FlowMeter_getDelta(&water);
+
+#if TELEMETRY_MQTT_ENABLE
+  // ส่งผ่าน session NETPIE ที่เปิดค้างไว้แล้ว (~60 byte MessagePack แทน HTTP POST ใหม่ทุกรอบ)
+  if (HandySense_mqttConnected())
+  {
+    uint8_t packet[TELEMETRY_BINARY_SIZE];
+    size_t len = ApiClient::buildTelemetryBinary(temp, humidity, soil, lux_44009, water.liters, 0.0, packet, sizeof(packet));
+    bool published = false;
+    if (len > 0)
+    {
+      MqttLock lock;
+      published = lock.isLocked() && client.publish(TELEMETRY_MQTT_TOPIC, packet, len);
+    }
+    if (published)
+    {
+      FlowMeter_commitDelta(&water);
+      ESP_LOGV(TAG, " Send Data Complete (MQTT, %u bytes) ", (unsigned)len);
+      return;
+    }
+    ESP_LOGW(TAG, "Telemetry publish failed, fallback to .NET API");
+  }
+#endif
+
+  // HTTP: MQTT ปิดอยู่ / ยังไม่ต่อ / publish ไม่ผ่าน
   bool apiResult = ApiClient::sendTelemetryToDotNetAPI(
-      temp,      // temp_c
-      humidity,  // hum_rh
-      soil,      // hum_dirt (ความชื้นในดิน)
-      lux_44009, // light_lux (already in Klux from sensor)
-      0.0,       // water_delta_l (waiting for sensor)
-      0.0        // energy_delta_kwh (waiting for sensor)
+      temp,         // temp_c
+      humidity,     // hum_rh
+      soil,         // hum_dirt (ความชื้นในดิน)
+      lux_44009,    // light_lux (already in Klux from sensor)
+      water.liters, // water_delta_l (น้ำที่ใช้ตั้งแต่ส่งครั้งก่อน)
+      0.0           // energy_delta_kwh (waiting for sensor)
   );
 
   if (apiResult)
   {
+    FlowMeter_commitDelta(&water); // ส่งไม่สำเร็จ ยอดน้ำจะไปรวมกับรอบถัดไป
     ESP_LOGV(TAG, " Send Data Complete (.NET API) ");
   }
   else
@@ -365,7 +566,7 @@ static void sendStatus_RelaytoWeb()
                "\",\"led2\":\"" + String(RelayStatus[2]) +
                "\",\"led3\":\"" + String(RelayStatus[3]) + "\"}}";
     ESP_LOGV(TAG, "_payload : %s", _payload.c_str());
-    if (client.publish("@shadow/data/update", _payload.c_str()))
+    if (mqttPublish("@shadow/data/update", _payload.c_str()))
     {
       check_sendData_status = 0;
       ESP_LOGV(TAG, "Send Complete Relay ");
@@ -379,35 +580,48 @@ static void sendStatus_RelaytoWeb()
 static void syncSwitchStatesFromAPI()
 {
 #if USE_SWITCH_API_CONTROL
-  static unsigned long lastSyncTime = 0;
   unsigned long currentTime = millis();
-  // ดึงสถานะทุก 500ms (0.5 วินาที)
-  if (currentTime - lastSyncTime >= SWITCH_POLL_INTERVAL)
+  // ดึงสถานะทุก POLL_SWITCH (phase สุ่มใน randomizeApiPhases)
+  if (currentTime - lastSwitchPoll >= PollIntervals::get(POLL_SWITCH))
   {
-    lastSyncTime = currentTime;
+    lastSwitchPoll = currentTime;
+    if (!HttpTransport::isAvailable(HTTP_EP_SWITCH))
+    {
+      return; // Circuit open, the probe go out when the backoff expire
+    }
+    TRACE_SCOPE("switch.sync");
     int apiStates[4];
-    if (SwitchApiClient::getAllSwitchStates(apiStates))
+    uint32_t apiVersions[4];
+    if (SwitchApiClient::getAllSwitchStates(apiStates, apiVersions))
     {
       for (int i = 0; i < 4; i++)
       {
-        if (ignoreNextSync[i])
+        portENTER_CRITICAL(&switchSyncMux);
+        SwitchSyncAction action = SwitchSync::remote(&switchSync[i], apiStates[i], apiVersions[i]);
+        uint32_t version = switchSync[i].version;
+        int state = switchSync[i].state;
+        portEXIT_CRITICAL(&switchSyncMux);
+
+        if (action == SWITCH_SYNC_STALE)
+        {
+          // Echo ของค่าก่อนหน้าที่เรายังส่งไม่เสร็จ ทิ้งได้เลย
+          ESP_LOGD(TAG, "Switch %d: drop stale v%lu (local v%lu)", i + 1, (unsigned long)apiVersions[i], (unsigned long)version);
+          TRACE_INSTANT("sync.stale", i);
+        }
+        else if (action == SWITCH_SYNC_SEND)
         {
-          ESP_LOGD(TAG, "[LOOP-PROTECT] Ignore API sync for relay %d", i);
-          ignoreNextSync[i] = false;
-          lastKnownSwitchStates[i] = apiStates[i];
-          continue;
+          // Server ยังไม่มีสถานะล่าสุดของเครื่อง (หลังบูต / PUT หาย)
+          ESP_LOGI(TAG, "Switch %d: server v%lu behind, send %s v%lu", i + 1, (unsigned long)apiVersions[i], state ? "ON" : "OFF", (unsigned long)version);
+          updateSwitchStateToAPI(i, state, version, "DEVICE_SYNC");
         }
-        if (lastKnownSwitchStates[i] != apiStates[i])
+        else if (action == SWITCH_SYNC_APPLY)
         {
-          ESP_LOGI(TAG, "Switch %d changed: %s -> %s",
-                   i + 1,
-                   lastKnownSwitchStates[i] ? "ON" : "OFF",
-                   apiStates[i] ? "ON" : "OFF");
-          lastKnownSwitchStates[i] = apiStates[i];
+          ESP_LOGI(TAG, "Switch %d changed: -> %s (v%lu)", i + 1, state ? "ON" : "OFF", (unsigned long)version);
+          TRACE_INSTANT(state ? "sync.api.on" : "sync.api.off", i);
           // เช็คว่าไม่มี automation ที่ enabled สำหรับ relay นี้ก่อน
           if (!isAutomationEnabledForRelay(i))
           {
-            if (apiStates[i] == 1)
+            if (state == 1)
             {
               Open_relay(i, "API_SYNC");
             }
@@ -418,7 +632,12 @@ static void syncSwitchStatesFromAPI()
           }
           else
           {
+            // Automation เป็นเจ้าของ relay: ยืนยันสถานะจริงกลับไปด้วย version ที่ใหม่กว่า
             ESP_LOGI(TAG, "Relay %d: Automation enabled, ignore API Switch command", i);
+            portENTER_CRITICAL(&switchSyncMux);
+            version = SwitchSync::change(&switchSync[i], RelayStatus[i]);
+            portEXIT_CRITICAL(&switchSyncMux);
+            updateSwitchStateToAPI(i, RelayStatus[i], version, "AUTOMATION");
           }
         }
       }
@@ -456,35 +675,63 @@ static bool isAutomationEnabledForRelay(int relayId)
   return false;
 }
 
+/* --------- randomizeApiPhases --------- */
+// ตั้งเวลา "ครั้งล่าสุด" ย้อนหลังแบบสุ่ม ครั้งแรกจะยิงภายใน [0, interval) แล้ววนตาม interval เดิม
+// เครื่องที่ต่อเน็ตพร้อมกันจึงกระจายกันตลอด ไม่ใช่แค่ครั้งแรก (random() = hardware RNG ต่างกันทุกเครื่อง)
+static void randomizeApiPhases()
+{
+  unsigned long now = millis();
+  unsigned long interval = PollIntervals::get(POLL_SWITCH);
+  lastSwitchPoll = now - interval + random(interval);
+  interval = PollIntervals::get(POLL_TELEMETRY);
+  previousTime_Update_data = now - interval + random(interval);
+  interval = PollIntervals::get(POLL_AUTOMATION_SYNC);
+  lastAutomationSync = now - interval + random(interval);
+}
+
+// X-Poll-Interval ใน response ของ endpoint ไหน ก็ปรับ interval ของ endpoint นั้น
+static void onIntervalHint(HttpEndpoint endpoint, uint32_t seconds)
+{
+  if (endpoint == HTTP_EP_SWITCH)
+    PollIntervals::hint(POLL_SWITCH, seconds);
+  else if (endpoint == HTTP_EP_AUTOMATION_SYNC)
+    PollIntervals::hint(POLL_AUTOMATION_SYNC, seconds);
+  else if (endpoint == HTTP_EP_TELEMETRY)
+    PollIntervals::hint(POLL_TELEMETRY, seconds);
+}
+
 /* --------- updateSwitchStateToAPI --------- */
-// Push a single relay state to the Switch API (maps relay 0-3 -> switch 1-4).
-static bool updateSwitchStateToAPI(int relayId, int state)
+// Queue a single relay state for the Switch API (maps relay 0-3 -> switch 1-4).
+// The HTTP PUT (and its retry) runs in ApiWorker, never in the caller.
+static bool updateSwitchStateToAPI(int relayId, int state, uint32_t version, const char *origin)
 {
 #if USE_SWITCH_API_CONTROL >= 1
   int mappedSwitchId = RELAY_ID_TO_SWITCH_ID(relayId);
-  ESP_LOGD(TAG, "Syncing relay %d -> switch %d state=%d", relayId, mappedSwitchId, state);
-  if (SwitchApiClient::updateSwitchState(mappedSwitchId, state))
-  {
-    lastKnownSwitchStates[mappedSwitchId - 1] = state;
-    ESP_LOGI(TAG, "Updated switch %d to API: %s", mappedSwitchId, state ? "ON" : "OFF");
-    return true;
-  }
-  // retry once
-  ESP_LOGW(TAG, "Retry update switch %d", mappedSwitchId);
-  if (SwitchApiClient::updateSwitchState(mappedSwitchId, state))
-  {
-    lastKnownSwitchStates[mappedSwitchId - 1] = state;
-    ESP_LOGI(TAG, "Updated switch %d to API on retry", mappedSwitchId);
-    return true;
-  }
-  ESP_LOGW(TAG, "Failed to update switch %d to API after retry", mappedSwitchId);
-  return false;
+  ESP_LOGD(TAG, "Queue relay %d -> switch %d state=%d v%lu (%s)", relayId, mappedSwitchId, state, (unsigned long)version, origin);
+  TRACE_INSTANT(state ? "switch.queue.on" : "switch.queue.off", relayId);
+  return ApiWorker::queueSwitchState(relayId, state, version, origin);
 #else
   (void)relayId;
   (void)state;
+  (void)version;
+  (void)origin;
   return false;
 #endif
 }
+
+// Called from ApiWorker task when the Switch API update finished
+// ok / 409 / error ก็จบรอบนั้น poll ถัดไปจะตัดสินต่อเอง (ส่งซ้ำหรือรับค่าจาก server)
+static void onSwitchStateSynced(int relayId, int state, uint32_t version, bool success)
+{
+  TRACE_INSTANT(success ? "switch.put.ok" : "switch.put.fail", relayId);
+  if (relayId >= 0 && relayId < 4)
+  {
+    portENTER_CRITICAL(&switchSyncMux);
+    SwitchSync::ack(&switchSync[relayId], version);
+    portEXIT_CRITICAL(&switchSyncMux);
+  }
+}
+
 /* --------- Respone soilMinMax toWeb --------- */
 static void send_soilMinMax()
 {
@@ -496,7 +743,7 @@ static void send_soilMinMax()
                    ",\"min_soil2\":" + String(Min_Soil[2]) + ",\"max_soil2\":" + String(Max_Soil[2]) +
                    ",\"min_soil3\":" + String(Min_Soil[3]) + ",\"max_soil3\":" + String(Max_Soil[3]) + "}}";
     ESP_LOGV(TAG, "_payload : %s", soil_payload.c_str());
-    if (client.publish("@shadow/data/update", soil_payload.c_str()))
+    if (mqttPublish("@shadow/data/update", soil_payload.c_str()))
     {
       check_sendData_SoilMinMax = 0;
       ESP_LOGV(TAG, "Send Complete min max ");
@@ -515,7 +762,7 @@ static void send_tempMinMax()
                    ",\"min_temp2\":" + String(Min_Temp[2]) + ",\"max_temp2\":" + String(Max_Temp[2]) +
                    ",\"min_temp3\":" + String(Min_Temp[3]) + ",\"max_temp3\":" + String(Max_Temp[3]) + "}}";
     ESP_LOGV(TAG, "_payload : %s", temp_payload.c_str());
-    if (client.publish("@shadow/data/update", temp_payload.c_str()))
+    if (mqttPublish("@shadow/data/update", temp_payload.c_str()))
     {
       check_sendData_tempMinMax = 0;
     }
@@ -612,7 +859,7 @@ void sendUpdateTimerToServer(uint8_t relay, uint8_t timer)
   sprintf(payload, "{\"data\":{\"value_timer%d%d\":\"%d,%d,%d,%d,%d,%d,%d,%d,%02d:%02d:00,%02d:%02d:00\"}}",
           relay, timer, enable, day_enable[0], day_enable[1], day_enable[2], day_enable[3], day_enable[4], day_enable[5], day_enable[6], time_on_hour, time_on_min, time_off_hour, time_off_min);
   ESP_LOGV(TAG, "update shadow : %s", payload);
-  client.publish("@shadow/data/update", payload);
+  mqttPublish("@shadow/data/update", payload);
 }
 
 void HandySense_updateTimeInTimer(uint8_t relay, uint8_t timer, bool isTimeOn, uint16_t time)
@@ -736,23 +983,9 @@ void HandySense_updateDisableTimer(uint8_t relay, uint8_t timer)
 static void ControlRelay_Bytimmer()
 {
   // Only update time variables and globals for UI/use elsewhere.
-  bool getTimeFromInternet = false;
-  if (WiFi.status() == WL_CONNECTED)
-  {
-    configTime(gmtOffset_sec, daylightOffset_sec, ntpServer, nistTime);
-    if (getLocalTime(&timeinfo))
-    {
-      getTimeFromInternet = true;
-    }
-  }
-  if (!getTimeFromInternet)
-  {
-    rtc.read(&timeinfo);
-  }
-  else
-  {
-    rtc.write(&timeinfo); // update time in RTC
-  }
+  // เวลาอ่านจาก RAM, SNTP sync เองตามรอบ และเขียน RTC ไม่เกินชั่วโมงละครั้ง
+  TimeService::loop();
+  TimeService::getLocalTime(&timeinfo);
 
   yearNow = timeinfo.tm_year + 1900;
   monthNow = timeinfo.tm_mon + 1;
@@ -800,30 +1033,7 @@ void ControlRelay_Bymanual(String topic, String message, unsigned int length)
   {
     Close_relay(manual_relay, "MANUAL_MQTT");
   }
-
-  // After handling manual MQTT command, ensure Switch API is updated (map relay 0-3 -> switch 1-4)
-#if USE_SWITCH_API_CONTROL >= 1
-  if (manual_relay >= 0 && manual_relay < 4)
-  {
-    int state = RelayStatus[manual_relay];
-    ESP_LOGD(TAG, "Manual control: reporting relay %d state=%d to Switch API", manual_relay, state);
-    // set loop-protect so that when API returns state we don't re-apply it
-    ignoreNextSync[manual_relay] = true;
-    // Update lastKnownSwitchStates and call API directly to be explicit
-    int switchId = RELAY_ID_TO_SWITCH_ID(manual_relay);
-    lastKnownSwitchStates[switchId - 1] = state;
-    if (SwitchApiClient::updateSwitchState(switchId, state))
-    {
-      ESP_LOGI(TAG, "Manual -> Switch API updated switch %d to %s", switchId, state ? "ON" : "OFF");
-    }
-    else
-    {
-      ESP_LOGW(TAG, "Manual -> Switch API failed update for switch %d", switchId);
-      // fallback: try our wrapper which retries
-      updateSwitchStateToAPI(manual_relay, state);
-    }
-  }
-#endif
+  // Switch API ถูกอัปเดตใน setRelayState (เฉพาะเมื่อ relay เปลี่ยนจริง)
 }
 
 /* ----------------------- SoilMaxMin_setting --------------------------- */
@@ -888,7 +1098,7 @@ void HandySense_setTempMin(uint8_t relay, int value)
   sprintf(payload, "{\"data\":{\"min_temp%d\":%.0f}}",
           relay, Min_Temp[relay]);
   ESP_LOGV(TAG, "update shadow : %s", payload);
-  client.publish("@shadow/data/update", payload);
+  mqttPublish("@shadow/data/update", payload);
 }
 
 void HandySense_setTempMax(uint8_t relay, int value)
@@ -903,7 +1113,7 @@ void HandySense_setTempMax(uint8_t relay, int value)
   sprintf(payload, "{\"data\":{\"max_temp%d\":%.0f}}",
           relay, Max_Temp[relay]);
   ESP_LOGV(TAG, "update shadow : %s", payload);
-  client.publish("@shadow/data/update", payload);
+  mqttPublish("@shadow/data/update", payload);
 }
 
 void HandySense_setSoilMin(uint8_t relay, int value)
@@ -918,7 +1128,7 @@ void HandySense_setSoilMin(uint8_t relay, int value)
   sprintf(payload, "{\"data\":{\"min_soil%d\":%.0f}}",
           relay, Min_Soil[relay]);
   ESP_LOGV(TAG, "update shadow : %s", payload);
-  client.publish("@shadow/data/update", payload);
+  mqttPublish("@shadow/data/update", payload);
 }
 
 void HandySense_setSoilMax(uint8_t relay, int value)
@@ -933,7 +1143,7 @@ void HandySense_setSoilMax(uint8_t relay, int value)
   sprintf(payload, "{\"data\":{\"max_soil%d\":%.0f}}",
           relay, Max_Soil[relay]);
   ESP_LOGV(TAG, "update shadow : %s", payload);
-  client.publish("@shadow/data/update", payload);
+  mqttPublish("@shadow/data/update", payload);
 }
 
 /* ----------------------- soilMinMax_ControlRelay --------------------------- */
@@ -1085,12 +1295,59 @@ void webSerialJSON()
     if (err == DeserializationError::Ok)
     {
       String command = jsonDoc["command"].as<String>();
-      bool isValidData = !jsonDoc["client"].isNull();
+      DeviceConfigFields config;
+      DeviceConfig::read(jsonDoc.as<JsonVariantConst>(), &config);
+      DeviceConfigResult configResult = DeviceConfig::check(&config);
+      bool isValidData = configResult == DEVICE_CONFIG_OK;
+      if (configResult != DEVICE_CONFIG_OK && configResult != DEVICE_CONFIG_NONE)
+      {
+        ESP_LOGW(TAG, "Config rejected: %s", DeviceConfig::resultName(configResult)); // ไม่บันทึก ไม่รีสตาร์ท
+      }
       if (command == "restart")
       {
         delay(100);
         ESP.restart();
       }
+      if (command == "loglevel") // {"command":"loglevel","tag":"Sensor","level":"debug"}
+      {
+        LogBuffer::setLevel(jsonDoc["tag"] | "*", jsonDoc["level"] | "info");
+      }
+#if TRACE_ENABLE
+      if (command == "trace") // {"command":"trace","clear":true} -> Chrome trace JSON
+      {
+        Trace::dump(Serial);
+        if (jsonDoc["clear"] | false)
+          Trace::clear();
+      }
+#endif
+      if (command == "health") // {"command":"health"}
+      {
+        static char summary[SYSTEM_HEALTH_SUMMARY_SIZE];
+        SystemHealth::summaryJSON(summary, sizeof(summary));
+        Serial.println(summary);
+      }
+      if (command == "intervals") // {"command":"intervals","switchPoll":5,...} วินาที, 0 = ค่าเริ่มต้น
+      {
+        for (int i = 0; i < POLL_COUNT; i++)
+        {
+          JsonVariant value = jsonDoc[ApiPayload::intervalKey((PollInterval)i)];
+          if (!value.isNull())
+            PollIntervals::hint((PollInterval)i, value.as<uint32_t>());
+        }
+        PollIntervals::print();
+      }
+      if (command == "perf") // {"command":"perf","reset":true}
+      {
+        Perf::print();
+        HttpTransport::print();
+        I2CBus::print();
+        Rs485Bus::print();
+        if (jsonDoc["reset"] | false)
+        {
+          Perf::reset();
+          HttpTransport::reset();
+        }
+      }
       if (isValidData)
       {
         /* ------------------WRITING----------------- */
@@ -1134,31 +1391,41 @@ void wifiConfig(String ssid, String password)
 /* --------- อินเตอร์รัป แสดงสถานะการเชื่อม wifi ------------- */
 void HandySense_init()
 {
+  LogBuffer::begin(); // เริ่มก่อน log อื่น ๆ
+  mqttMutex = xSemaphoreCreateRecursiveMutex();
+  SystemHealth::begin();
+  SystemHealth::onAlert(onLowMemory);
+#if TRACE_ENABLE
+  Trace::begin();
+#endif
   EEPROM.begin(4096);
+  PollIntervals::begin(); // hint จาก server ที่บันทึกไว้ (EEPROM 2500+)
+  HttpTransport::onIntervalHint(onIntervalHint);
 
-  Wire.begin();
-  Wire.setClock(10000);
+  I2CBus::begin(Wire); // เลือก clock เร็วสุดที่ทุก device ตอบได้ (เดิม fix 10 kHz)
   rtc.begin();
+  TimeService::begin(&rtc);
+#if RTC_INT_PIN >= 0
+  setupRtcAlarm();
+#endif
   Sensor_init();
+  if (!FlowMeter_init())
+  {
+    ESP_LOGW(TAG, "Flow meter not started");
+  }
 
   ApiClient::init();
   AutomationApiClient::init();
+  ApiWorker::begin();
+  ApiWorker::onSwitchStateResult(onSwitchStateSynced);
 
   for (int i = 0; i < 4; i++)
   {
     pinMode(relay_pin[i], OUTPUT);
     digitalWrite(relay_pin[i], LOW);
     RelayStatus[i] = 0; // **[แก้ไข]** ทำให้แน่ใจว่าสถานะเริ่มต้นเป็น OFF
-    // Initialize last known switch states and, if possible, push to API so server sees current state
-    lastKnownSwitchStates[i] = RelayStatus[i];
-#if USE_SWITCH_API_CONTROL >= 1
-    if (WiFi.status() == WL_CONNECTED)
-    {
-      // Avoid immediate loop when API returns this state
-      ignoreNextSync[i] = true;
-      updateSwitchStateToAPI(i, RelayStatus[i]);
-    }
-#endif
+    // poll แรกหลังบูตจะส่งสถานะนี้ไป API ด้วย version ที่สูงกว่า server ถ้าไม่ตรงกัน (SwitchSync::remote)
+    switchSync[i].state = RelayStatus[i];
   }
 
 #if USE_SWITCH_API_CONTROL
@@ -1190,8 +1457,10 @@ void HandySense_init()
       ssid = jsonDoc["ssid"].as<String>();
     }
   }
-  xTaskCreatePinnedToCore(TaskWifiStatus, "WifiStatus", 4096, NULL, 10, &WifiStatus, 1);
-  xTaskCreatePinnedToCore(TaskWaitSerial, "WaitSerial", 8192, NULL, 10, &WaitSerial, 1);
+  xTaskCreatePinnedToCore(TaskWifiStatus, "WifiStatus", WIFI_STATUS_TASK_STACK_SIZE, NULL, 10, &WifiStatus, 1);
+  xTaskCreatePinnedToCore(TaskWaitSerial, "WaitSerial", WAIT_SERIAL_TASK_STACK_SIZE, NULL, 10, &WaitSerial, 1);
+  SystemHealth::registerTask(WifiStatus, "WifiStatus", WIFI_STATUS_TASK_STACK_SIZE);
+  SystemHealth::registerTask(WaitSerial, "WaitSerial", WAIT_SERIAL_TASK_STACK_SIZE);
   setAll_config();
 }
 
@@ -1222,49 +1491,83 @@ void checkAndTriggerTimers()
       continue;
 
     // Only act when this relay has at least one enabled timer configured.
-    bool shouldBeOn = false;
-    bool hasEnabledTimer = false;
-    for (int timerId = 0; timerId < 3; timerId++)
-    {
-      AutomationTimer *timer = AutomationApiClient::getLocalTimer(relayId, timerId);
-      if (timer && timer->enabled)
-      {
-        hasEnabledTimer = true;
-        if (AutomationApiClient::isTimerActive(relayId, timerId, currentMinutes, dayOfWeek))
-        {
-          shouldBeOn = true;
-          break;
-        }
-      }
-    }
-
-    if (!hasEnabledTimer)
+    AutomationRelayRules rules;
+    AutomationApiClient::getRelayRules(relayId, &rules);
+    AutomationDecision decision = AutomationEngine::decideTimers(&rules, currentMinutes, dayOfWeek);
+    if (decision == AUTOMATION_NONE)
     {
       ESP_LOGD(TAG, "Relay %d: no enabled timers configured, skipping timer control", relayId);
       continue; // don't force state for relays with no timers
     }
 
-    if (shouldBeOn)
+    if (decision == AUTOMATION_TURN_ON)
     {
       Open_relay(relayId, "AUTO_API_TIMER");
-      // Ensure API is informed about this automation decision
-#if USE_SWITCH_API_CONTROL >= 1
-      ignoreNextSync[relayId] = true;
-      updateSwitchStateToAPI(relayId, RelayStatus[relayId]);
-#endif
     }
     else
     {
       Close_relay(relayId, "AUTO_API_TIMER");
-      // Ensure API is informed about this automation decision
-#if USE_SWITCH_API_CONTROL >= 1
-      ignoreNextSync[relayId] = true;
-      updateSwitchStateToAPI(relayId, RelayStatus[relayId]);
-#endif
     }
   }
 }
 
+// ========== RTC alarm ที่ขอบเวลาของ Timer ถัดไป ==========
+#if RTC_INT_PIN >= 0
+#define TIMER_CHECK_INTERVAL_RTC_ALARM 60000 // มี RTC alarm แล้ว poll แค่กันพลาด
+
+static volatile bool rtcAlarmFired = false;
+static time_t rtcAlarmEdge = 0;
+
+static void IRAM_ATTR onRtcInterrupt()
+{
+  rtcAlarmFired = true;
+}
+
+static void setupRtcAlarm()
+{
+  pinMode(RTC_INT_PIN, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(RTC_INT_PIN), onRtcInterrupt, FALLING);
+  gpio_wakeup_enable((gpio_num_t)RTC_INT_PIN, GPIO_INTR_LOW_LEVEL); // ปลุกจาก light sleep ได้
+  esp_sleep_enable_gpio_wakeup();
+}
+
+// ตั้ง alarm ที่ time_on / time_off ถัดไป (เขียน RTC เฉพาะเมื่อเวลาเปลี่ยน)
+static void scheduleNextTimerAlarm()
+{
+  struct tm info;
+  if (!TimeService::getLocalTime(&info))
+    return;
+
+  int minutes = AutomationApiClient::getMinutesToNextTimerEdge(info.tm_hour * 60 + info.tm_min, AutomationApiClient::getDayOfWeek(&info));
+  I2CBusLock bus(rtc.getAddress());
+  if (!bus.isLocked())
+    return;
+
+  if (minutes < 0)
+  {
+    if (rtcAlarmEdge != 0 && bus.check(rtc.disableAlarm()))
+      rtcAlarmEdge = 0;
+    return;
+  }
+
+  time_t edge = mktime(&info) - info.tm_sec + (minutes * 60);
+  if (edge == rtcAlarmEdge)
+    return;
+
+  struct tm when;
+  localtime_r(&edge, &when);
+  if (bus.check(rtc.setAlarm(&when)))
+  {
+    rtcAlarmEdge = edge;
+    ESP_LOGD(TAG, "RTC alarm at %02d:%02d (%d min)", when.tm_hour, when.tm_min, minutes);
+  }
+  else
+  {
+    ESP_LOGW(TAG, "RTC alarm not supported / write fail, poll only");
+  }
+}
+#endif
+
 // Check และ Trigger Sensor ตัวเดียวจาก API
 void checkSensorControl(int relayId, const char *sensorType, float currentValue)
 {
@@ -1278,20 +1581,10 @@ void checkSensorControl(int relayId, const char *sensorType, float currentValue)
   int currentMinutes = timeinfo->tm_hour * 60 + timeinfo->tm_min;
   int dayOfWeek = AutomationApiClient::getDayOfWeek(timeinfo);
 
-  bool hasActiveTimer = false;
-  for (int timerId = 0; timerId < 3; timerId++)
-  {
-    AutomationTimer *timer = AutomationApiClient::getLocalTimer(relayId, timerId);
-    if (timer && timer->enabled &&
-        AutomationApiClient::isTimerActive(relayId, timerId, currentMinutes, dayOfWeek))
-    {
-      hasActiveTimer = true;
-      break;
-    }
-  }
-
   // Priority: when any timer window is active for this relay, skip sensor control
-  if (hasActiveTimer)
+  AutomationRelayRules rules;
+  AutomationApiClient::getRelayRules(relayId, &rules);
+  if (AutomationEngine::isTimerActive(&rules, currentMinutes, dayOfWeek))
   {
     ESP_LOGD(TAG, "Sensor skipped: relay %d timer is active (priority timer > sensor)", relayId);
     return;
@@ -1306,18 +1599,10 @@ void checkSensorControl(int relayId, const char *sensorType, float currentValue)
     if (actionOnTrigger == "turn_on")
     {
       Open_relay(relayId, "AUTO_API_SENSOR");
-#if USE_SWITCH_API_CONTROL >= 1
-      ignoreNextSync[relayId] = true;
-      updateSwitchStateToAPI(relayId, RelayStatus[relayId]);
-#endif
     }
     else if (actionOnTrigger == "turn_off")
     {
       Close_relay(relayId, "AUTO_API_SENSOR");
-#if USE_SWITCH_API_CONTROL >= 1
-      ignoreNextSync[relayId] = true;
-      updateSwitchStateToAPI(relayId, RelayStatus[relayId]);
-#endif
     }
     else
     {
@@ -1329,10 +1614,11 @@ void checkSensorControl(int relayId, const char *sensorType, float currentValue)
 // Check และ Trigger Sensors ทั้งหมดจาก API
 void checkAndTriggerSensors()
 {
-  float currentTemp = temp;
-  float currentSoil = soil;
-  float currentHumidity = humidity;
-  float currentLight = lux_44009;
+  float inputs[AUTOMATION_IN_COUNT];
+  inputs[AUTOMATION_IN_TEMPERATURE] = temp;
+  inputs[AUTOMATION_IN_SOIL] = soil;
+  inputs[AUTOMATION_IN_HUMIDITY] = humidity;
+  inputs[AUTOMATION_IN_LIGHT] = lux_44009;
 
   // Determine current time for timer priority and gating
   time_t now;
@@ -1343,51 +1629,23 @@ void checkAndTriggerSensors()
 
   for (int relayId = 0; relayId < 4; relayId++)
   {
-    bool hasActiveTimer = false;
-    for (int timerId = 0; timerId < 3; timerId++)
-    {
-      AutomationTimer *timer = AutomationApiClient::getLocalTimer(relayId, timerId);
-      if (timer && timer->enabled &&
-          AutomationApiClient::isTimerActive(relayId, timerId, currentMinutes, dayOfWeek))
-      {
-        hasActiveTimer = true;
-        break;
-      }
-    }
     // Priority: if a timer is currently active, do not allow sensors to override
-    if (hasActiveTimer)
+    AutomationRelayRules rules;
+    AutomationApiClient::getRelayRules(relayId, &rules);
+    if (AutomationEngine::isTimerActive(&rules, currentMinutes, dayOfWeek))
     {
       ESP_LOGD(TAG, "Relay %d: skip sensors (timer active: priority timer > sensor)", relayId);
       continue;
     }
 
     // Evaluate only sensors that are configured and enabled
-    AutomationSensor *sTemp = AutomationApiClient::getLocalSensor(relayId, "temperature");
-    if (sTemp && sTemp->enabled)
-    {
-      ESP_LOGD(TAG, "Relay %d: temperature sensor enabled, checking...", relayId);
-      checkSensorControl(relayId, "temperature", currentTemp);
-    }
-
-    AutomationSensor *sSoil = AutomationApiClient::getLocalSensor(relayId, "soil_moisture");
-    if (sSoil && sSoil->enabled)
-    {
-      ESP_LOGD(TAG, "Relay %d: soil_moisture sensor enabled, checking...", relayId);
-      checkSensorControl(relayId, "soil_moisture", currentSoil);
-    }
-
-    AutomationSensor *sHum = AutomationApiClient::getLocalSensor(relayId, "humidity");
-    if (sHum && sHum->enabled)
-    {
-      ESP_LOGD(TAG, "Relay %d: humidity sensor enabled, checking...", relayId);
-      checkSensorControl(relayId, "humidity", currentHumidity);
-    }
-
-    AutomationSensor *sLight = AutomationApiClient::getLocalSensor(relayId, "light");
-    if (sLight && sLight->enabled)
+    for (int input = 0; input < AUTOMATION_IN_COUNT; input++)
     {
-      ESP_LOGD(TAG, "Relay %d: light sensor enabled, checking...", relayId);
-      checkSensorControl(relayId, "light", currentLight);
+      if (rules.sensors[input])
+      {
+        ESP_LOGD(TAG, "Relay %d: %s sensor enabled, checking...", relayId, AutomationEngine::inputName(input));
+        checkSensorControl(relayId, AutomationEngine::inputName(input), inputs[input]);
+      }
     }
   }
 }
@@ -1399,22 +1657,45 @@ void checkAndTriggerSensors()
 // ===================================================================
 void HandySense_loop()
 {
+  PERF_SCOPE("loop");
   if (wifi_ready)
   {
-    client.loop();
+    PERF_SCOPE("mqtt.loop");
+    {
+      MqttLock lock; // TaskWifiStatus กำลัง connect / publish อยู่ ข้ามรอบนี้
+      if (lock.isLocked())
+        client.loop();
+    }
+    publishLogStep(); // ปล่อย lock ก่อน ให้ publish อื่นแทรกระหว่างข้อความได้
   }
   UI_loop();
 
 #if USE_SWITCH_API_CONTROL == 1 || USE_SWITCH_API_CONTROL == 2
   if (wifi_ready)
   {
+    PERF_SCOPE("switch.sync");
     syncSwitchStatesFromAPI();
   }
 #endif
 
+  SystemHealth::update();
+  PollIntervals::loop();
+
+  static unsigned long previousTime_Perf = 0;
+  static uint8_t perfSummaryPart = PERF_SUMMARY_PARTS; // = ส่งครบแล้ว
+  if (wifi_ready && millis() - previousTime_Perf >= PERF_PUBLISH_INTERVAL)
+  {
+    perfSummaryPart = 0;
+    previousTime_Perf = millis();
+  }
+  if (wifi_ready && perfSummaryPart < PERF_SUMMARY_PARTS)
+    publishPerfSummary(perfSummaryPart++);
+
   unsigned long currentTime = millis();
   if (currentTime - previousTime_Temp_soil >= eventInterval)
   {
+    PERF_SCOPE("sensor.update");
+    // ค่าล่าสุดจาก Sensor task (ไม่รอ I2C / RS485)
     float newTemp = 0, newSoil = 0;
     Sensor_getTemp(&newTemp);
     Sensor_getHumi(&humidity);
@@ -1444,13 +1725,16 @@ void HandySense_loop()
 
   if (currentTime - previousTime_brightness >= eventInterval_brightness)
   {
-    Sensor_getLight(&lux_44009);
-    lux_44009 /= 1000.0;
+    float lux = 0;
+    if (Sensor_getLight(&lux))
+    {
+      lux_44009 = lux / 1000.0;
+    }
     previousTime_brightness = currentTime;
   }
 
   unsigned long currentTime_Update_data = millis();
-  if ((previousTime_Update_data == 0 || (currentTime_Update_data - previousTime_Update_data >= (eventInterval_publishData))) && wifi_ready)
+  if ((previousTime_Update_data == 0 || (currentTime_Update_data - previousTime_Update_data >= PollIntervals::get(POLL_TELEMETRY))) && wifi_ready)
   {
     UpdateData_To_Server();
     previousTime_Update_data = currentTime_Update_data;
@@ -1460,7 +1744,6 @@ void HandySense_loop()
 #if AUTOMATION_API_ENABLE
   if (wifi_ready)
   {
-    static unsigned long lastSync = 0;
     static unsigned long lastTimerCheck = 0;
     static unsigned long lastSensorCheck = 0;
     static unsigned long bootTime = millis();
@@ -1470,27 +1753,49 @@ void HandySense_loop()
       return; // รอ 5 วินาทีหลัง Boot ก่อนเริ่มทำงาน
 
     // Full sync every 10 minutes
-    if (now - lastSync > AUTOMATION_SYNC_INTERVAL)
+    if (now - lastAutomationSync > PollIntervals::get(POLL_AUTOMATION_SYNC))
     {
+      PERF_SCOPE("auto.sync");
       ESP_LOGI(TAG, "[AUTO] Syncing automation from API...");
       if (AutomationApiClient::syncFromAPI())
       {
         ESP_LOGI(TAG, "[AUTO] Sync complete");
       }
-      lastSync = now;
+      lastAutomationSync = now;
     }
 
     // Check timers every minute
-    if (now - lastTimerCheck > TIMER_CHECK_INTERVAL)
+#if RTC_INT_PIN >= 0
+    bool timerEdge = rtcAlarmFired;
+    if (timerEdge)
     {
+      rtcAlarmFired = false;
+      I2CBusLock bus(rtc.getAddress());
+      bus.check(rtc.clearAlarmFlag()); // ปล่อย INT pin
+      rtcAlarmEdge = 0;
+    }
+    unsigned long timerCheckInterval = rtcAlarmEdge != 0 ? TIMER_CHECK_INTERVAL_RTC_ALARM : PollIntervals::get(POLL_TIMER_CHECK);
+    if (timerEdge || now - lastTimerCheck > timerCheckInterval)
+    {
+      PERF_SCOPE("auto.timer");
+      checkAndTriggerTimers();
+      scheduleNextTimerAlarm();
+      lastTimerCheck = now;
+    }
+#else
+    if (now - lastTimerCheck > PollIntervals::get(POLL_TIMER_CHECK))
+    {
+      PERF_SCOPE("auto.timer");
       // ESP_LOGD(TAG, "[AUTO] Checking timers...");
       checkAndTriggerTimers();
       lastTimerCheck = now;
     }
+#endif
 
     // Check sensors every 5 seconds (ปรับจาก 5 นาทีเพื่อให้ตอบสนองเร็วขึ้น)
-    if (now - lastSensorCheck > SENSOR_CHECK_INTERVAL)
+    if (now - lastSensorCheck > PollIntervals::get(POLL_SENSOR_CHECK))
     {
+      PERF_SCOPE("auto.sensor");
       // ESP_LOGD(TAG, "[AUTO] Checking sensors...");
       checkAndTriggerSensors();
       lastSensorCheck = now;
@@ -1546,21 +1851,35 @@ void TaskWifiStatus(void *pvParameters)
     }
 
     connectWifiStatus = wifiConnected;
-    client.setServer(mqtt_server.c_str(), mqtt_port.toInt());
-    client.setCallback(callback);
+    {
+      MqttLock lock(portMAX_DELAY);
+      client.setServer(mqtt_server.c_str(), mqtt_port.toInt());
+      client.setCallback(callback);
+    }
     timeClient.begin();
 
-    do
+    unsigned long retryDelay = MQTT_RETRY_MIN;
+    while (!mqttConnect()) // ไม่ถือ lock ระหว่างรอ retry
     {
-      ESP_LOGV(TAG, "NETPIE2020 can not connect");
-      client.connect(mqtt_Client.c_str(), mqtt_username.c_str(), mqtt_password.c_str());
-      delay(100);
-    } while (!client.connected());
+      // Equal jitter [retry / 2, retry] แล้วเพิ่มเท่าตัว ไม่ให้ทั้ง fleet ต่อ broker พร้อมกันทุก 100 ms
+      unsigned long wait = retryDelay / 2 + random(retryDelay / 2 + 1);
+      ESP_LOGV(TAG, "NETPIE2020 can not connect, retry in %lu ms", wait);
+      delay(wait);
+      retryDelay = min(retryDelay * 2, (unsigned long)MQTT_RETRY_MAX);
+      if (WiFi.status() != WL_CONNECTED)
+        break;
+    }
+    if (!mqttConnectedWait())
+      continue; // WiFi หลุดระหว่างรอ เริ่มใหม่
 
     connectWifiStatus = serverConnected;
     ESP_LOGV(TAG, "NETPIE2020 connected");
-    client.subscribe("@private/#");
-    configTime(gmtOffset_sec, daylightOffset_sec, ntpServer, nistTime);
+    {
+      MqttLock lock(portMAX_DELAY);
+      client.subscribe("@private/#");
+    }
+    TimeService::onNetworkConnected();
+    randomizeApiPhases();
     wifi_ready = true;
 
 // ========== เริ่มต้น Switch Manager เมื่อ WiFi พร้อม ==========
@@ -1581,7 +1900,9 @@ void TaskWifiStatus(void *pvParameters)
     static bool automationSyncInitialized = false;
     if (!automationSyncInitialized)
     {
-      ESP_LOGI(TAG, "Initial Automation Sync...");
+      unsigned long jitter = random(NET_CONNECT_JITTER_MAX);
+      ESP_LOGI(TAG, "Initial Automation Sync in %lu ms...", jitter);
+      delay(jitter); // task นี้ไม่ใช่ loop หลัก รอได้ ไม่ให้ทุกเครื่อง sync พร้อมกันหลังไฟมา
       if (AutomationApiClient::syncFromAPI())
       {
         ESP_LOGI(TAG, "Automation sync complete: %d timers, %d sensors",
@@ -1599,7 +1920,7 @@ void TaskWifiStatus(void *pvParameters)
     }
 #endif
 
-    while (WiFi.status() == WL_CONNECTED && client.connected())
+    while (WiFi.status() == WL_CONNECTED && mqttConnectedWait())
     {
 #if USE_SWITCH_API_CONTROL == 0 || USE_SWITCH_API_CONTROL == 2
       sendStatus_RelaytoWeb();
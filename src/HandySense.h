@@ -9,6 +9,7 @@
 
 void HandySense_init() ;
 void HandySense_loop() ;
+bool HandySense_mqttConnected() ; // ใช้แทน client.connected() นอก HandySense.cpp (ถือ lock ของ client)
 
 void HandySense_updateTimeInTimer(uint8_t relay, uint8_t timer, bool isTimeOn, uint16_t time) ;
 void HandySense_updateDayEnableInTimer(uint8_t relay, uint8_t timer, uint8_t day, bool enable) ;
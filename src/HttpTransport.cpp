@@ -0,0 +1,472 @@
+#include "HttpTransport.h"
+#include "ApiPayload.h"
+#include <WiFi.h>
+#include <HTTPClient.h>
+
+static const char* TAG = "HttpTransport";
+
+static portMUX_TYPE metricsMux = portMUX_INITIALIZER_UNLOCKED;
+static portMUX_TYPE breakerMux = portMUX_INITIALIZER_UNLOCKED;
+static portMUX_TYPE bucketMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Token bucket in 1/60000 token, so refill is HTTP_RATE_PER_MIN per ms
+#define TOKEN_UNITS         ((uint32_t) 60000)
+#define BUCKET_CAPACITY     ((uint32_t) (HTTP_RATE_BURST * TOKEN_UNITS))
+static uint32_t bucketUnits = 0;    // Refilled from 0 ms, full ~10 s after boot
+static uint32_t bucketRefillAt = 0;
+static TaskHandle_t tokenHolder = NULL; // Task with a reserved token (waitForToken)
+
+#define PHASE_SKIPPED 0xFFFFFFFF // Phase didn't run (DNS fail, https, ...)
+
+static const char* const phaseNames[HTTP_PHASE_COUNT] = { "dns", "connect", "ttfb", "total" };
+static const char* hintHeaders[] = { "Retry-After", "X-Poll-Interval" };
+
+HttpTransport::Metrics HttpTransport::metrics[HTTP_EP_COUNT];
+HttpTransport::Breaker HttpTransport::breakers[HTTP_EP_COUNT];
+HttpIntervalHintCallback HttpTransport::intervalHintCallback = NULL;
+
+int HttpTransport::request(const char* method, const String& url, const char* apiKey,
+                           const char* payload, String* response, uint16_t timeout) {
+    HttpEndpoint endpoint = classify(url);
+    if (!takeReservedToken() && !takeToken(true)) {
+        ESP_LOGD(TAG, "%s %s -> rate limited", method, endpointName(endpoint));
+        portENTER_CRITICAL(&metricsMux);
+        metrics[endpoint].limited++;
+        portEXIT_CRITICAL(&metricsMux);
+        return HTTP_ERROR_RATE_LIMITED;
+    }
+    if (!breakerAllow(endpoint)) {
+        returnToken(); // Nothing was sent
+        ESP_LOGD(TAG, "%s %s -> circuit open", method, endpointName(endpoint));
+        return HTTP_ERROR_CIRCUIT_OPEN;
+    }
+
+    uint32_t phase_us[HTTP_PHASE_COUNT] = { PHASE_SKIPPED, PHASE_SKIPPED, PHASE_SKIPPED, PHASE_SKIPPED };
+    size_t bytesOut = payload ? strlen(payload) : 0;
+    size_t bytesIn = 0;
+    uint32_t start = micros();
+
+    WiFiClient client;
+    HTTPClient http;
+    String host;
+    uint16_t port;
+    if (parseUrl(url, &host, &port)) {
+        IPAddress ip;
+        uint32_t t = micros();
+        if (!WiFi.hostByName(host.c_str(), ip)) {
+            ESP_LOGE(TAG, "DNS lookup fail: %s", host.c_str());
+            record(endpoint, HTTPC_ERROR_CONNECTION_REFUSED, false, phase_us, 0, 0);
+            return HTTPC_ERROR_CONNECTION_REFUSED;
+        }
+        phase_us[HTTP_PHASE_DNS] = micros() - t;
+
+        t = micros();
+        if (!client.connect(ip, port, timeout)) {
+            bool timedOut = (micros() - t) >= ((uint32_t) timeout * 1000);
+            ESP_LOGE(TAG, "Connect %s:%d %s", host.c_str(), port, timedOut ? "timeout" : "fail");
+            record(endpoint, HTTPC_ERROR_CONNECTION_REFUSED, timedOut, phase_us, 0, 0);
+            return HTTPC_ERROR_CONNECTION_REFUSED;
+        }
+        phase_us[HTTP_PHASE_CONNECT] = micros() - t;
+
+        http.begin(client, url); // Already connected, HTTPClient reuse the socket
+    } else { // https or something we don't parse, let HTTPClient do everything
+        http.begin(url);
+    }
+
+    http.setTimeout(timeout);
+    http.collectHeaders(hintHeaders, 2);
+    if (payload) {
+        http.addHeader("Content-Type", "application/json");
+    }
+    if (apiKey && apiKey[0]) {
+        http.addHeader("X-API-KEY", apiKey);
+    }
+
+    uint32_t t = micros();
+    int httpCode = http.sendRequest(method, (uint8_t*) payload, bytesOut);
+    phase_us[HTTP_PHASE_FIRST_BYTE] = micros() - t;
+
+    uint32_t retryAfter_s = 0;
+    uint32_t pollHint_s = 0;
+    if (httpCode > 0) {
+        // Anything but a positive integer is ignored (HTTP-date form, "-1", garbage),
+        // toInt() would wrap a negative value into a huge one
+        if (!ApiPayload::parseSeconds(http.header("Retry-After").c_str(), &retryAfter_s)) {
+            retryAfter_s = 0;
+        }
+        String pollHint = http.header("X-Poll-Interval");
+        if (pollHint.length() > 0 && !ApiPayload::parseSeconds(pollHint.c_str(), &pollHint_s)) {
+            ESP_LOGW(TAG, "%s: bad X-Poll-Interval \"%s\", ignored", endpointName(endpoint), pollHint.c_str());
+        }
+        if (response) {
+            *response = http.getString();
+            bytesIn = response->length();
+        } else {
+            bytesIn = http.getString().length();
+        }
+    }
+    http.end();
+    phase_us[HTTP_PHASE_TOTAL] = micros() - start;
+
+    ESP_LOGD(TAG, "%s %s -> %d, dns %lu us, connect %lu us, ttfb %lu us, total %lu us", method,
+             endpointName(endpoint), httpCode, (unsigned long) phase_us[HTTP_PHASE_DNS],
+             (unsigned long) phase_us[HTTP_PHASE_CONNECT], (unsigned long) phase_us[HTTP_PHASE_FIRST_BYTE],
+             (unsigned long) phase_us[HTTP_PHASE_TOTAL]);
+
+    record(endpoint, httpCode, httpCode == HTTPC_ERROR_READ_TIMEOUT, phase_us, bytesOut, bytesIn, retryAfter_s);
+    if (pollHint_s > 0 && intervalHintCallback) {
+        intervalHintCallback(endpoint, pollHint_s);
+    }
+    return httpCode;
+}
+
+HttpEndpoint HttpTransport::classify(const String& url) {
+    if (url.indexOf("/api/telemetry") >= 0) {
+        return HTTP_EP_TELEMETRY;
+    }
+    if (url.indexOf("/api/switch") >= 0) {
+        return HTTP_EP_SWITCH;
+    }
+    if (url.indexOf("/logs") >= 0) {
+        return HTTP_EP_LOGS;
+    }
+    if (url.indexOf("/status") >= 0) {
+        return HTTP_EP_STATUS;
+    }
+    if (url.indexOf("/api/automation/sync") >= 0) {
+        return HTTP_EP_AUTOMATION_SYNC;
+    }
+    if (url.indexOf("/api/automation") >= 0) {
+        return HTTP_EP_AUTOMATION;
+    }
+    return HTTP_EP_OTHER;
+}
+
+const char* HttpTransport::endpointName(HttpEndpoint endpoint) {
+    switch (endpoint) {
+        case HTTP_EP_TELEMETRY:         return "telemetry";
+        case HTTP_EP_SWITCH:            return "switch";
+        case HTTP_EP_AUTOMATION_SYNC:   return "automation.sync";
+        case HTTP_EP_AUTOMATION:        return "automation";
+        case HTTP_EP_LOGS:              return "logs";
+        case HTTP_EP_STATUS:            return "status";
+        default:                        return "other";
+    }
+}
+
+bool HttpTransport::parseUrl(const String& url, String* host, uint16_t* port) {
+    if (!url.startsWith("http://")) {
+        return false;
+    }
+
+    int hostStart = 7;
+    int hostEnd = url.indexOf('/', hostStart);
+    if (hostEnd < 0) {
+        hostEnd = url.length();
+    }
+
+    int colon = url.indexOf(':', hostStart);
+    if (colon >= 0 && colon < hostEnd) {
+        *host = url.substring(hostStart, colon);
+        *port = url.substring(colon + 1, hostEnd).toInt();
+    } else {
+        *host = url.substring(hostStart, hostEnd);
+        *port = 80;
+    }
+    return host->length() > 0 && *port > 0;
+}
+
+void HttpTransport::record(HttpEndpoint endpoint, int code, bool timedOut, const uint32_t* phase_us,
+                           size_t bytesOut, size_t bytesIn, uint32_t retryAfter_s) {
+    portENTER_CRITICAL(&metricsMux);
+    Metrics& m = metrics[endpoint];
+    if (timedOut) {
+        m.timeout++;
+    } else if (code >= 200 && code < 300) {
+        m.success++;
+    } else {
+        m.fail++;
+    }
+    m.last_code = code;
+    m.bytes_out += bytesOut;
+    m.bytes_in += bytesIn;
+    for (int p = 0; p < HTTP_PHASE_COUNT; p++) {
+        if (phase_us[p] != PHASE_SKIPPED) {
+            m.phase[p].add(phase_us[p]);
+        }
+    }
+    portEXIT_CRITICAL(&metricsMux);
+
+    breakerResult(endpoint, code, retryAfter_s);
+}
+
+void HttpTransport::onIntervalHint(HttpIntervalHintCallback callback) {
+    intervalHintCallback = callback;
+}
+
+bool HttpTransport::takeToken(bool take) {
+    portENTER_CRITICAL(&bucketMux);
+    uint32_t now = millis();
+    uint32_t elapsed = min(now - bucketRefillAt, (uint32_t) (BUCKET_CAPACITY / HTTP_RATE_PER_MIN)); // Clamp: no overflow
+    bucketRefillAt = now;
+    bucketUnits = min(BUCKET_CAPACITY, bucketUnits + elapsed * HTTP_RATE_PER_MIN);
+    bool ok = bucketUnits >= TOKEN_UNITS;
+    if (ok && take) {
+        bucketUnits -= TOKEN_UNITS;
+    }
+    portEXIT_CRITICAL(&bucketMux);
+    return ok;
+}
+
+void HttpTransport::returnToken() {
+    portENTER_CRITICAL(&bucketMux);
+    bucketUnits = min(BUCKET_CAPACITY, bucketUnits + TOKEN_UNITS);
+    portEXIT_CRITICAL(&bucketMux);
+}
+
+bool HttpTransport::takeReservedToken() {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    portENTER_CRITICAL(&bucketMux);
+    bool held = tokenHolder != NULL && tokenHolder == self;
+    if (held) {
+        tokenHolder = NULL;
+    }
+    portEXIT_CRITICAL(&bucketMux);
+    return held;
+}
+
+bool HttpTransport::waitForToken(uint32_t max_wait_ms) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (tokenHolder == self) {
+        return true;
+    }
+    uint32_t start = millis();
+    while (!takeToken(true)) {
+        if (millis() - start >= max_wait_ms) {
+            return false;
+        }
+        delay(50);
+    }
+    portENTER_CRITICAL(&bucketMux);
+    tokenHolder = self;
+    portEXIT_CRITICAL(&bucketMux);
+    return true;
+}
+
+void HttpTransport::releaseToken() {
+    if (takeReservedToken()) {
+        returnToken();
+    }
+}
+
+bool HttpTransport::isAvailable(HttpEndpoint endpoint) {
+    if (endpoint >= HTTP_EP_COUNT) {
+        return true;
+    }
+
+    portENTER_CRITICAL(&breakerMux);
+    const Breaker& b = breakers[endpoint];
+    bool available = b.state == HTTP_BREAKER_CLOSED ||
+                     (b.state == HTTP_BREAKER_OPEN && millis() - b.opened_at >= b.wait_ms);
+    portEXIT_CRITICAL(&breakerMux);
+    return available;
+}
+
+bool HttpTransport::breakerAllow(HttpEndpoint endpoint) {
+    bool allow = true;
+    bool probe = false;
+    portENTER_CRITICAL(&breakerMux);
+    Breaker& b = breakers[endpoint];
+    if (b.state == HTTP_BREAKER_OPEN && millis() - b.opened_at >= b.wait_ms) {
+        b.state = HTTP_BREAKER_HALF_OPEN; // This request is the probe
+        probe = true;
+    } else if (b.state != HTTP_BREAKER_CLOSED) {
+        b.rejected++;
+        allow = false;
+    }
+    portEXIT_CRITICAL(&breakerMux);
+
+    if (probe) {
+        ESP_LOGI(TAG, "%s: half open, probe", endpointName(endpoint));
+    }
+    return allow;
+}
+
+void HttpTransport::breakerResult(HttpEndpoint endpoint, int code, uint32_t retryAfter_s) {
+    // 4xx means the server is up and answered, backing off wouldn't fix the request
+    bool failed = code < 0 || code >= 500 || code == 429;
+    bool hold = failed && retryAfter_s > 0; // Server said how long, open now for that
+    HttpBreakerState before;
+    uint32_t wait_ms = 0;
+
+    portENTER_CRITICAL(&breakerMux);
+    Breaker& b = breakers[endpoint];
+    before = b.state;
+    if (!failed) {
+        b.state = HTTP_BREAKER_CLOSED;
+        b.failures = 0;
+        b.backoff_ms = 0;
+    } else {
+        if (b.failures < 255) {
+            b.failures++;
+        }
+        if (hold || b.state == HTTP_BREAKER_HALF_OPEN ||
+            (b.state == HTTP_BREAKER_CLOSED && b.failures >= HTTP_BREAKER_THRESHOLD)) {
+            if (hold) {
+                // At least what the server asked, + up to 10 % so the fleet doesn't return together
+                b.wait_ms = min(retryAfter_s, (uint32_t) HTTP_RETRY_AFTER_MAX) * 1000;
+                b.wait_ms += random(b.wait_ms / 10 + 1);
+            } else {
+                if (b.backoff_ms == 0) {
+                    b.backoff_ms = HTTP_BREAKER_BACKOFF_MIN;
+                } else if (b.state == HTTP_BREAKER_HALF_OPEN) {
+                    b.backoff_ms = min((uint32_t) HTTP_BREAKER_BACKOFF_MAX, b.backoff_ms * 2);
+                }
+                // Equal jitter: [backoff / 2, backoff], devices that lost the server
+                // together don't all come back on the same second
+                b.wait_ms = b.backoff_ms / 2 + random(b.backoff_ms / 2 + 1);
+            }
+            b.opened_at = millis();
+            b.state = HTTP_BREAKER_OPEN;
+            b.trips++;
+            wait_ms = b.wait_ms;
+        }
+    }
+    HttpBreakerState after = b.state;
+    portEXIT_CRITICAL(&breakerMux);
+
+    if (after == HTTP_BREAKER_OPEN && before != HTTP_BREAKER_OPEN) {
+        ESP_LOGW(TAG, "%s: circuit open (%d%s), next try in %lu ms", endpointName(endpoint), code,
+                 hold ? ", Retry-After" : "", (unsigned long) wait_ms);
+    } else if (after == HTTP_BREAKER_CLOSED && before != HTTP_BREAKER_CLOSED) {
+        ESP_LOGI(TAG, "%s: circuit closed", endpointName(endpoint));
+    }
+}
+
+const char* HttpTransport::breakerName(HttpBreakerState state) {
+    switch (state) {
+        case HTTP_BREAKER_OPEN:         return "open";
+        case HTTP_BREAKER_HALF_OPEN:    return "half_open";
+        default:                        return "closed";
+    }
+}
+
+bool HttpTransport::getStats(HttpEndpoint endpoint, HttpEndpointStats* stats) {
+    if (endpoint >= HTTP_EP_COUNT || !stats) {
+        return false;
+    }
+
+    Metrics m;
+    portENTER_CRITICAL(&metricsMux);
+    m = metrics[endpoint];
+    portEXIT_CRITICAL(&metricsMux);
+
+    Breaker b;
+    uint32_t now = millis();
+    portENTER_CRITICAL(&breakerMux);
+    b = breakers[endpoint];
+    portEXIT_CRITICAL(&breakerMux);
+
+    stats->success = m.success;
+    stats->fail = m.fail;
+    stats->timeout = m.timeout;
+    stats->bytes_out = m.bytes_out;
+    stats->bytes_in = m.bytes_in;
+    stats->last_code = m.last_code;
+    stats->limited = m.limited;
+    stats->rejected = b.rejected;
+    stats->trips = b.trips;
+    stats->breaker = b.state;
+    stats->retry_in_ms = 0;
+    if (b.state == HTTP_BREAKER_OPEN && now - b.opened_at < b.wait_ms) {
+        stats->retry_in_ms = b.wait_ms - (now - b.opened_at);
+    }
+    for (int p = 0; p < HTTP_PHASE_COUNT; p++) {
+        stats->phase[p].name = phaseNames[p];
+        m.phase[p].snapshot(&stats->phase[p]);
+    }
+    return (m.success + m.fail + m.timeout + m.limited + b.rejected) > 0;
+}
+
+size_t HttpTransport::summaryJSON(char* output, size_t len) {
+    size_t used = snprintf(output, len, "{");
+    bool first = true;
+    for (int ep = 0; ep < HTTP_EP_COUNT && used < len; ep++) {
+        HttpEndpointStats stats;
+        if (!getStats((HttpEndpoint) ep, &stats)) {
+            continue;
+        }
+        used += snprintf(&output[used], len - used, "%s\"%s\":{\"ok\":%lu,\"fail\":%lu,\"timeout\":%lu,\"in\":%lu,\"out\":%lu,\"code\":%d,\"limited\":%lu,\"cb\":\"%s\",\"rejected\":%lu,\"trips\":%lu",
+                         first ? "" : ",", endpointName((HttpEndpoint) ep), (unsigned long) stats.success,
+                         (unsigned long) stats.fail, (unsigned long) stats.timeout, (unsigned long) stats.bytes_in,
+                         (unsigned long) stats.bytes_out, stats.last_code, (unsigned long) stats.limited,
+                         breakerName(stats.breaker),
+                         (unsigned long) stats.rejected, (unsigned long) stats.trips);
+        for (int p = 0; p < HTTP_PHASE_COUNT && used < len; p++) { // [avg, p99, max] us
+            used += snprintf(&output[used], len - used, ",\"%s\":[%lu,%lu,%lu]", phaseNames[p],
+                             (unsigned long) stats.phase[p].avg_us, (unsigned long) stats.phase[p].p99_us,
+                             (unsigned long) stats.phase[p].max_us);
+        }
+        if (used < len) {
+            used += snprintf(&output[used], len - used, "}");
+        }
+        first = false;
+    }
+    if (used < len) {
+        used += snprintf(&output[used], len - used, "}");
+    }
+    return (used < len) ? used : len - 1;
+}
+
+void HttpTransport::print() {
+    Serial.printf("%-16s %6s %6s %7s %8s %8s %8s %8s %8s %8s (avg/p99 us) %7s %9s %8s %5s\n", "endpoint", "ok",
+                  "fail", "timeout", "in", "out", "dns", "connect", "ttfb", "total", "limited", "circuit", "rejected",
+                  "trips");
+    for (int ep = 0; ep < HTTP_EP_COUNT; ep++) {
+        HttpEndpointStats stats;
+        if (!getStats((HttpEndpoint) ep, &stats)) {
+            continue;
+        }
+        Serial.printf("%-16s %6lu %6lu %7lu %8lu %8lu", endpointName((HttpEndpoint) ep), (unsigned long) stats.success,
+                      (unsigned long) stats.fail, (unsigned long) stats.timeout, (unsigned long) stats.bytes_in,
+                      (unsigned long) stats.bytes_out);
+        for (int p = 0; p < HTTP_PHASE_COUNT; p++) {
+            Serial.printf(" %8lu", (unsigned long) stats.phase[p].avg_us);
+        }
+        Serial.printf(" %20lu %9s %8lu %5lu", (unsigned long) stats.limited, breakerName(stats.breaker),
+                      (unsigned long) stats.rejected, (unsigned long) stats.trips);
+        if (stats.retry_in_ms) {
+            Serial.printf(" retry in %lu ms", (unsigned long) stats.retry_in_ms);
+        }
+        Serial.printf("\n%-16s %6s %6s %7s %8s %8s", "", "", "", "", "", "");
+        for (int p = 0; p < HTTP_PHASE_COUNT; p++) {
+            Serial.printf(" %8lu", (unsigned long) stats.phase[p].p99_us);
+        }
+        Serial.printf("\n");
+    }
+}
+
+void HttpTransport::reset() {
+    portENTER_CRITICAL(&metricsMux);
+    for (int ep = 0; ep < HTTP_EP_COUNT; ep++) {
+        metrics[ep].success = 0;
+        metrics[ep].fail = 0;
+        metrics[ep].timeout = 0;
+        metrics[ep].bytes_out = 0;
+        metrics[ep].bytes_in = 0;
+        metrics[ep].last_code = 0;
+        metrics[ep].limited = 0;
+        for (int p = 0; p < HTTP_PHASE_COUNT; p++) {
+            metrics[ep].phase[p].clear();
+        }
+    }
+    portEXIT_CRITICAL(&metricsMux);
+
+    portENTER_CRITICAL(&breakerMux);
+    for (int ep = 0; ep < HTTP_EP_COUNT; ep++) { // Counters only, an open breaker stay open
+        breakers[ep].rejected = 0;
+        breakers[ep].trips = 0;
+    }
+    portEXIT_CRITICAL(&breakerMux);
+}
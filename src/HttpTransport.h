@@ -0,0 +1,159 @@
+#pragma once
+
+#include <Arduino.h>
+#include "Perf.h"
+
+// ===================================================================
+// Shared HTTP request path for the API clients
+// Resolve DNS and open the socket itself before handing the connected
+// WiFiClient to HTTPClient, so every request is split into DNS /
+// connect / first byte (request sent + response headers) / total.
+// Counters and histograms are kept per endpoint group.
+//
+// Each endpoint group also has a circuit breaker: after
+// HTTP_BREAKER_THRESHOLD failures in a row (connection error, timeout,
+// 5xx, 429) request() return HTTP_ERROR_CIRCUIT_OPEN at once, without
+// DNS / socket, for a jittered backoff (2 s doubling up to 5 min).
+// When it expire one request go through as a probe (half open), the
+// others are still rejected; success close the breaker, failure
+// open it again with the next backoff.
+//
+// All endpoints share one token bucket (HTTP_RATE_PER_MIN, burst
+// HTTP_RATE_BURST) so a burst of sensor-change telemetry, relay logs
+// and retries can't exceed the device budget: request() return
+// HTTP_ERROR_RATE_LIMITED when it's empty. ApiWorker reserve a token
+// first (waitForToken), so a relay change can't lose it to a poll.
+//
+// Server hints: Retry-After (seconds) on a 429 / 5xx open the breaker
+// of that endpoint for that long (max HTTP_RETRY_AFTER_MAX), and an
+// X-Poll-Interval header (seconds) is passed to onIntervalHint.
+// ===================================================================
+
+#define HTTP_METRICS_MQTT_TOPIC     "@msg/diag/http"
+
+#define HTTP_BREAKER_THRESHOLD      3       // Failures in a row to open
+#define HTTP_BREAKER_BACKOFF_MIN    2000    // ms, first open
+#define HTTP_BREAKER_BACKOFF_MAX    300000  // ms, 5 min
+#define HTTP_ERROR_CIRCUIT_OPEN     (-20)   // Rejected by the breaker, HTTPC_ERROR_* stop at -11
+#define HTTP_ERROR_RATE_LIMITED     (-21)   // Token bucket empty
+
+// Normal pace is ~72 / min (switch poll 60, telemetry 6, automation sync 6)
+#define HTTP_RATE_PER_MIN           120
+#define HTTP_RATE_BURST             20
+
+#define HTTP_RETRY_AFTER_MAX        3600    // s
+
+enum HttpEndpoint : uint8_t {
+    HTTP_EP_TELEMETRY,          // /api/telemetry
+    HTTP_EP_SWITCH,             // /api/switch
+    HTTP_EP_AUTOMATION_SYNC,    // /api/automation/sync
+    HTTP_EP_AUTOMATION,         // other /api/automation/...
+    HTTP_EP_LOGS,               // .../logs
+    HTTP_EP_STATUS,             // .../status
+    HTTP_EP_OTHER,
+    HTTP_EP_COUNT
+};
+
+enum HttpPhase : uint8_t {
+    HTTP_PHASE_DNS,
+    HTTP_PHASE_CONNECT,
+    HTTP_PHASE_FIRST_BYTE,
+    HTTP_PHASE_TOTAL,
+    HTTP_PHASE_COUNT
+};
+
+enum HttpBreakerState : uint8_t {
+    HTTP_BREAKER_CLOSED,
+    HTTP_BREAKER_OPEN,
+    HTTP_BREAKER_HALF_OPEN  // Probe in flight
+};
+
+// X-Poll-Interval seen in a response, called from the requesting task
+typedef void (*HttpIntervalHintCallback)(HttpEndpoint endpoint, uint32_t seconds);
+
+struct HttpEndpointStats {
+    uint32_t success;       // 2xx
+    uint32_t fail;          // Non 2xx or connection error
+    uint32_t timeout;       // Connect / read timeout (not counted in fail)
+    uint32_t bytes_out;     // Request body
+    uint32_t bytes_in;      // Response body
+    int last_code;
+    uint32_t limited;       // Not sent, token bucket empty
+    uint32_t rejected;      // Not sent, breaker open
+    uint32_t trips;         // Closed / half open -> open
+    HttpBreakerState breaker;
+    uint32_t retry_in_ms;   // Open: time left before the probe
+    PerfSnapshot phase[HTTP_PHASE_COUNT];
+};
+
+class HttpTransport {
+public:
+    /**
+     * @brief Send one request and record its metrics
+     * @param method "GET", "POST", "PUT", "PATCH"
+     * @param apiKey X-API-KEY header, NULL or "" = none
+     * @param payload JSON body, NULL = none
+     * @param response body (read for every status code), NULL = discard
+     * @return HTTP status code, or HTTPC_ERROR_* / HTTP_ERROR_CIRCUIT_OPEN (< 0)
+     */
+    static int request(const char* method, const String& url, const char* apiKey,
+                       const char* payload, String* response, uint16_t timeout);
+
+    // false while the breaker is open and the probe isn't due yet (or in flight),
+    // a request() now would be rejected. Lets callers skip the work and the log.
+    static bool isAvailable(HttpEndpoint endpoint);
+
+    // Block until the token bucket has a token and reserve it for the calling task,
+    // its next request() spend it instead of taking one. false after max_wait_ms.
+    // One reservation at a time (ApiWorker task), calling again while holding it return true
+    static bool waitForToken(uint32_t max_wait_ms);
+
+    // Give back a reservation no request() used (job skipped), no-op if none
+    static void releaseToken();
+
+    static void onIntervalHint(HttpIntervalHintCallback callback);
+
+    static HttpEndpoint classify(const String& url);
+    static const char* endpointName(HttpEndpoint endpoint);
+
+    static bool getStats(HttpEndpoint endpoint, HttpEndpointStats* stats);
+    static size_t summaryJSON(char* output, size_t len); // {"telemetry":{"ok":..,"fail":..,"timeout":..,"in":..,"out":..,"total":{..}},...}
+    static void print(); // Table over Serial
+    static const char* breakerName(HttpBreakerState state);
+    static void reset();
+
+private:
+    struct Metrics {
+        uint32_t success;
+        uint32_t fail;
+        uint32_t timeout;
+        uint32_t bytes_out;
+        uint32_t bytes_in;
+        int last_code;
+        uint32_t limited;
+        PerfHistogram phase[HTTP_PHASE_COUNT];
+    };
+
+    struct Breaker {
+        HttpBreakerState state;
+        uint8_t failures;       // In a row
+        uint32_t opened_at;     // millis()
+        uint32_t wait_ms;       // Jittered backoff of this open
+        uint32_t backoff_ms;    // 0 = HTTP_BREAKER_BACKOFF_MIN
+        uint32_t rejected;
+        uint32_t trips;
+    };
+
+    static bool parseUrl(const String& url, String* host, uint16_t* port);
+    static void record(HttpEndpoint endpoint, int code, bool timedOut, const uint32_t* phase_us,
+                       size_t bytesOut, size_t bytesIn, uint32_t retryAfter_s = 0);
+    static bool takeToken(bool take);
+    static bool takeReservedToken();
+    static void returnToken();
+    static bool breakerAllow(HttpEndpoint endpoint);
+    static void breakerResult(HttpEndpoint endpoint, int code, uint32_t retryAfter_s);
+
+    static Metrics metrics[HTTP_EP_COUNT];
+    static Breaker breakers[HTTP_EP_COUNT];
+    static HttpIntervalHintCallback intervalHintCallback;
+};
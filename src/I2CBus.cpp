@@ -0,0 +1,203 @@
+#include "I2CBus.h"
+
+static const char* TAG = "I2CBus";
+
+TwoWire* I2CBus::wire = NULL;
+SemaphoreHandle_t I2CBus::mutex = NULL;
+uint32_t I2CBus::clock = 0;
+I2CDeviceStats I2CBus::devices[I2C_BUS_MAX_DEVICES] = {};
+int I2CBus::deviceCount = 0;
+
+bool I2CBus::begin(TwoWire& bus) {
+    if (wire) {
+        return true;
+    }
+    wire = &bus;
+    mutex = xSemaphoreCreateRecursiveMutex();
+
+    static const uint32_t clocks[] = I2C_BUS_CLOCKS;
+    static const uint8_t probeAddr[] = I2C_BUS_PROBE_ADDRESSES;
+    const int clockCount = sizeof(clocks) / sizeof(clocks[0]);
+
+    // Scan at the slowest clock
+    wire->begin();
+    wire->setClock(clocks[clockCount - 1]);
+    uint8_t found[sizeof(probeAddr)];
+    int foundCount = 0;
+    for (int i = 0; i < (int)sizeof(probeAddr); i++) {
+        if (probeRaw(probeAddr[i])) {
+            found[foundCount++] = probeAddr[i];
+            findDevice(probeAddr[i], true);
+        }
+    }
+
+    // Fastest clock that every device answer every time
+    clock = clocks[clockCount - 1];
+    for (int c = 0; c < clockCount - 1; c++) {
+        wire->setClock(clocks[c]);
+        bool stable = true;
+        for (int i = 0; (i < foundCount) && stable; i++) {
+            for (int n = 0; n < I2C_BUS_PROBE_COUNT; n++) {
+                if (!probeRaw(found[i])) {
+                    ESP_LOGW(TAG, "0x%02X unstable at %lu Hz", found[i], (unsigned long)clocks[c]);
+                    stable = false;
+                    break;
+                }
+            }
+        }
+        if (stable) {
+            clock = clocks[c];
+            break;
+        }
+    }
+    wire->setClock(clock);
+
+    ESP_LOGI(TAG, "I2C clock %lu Hz, %d device(s) found", (unsigned long)clock, foundCount);
+    return foundCount > 0;
+}
+
+uint32_t I2CBus::getClock() {
+    return clock;
+}
+
+bool I2CBus::lock(uint8_t addr, uint32_t timeout_ms) {
+    if (!mutex) {
+        return false;
+    }
+    if (xSemaphoreTakeRecursive(mutex, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        ESP_LOGW(TAG, "Bus busy, 0x%02X wait > %lu ms", addr, (unsigned long)timeout_ms);
+        I2CDeviceStats* device = findDevice(addr, false); // Not holding the lock, don't add to the table
+        if (device) {
+            device->busy++;
+        }
+        return false;
+    }
+    return true;
+}
+
+void I2CBus::unlock() {
+    xSemaphoreGiveRecursive(mutex);
+}
+
+bool I2CBus::probeRaw(uint8_t addr) {
+    wire->beginTransmission(addr);
+    return wire->endTransmission() == 0;
+}
+
+bool I2CBus::probe(uint8_t addr) {
+    if (!lock(addr)) {
+        return false;
+    }
+    bool result = probeRaw(addr);
+    unlock();
+    return result;
+}
+
+bool I2CBus::write(uint8_t addr, const uint8_t* data, size_t len) {
+    if (!lock(addr)) {
+        return false;
+    }
+    uint32_t start = micros();
+    wire->beginTransmission(addr);
+    wire->write(data, len);
+    bool result = wire->endTransmission() == 0;
+    record(addr, result, micros() - start);
+    unlock();
+    return result;
+}
+
+bool I2CBus::read(uint8_t addr, uint8_t* data, size_t len) {
+    if (!lock(addr)) {
+        return false;
+    }
+    uint32_t start = micros();
+    bool result = wire->requestFrom(addr, len) == len;
+    if (result) {
+        wire->readBytes(data, len);
+    }
+    record(addr, result, micros() - start);
+    unlock();
+    return result;
+}
+
+void I2CBus::record(uint8_t addr, bool success, uint32_t latency_us) { // Caller hold the lock
+    I2CDeviceStats* device = findDevice(addr, true);
+    if (!device) {
+        return;
+    }
+    device->transactions++;
+    if (!success) {
+        device->errors++;
+    }
+    device->last_latency_us = latency_us;
+    device->total_latency_us += latency_us;
+    if (latency_us > device->max_latency_us) {
+        device->max_latency_us = latency_us;
+    }
+}
+
+I2CDeviceStats* I2CBus::findDevice(uint8_t addr, bool create) {
+    for (int i = 0; i < deviceCount; i++) {
+        if (devices[i].addr == addr) {
+            return &devices[i];
+        }
+    }
+    if (!create || deviceCount >= I2C_BUS_MAX_DEVICES) {
+        return NULL;
+    }
+    memset(&devices[deviceCount], 0, sizeof(I2CDeviceStats));
+    devices[deviceCount].addr = addr;
+    return &devices[deviceCount++];
+}
+
+int I2CBus::getDeviceCount() {
+    return deviceCount;
+}
+
+bool I2CBus::getDeviceStats(int index, I2CDeviceStats* stats) {
+    if (index < 0 || index >= deviceCount || !stats) {
+        return false;
+    }
+    if (!lock(devices[index].addr)) {
+        return false;
+    }
+    *stats = devices[index];
+    unlock();
+    return true;
+}
+
+size_t I2CBus::summaryJSON(char* output, size_t len) {
+    size_t used = snprintf(output, len, "{\"clock\":%lu", (unsigned long)clock);
+    for (int i = 0; i < deviceCount && used < len; i++) {
+        I2CDeviceStats stats;
+        if (!getDeviceStats(i, &stats)) {
+            continue;
+        }
+        uint32_t avg = stats.transactions ? (uint32_t)(stats.total_latency_us / stats.transactions) : 0;
+        used += snprintf(&output[used], len - used,
+                         ",\"0x%02X\":{\"n\":%lu,\"err\":%lu,\"busy\":%lu,\"avg_us\":%lu,\"max_us\":%lu,\"last_us\":%lu}",
+                         stats.addr, (unsigned long)stats.transactions, (unsigned long)stats.errors,
+                         (unsigned long)stats.busy, (unsigned long)avg, (unsigned long)stats.max_latency_us,
+                         (unsigned long)stats.last_latency_us);
+    }
+    if (used < len) {
+        used += snprintf(&output[used], len - used, "}");
+    }
+    return (used < len) ? used : len - 1;
+}
+
+void I2CBus::print() {
+    Serial.printf("I2C clock %lu Hz\n", (unsigned long)clock);
+    Serial.printf("%-6s %8s %6s %6s %8s %8s %8s (us)\n", "addr", "n", "err", "busy", "avg", "max", "last");
+    for (int i = 0; i < deviceCount; i++) {
+        I2CDeviceStats stats;
+        if (!getDeviceStats(i, &stats)) {
+            Serial.printf("0x%02X   bus busy\n", devices[i].addr);
+            continue;
+        }
+        uint32_t avg = stats.transactions ? (uint32_t)(stats.total_latency_us / stats.transactions) : 0;
+        Serial.printf("0x%02X   %8lu %6lu %6lu %8lu %8lu %8lu\n", stats.addr, (unsigned long)stats.transactions,
+                      (unsigned long)stats.errors, (unsigned long)stats.busy, (unsigned long)avg,
+                      (unsigned long)stats.max_latency_us, (unsigned long)stats.last_latency_us);
+    }
+}
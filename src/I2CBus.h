@@ -0,0 +1,88 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+
+// ===================================================================
+// I2C bus manager
+// - Clock probed at boot: fastest clock every device answer reliably
+// - One recursive mutex, transactions from every task are serialized
+// - Per-device transaction latency and error counters, shown by the
+//   "perf" serial command and published to I2C_BUS_MQTT_TOPIC
+// ===================================================================
+
+#define I2C_BUS_CLOCKS              { 400000, 100000, 50000, 10000 } // Fastest first, last one is used to scan
+#define I2C_BUS_PROBE_ADDRESSES     { 0x51, 0x68, 0x6F, 0x44, 0x45, 0x40, 0x23, 0x5C } // RTC, SHTxx, BH1750
+#define I2C_BUS_PROBE_COUNT         20    // Address probe per device per clock, all must ACK
+#define I2C_BUS_MAX_DEVICES         12
+#define I2C_BUS_LOCK_TIMEOUT        100   // ms
+#define I2C_BUS_MQTT_TOPIC          "@msg/diag/i2c"
+
+struct I2CDeviceStats {
+    uint8_t addr;
+    uint32_t transactions;
+    uint32_t errors;            // NACK / short read
+    uint32_t busy;              // Bus lock timeout
+    uint32_t last_latency_us;
+    uint32_t max_latency_us;
+    uint64_t total_latency_us;  // Average = total / transactions
+};
+
+class I2CBus {
+public:
+    static bool begin(TwoWire& wire = Wire); // Start bus and probe the clock
+    static uint32_t getClock();
+
+    static bool lock(uint8_t addr, uint32_t timeout_ms = I2C_BUS_LOCK_TIMEOUT);
+    static void unlock();
+
+    static bool probe(uint8_t addr);
+    static bool write(uint8_t addr, const uint8_t* data, size_t len);
+    static bool read(uint8_t addr, uint8_t* data, size_t len);
+
+    // For library calls (RTC, SHT2x) done between lock() and unlock()
+    static void record(uint8_t addr, bool success, uint32_t latency_us);
+
+    static int getDeviceCount();
+    static bool getDeviceStats(int index, I2CDeviceStats* stats);
+    static size_t summaryJSON(char* output, size_t len); // {"clock":..,"0x44":{"n":..,"err":..,"busy":..,"avg_us":..,"max_us":..,"last_us":..},...}
+    static void print(); // Table over Serial
+
+private:
+    static bool probeRaw(uint8_t addr);
+    static I2CDeviceStats* findDevice(uint8_t addr, bool create);
+
+    static TwoWire* wire;
+    static SemaphoreHandle_t mutex;
+    static uint32_t clock;
+    static I2CDeviceStats devices[I2C_BUS_MAX_DEVICES];
+    static int deviceCount;
+};
+
+// Scope lock for library calls, latency is recorded on exit
+class I2CBusLock {
+public:
+    I2CBusLock(uint8_t addr) : addr(addr), success(true), start(micros()) {
+        locked = I2CBus::lock(addr);
+    }
+    ~I2CBusLock() {
+        if (locked) {
+            I2CBus::record(addr, success, micros() - start);
+            I2CBus::unlock();
+        }
+    }
+
+    bool isLocked() const { return locked; }
+    bool check(bool result) { // Mark the transaction fail if result is false
+        if (!result) {
+            success = false;
+        }
+        return result;
+    }
+
+private:
+    uint8_t addr;
+    bool locked;
+    bool success;
+    uint32_t start;
+};
@@ -0,0 +1,159 @@
+#include "LogBuffer.h"
+#include "SystemHealth.h"
+#include <esp_heap_caps.h>
+
+static const char* TAG = "LogBuffer";
+
+static portMUX_TYPE logMux = portMUX_INITIALIZER_UNLOCKED;
+
+char* LogBuffer::buffer = NULL;
+size_t LogBuffer::size = 0;
+uint32_t LogBuffer::written = 0;
+uint32_t LogBuffer::drained = 0;
+uint32_t LogBuffer::dropped = 0;
+vprintf_like_t LogBuffer::defaultVprintf = NULL;
+
+bool LogBuffer::begin() {
+    if (buffer) {
+        return true;
+    }
+
+    size = LOG_BUFFER_SIZE;
+    buffer = (char*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!buffer) {
+        size = LOG_BUFFER_SIZE_INTERNAL;
+        buffer = (char*)heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (!buffer) {
+        size = 0;
+        ESP_LOGE(TAG, "No memory for log buffer, keep synchronous log");
+        return false;
+    }
+
+#ifdef CORE_DEBUG_LEVEL
+    esp_log_level_set("*", (esp_log_level_t)CORE_DEBUG_LEVEL); // Runtime level start at the build level
+#endif
+    TaskHandle_t taskHandle = NULL;
+    xTaskCreatePinnedToCore(drainTask, "LogTask", LOG_TASK_STACK_SIZE, NULL, LOG_TASK_PRIORITY, &taskHandle, LOG_TASK_CORE);
+    SystemHealth::registerTask(taskHandle, "LogTask", LOG_TASK_STACK_SIZE);
+    defaultVprintf = esp_log_set_vprintf(logVprintf);
+
+    ESP_LOGI(TAG, "Async log started, %u byte buffer", (unsigned)size);
+    return true;
+}
+
+int LogBuffer::logVprintf(const char* format, va_list args) {
+    char line[LOG_LINE_MAX];
+    int len = vsnprintf(line, sizeof(line), format, args);
+    if (len < 0) {
+        return len;
+    }
+    if (len >= (int)sizeof(line)) {
+        len = sizeof(line) - 1;
+        line[len - 1] = '\n';
+    }
+    append(line, len);
+    return len;
+}
+
+void LogBuffer::append(const char* data, size_t len) {
+    portENTER_CRITICAL(&logMux); // Only a memcpy inside, formatting is done by the caller
+    size_t index = written % size;
+    size_t first = (len < (size - index)) ? len : (size - index);
+    memcpy(&buffer[index], data, first);
+    memcpy(buffer, &data[first], len - first);
+    written += len;
+    if ((written - drained) > size) { // UART too slow, oldest line overwritten
+        dropped += (written - drained) - size;
+        drained = written - size;
+    }
+    portEXIT_CRITICAL(&logMux);
+}
+
+void LogBuffer::drainTask(void*) {
+    static char chunk[LOG_DRAIN_CHUNK];
+    while (1) {
+        portENTER_CRITICAL(&logMux);
+        uint32_t position = drained;
+        portEXIT_CRITICAL(&logMux);
+
+        size_t len = read(position, chunk, sizeof(chunk));
+        if (len == 0) {
+            vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL));
+            continue;
+        }
+
+        fwrite(chunk, 1, len, stdout); // Same UART the default log use, block this task only
+
+        portENTER_CRITICAL(&logMux);
+        if (drained == position) { // Not moved by append() while writing
+            drained += len;
+        }
+        portEXIT_CRITICAL(&logMux);
+    }
+}
+
+bool LogBuffer::setLevel(const char* tag, const char* level) {
+    static const struct {
+        const char* name;
+        esp_log_level_t level;
+    } levels[] = {
+        { "none", ESP_LOG_NONE },
+        { "error", ESP_LOG_ERROR },
+        { "warn", ESP_LOG_WARN },
+        { "info", ESP_LOG_INFO },
+        { "debug", ESP_LOG_DEBUG },
+        { "verbose", ESP_LOG_VERBOSE },
+    };
+
+    if (!tag || !level || tag[0] == '\0') {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+        if (strcasecmp(level, levels[i].name) == 0) {
+            esp_log_level_set(tag, levels[i].level);
+            ESP_LOGI(TAG, "Log level %s = %s", tag, levels[i].name);
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t LogBuffer::getWritePosition() {
+    portENTER_CRITICAL(&logMux);
+    uint32_t position = written;
+    portEXIT_CRITICAL(&logMux);
+    return position;
+}
+
+uint32_t LogBuffer::getOldestPosition() {
+    portENTER_CRITICAL(&logMux);
+    uint32_t position = (written > size) ? (written - size) : 0;
+    portEXIT_CRITICAL(&logMux);
+    return position;
+}
+
+size_t LogBuffer::read(uint32_t position, char* output, size_t len) {
+    if (!buffer) {
+        return 0;
+    }
+
+    portENTER_CRITICAL(&logMux);
+    size_t count = 0;
+    if ((written - position) <= size) { // Still in the buffer
+        count = written - position;
+        if (count > len) {
+            count = len;
+        }
+        size_t index = position % size;
+        size_t first = (count < (size - index)) ? count : (size - index);
+        memcpy(output, &buffer[index], first);
+        memcpy(&output[first], buffer, count - first);
+    }
+    portEXIT_CRITICAL(&logMux);
+    return count;
+}
+
+uint32_t LogBuffer::getDropped() {
+    return dropped;
+}
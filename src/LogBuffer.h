@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ===================================================================
+// Asynchronous log sink (needs -DUSE_ESP_IDF_LOG)
+// ESP_LOGx lines are formatted into a RAM ring buffer (PSRAM if any)
+// and written to the UART by a low priority task, the caller never
+// waits for the 115200 baud line. The last LOG_BUFFER_SIZE bytes stay
+// in the buffer so they can be read back over MQTT.
+// ===================================================================
+
+#define LOG_BUFFER_SIZE             (32 * 1024) // PSRAM
+#define LOG_BUFFER_SIZE_INTERNAL    (4 * 1024)  // No PSRAM
+#define LOG_LINE_MAX                256         // Longer lines are cut
+#define LOG_DRAIN_INTERVAL          20          // ms
+#define LOG_DRAIN_CHUNK             256
+#define LOG_TASK_STACK_SIZE         3072
+#define LOG_TASK_PRIORITY           1
+#define LOG_TASK_CORE               0
+
+// MQTT dump (@private/diag/log -> @msg/diag/log)
+#define LOG_MQTT_TOPIC              "@msg/diag/log"
+#define LOG_MQTT_DEFAULT_KB         4
+#define LOG_MQTT_MESSAGE_MAX        4096 // Larger history is split into several messages
+
+class LogBuffer {
+public:
+    static bool begin();
+
+    /**
+     * @brief Set log level at runtime
+     * @param tag module TAG, "*" = every tag
+     * @param level "none", "error", "warn", "info", "debug", "verbose"
+     */
+    static bool setLevel(const char* tag, const char* level);
+
+    // History read, position is an absolute byte count since boot
+    static uint32_t getWritePosition();
+    static uint32_t getOldestPosition();
+    static size_t read(uint32_t position, char* output, size_t len); // 0 if position was overwritten
+
+    static uint32_t getDropped(); // Bytes not sent to UART because the buffer was full
+
+private:
+    static int logVprintf(const char* format, va_list args);
+    static void append(const char* data, size_t len);
+    static void drainTask(void* arg);
+
+    static char* buffer;
+    static size_t size;
+    static uint32_t written;
+    static uint32_t drained;
+    static uint32_t dropped;
+    static vprintf_like_t defaultVprintf;
+};
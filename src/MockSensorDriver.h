@@ -0,0 +1,66 @@
+#pragma once
+
+#include "SensorDriver.h"
+
+// ===================================================================
+// Mock sensor driver (no Arduino dependency)
+// Value come from a callback so host builds can feed traces, fault
+// patterns or constant values into SensorRegistry.
+// ===================================================================
+
+// Return value for channel ch of sample number index, NAN = no value this time
+typedef float (*MockSensorSource)(SensorChannel ch, uint32_t index, void *arg);
+
+class MockSensorDriver : public SensorDriver {
+  public:
+    MockSensorDriver(const char *driverName, uint8_t channelMask, uint32_t conversionTime,
+                     MockSensorSource source, void *arg = 0)
+      : driverName(driverName), channelMask(channelMask), conversionTime(conversionTime),
+        source(source), arg(arg), present(true), failTrigger(false),
+        triggerCount(0), collectCount(0), sampleIndex(0) { }
+
+    const char * name() const { return driverName; }
+    uint8_t channels() const { return channelMask; }
+
+    bool begin() { return present; }
+
+    SensorStep trigger(uint32_t *waitTime) {
+      triggerCount++;
+      *waitTime = conversionTime;
+      return failTrigger ? SENSOR_STEP_FAIL : SENSOR_STEP_DONE;
+    }
+
+    SensorStep collect(SensorReading *reading, uint32_t *) {
+      collectCount++;
+      for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+        if (!(channelMask & SENSOR_CH_MASK(ch))) {
+          continue;
+        }
+        float value = source ? source((SensorChannel) ch, sampleIndex, arg) : 0.0f;
+        if (value == value) { // Skip NAN
+          reading->set((SensorChannel) ch, value);
+        }
+      }
+      sampleIndex++;
+      return SENSOR_STEP_DONE;
+    }
+
+    // Fault injection
+    void setPresent(bool value) { present = value; }
+    void setFailTrigger(bool value) { failTrigger = value; }
+
+    uint32_t getTriggerCount() const { return triggerCount; }
+    uint32_t getCollectCount() const { return collectCount; }
+
+  private:
+    const char *driverName;
+    uint8_t channelMask;
+    uint32_t conversionTime;
+    MockSensorSource source;
+    void *arg;
+    bool present;
+    bool failTrigger;
+    uint32_t triggerCount;
+    uint32_t collectCount;
+    uint32_t sampleIndex;
+};
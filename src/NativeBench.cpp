@@ -0,0 +1,272 @@
+#ifndef ARDUINO
+
+#include <Arduino.h>
+#include <chrono>
+#include <math.h>
+#include "NativeBench.h"
+#include "ApiPayload.h"
+#include "SensorFilter.h"
+#include "SensorRegistry.h"
+#include "UserConfigs.h"
+
+#define BENCH_DEFAULT_ITERATIONS  20000
+#define BENCH_WARMUP_ITERATIONS   100
+#define BENCH_DEFAULT_TOLERANCE   25  // %
+#define BENCH_MAX_CASES           16
+
+// Response bodies as the API send them, sync is a full room (12 timers, 8 sensors),
+// unused timer slots carry the 3000 minute (50:00) disabled marker
+static const char SWITCH_LIST_JSON[] =
+  "{\"success\":true,\"data\":["
+  "{\"id\":1,\"name\":\"Switch 1\",\"state\":\"on\",\"version\":412,\"origin\":\"web\",\"updatedAt\":\"2025-10-11T20:23:16.033Z\"},"
+  "{\"id\":2,\"name\":\"Switch 2\",\"state\":\"off\",\"version\":87,\"origin\":\"AUTO_API_TIMER\",\"updatedAt\":\"2025-10-11T20:23:16.033Z\"},"
+  "{\"id\":3,\"name\":\"Switch 3\",\"state\":\"off\",\"version\":3,\"origin\":\"MANUAL_MQTT\",\"updatedAt\":\"2025-10-11T20:20:02.517Z\"},"
+  "{\"id\":4,\"name\":\"Switch 4\",\"state\":\"on\",\"version\":1290,\"origin\":\"AUTO_API_SENSOR\",\"updatedAt\":\"2025-10-11T19:58:40.101Z\"}]}";
+
+static const char SWITCH_ONE_JSON[] =
+  "{\"success\":true,\"data\":{\"id\":2,\"name\":\"Switch 2\",\"state\":\"on\",\"updatedAt\":\"2025-10-11T20:23:16.033Z\"}}";
+
+#define SYNC_TIMER(relay, timer, on, off) \
+  "{\"id\":1" #relay #timer ",\"relayId\":" #relay ",\"timerId\":" #timer ",\"enabled\":true," \
+  "\"days\":[1,1,1,1,1,0,0],\"timeOn\":\"" on "\",\"timeOff\":\"" off "\",\"description\":\"Mist cycle\"}"
+
+#define SYNC_SENSOR(relay, type, mode, min, max) \
+  "{\"id\":" #relay ",\"relayId\":" #relay ",\"sensorType\":\"" type "\",\"enabled\":true," \
+  "\"controlMode\":\"" mode "\",\"minValue\":" #min ",\"maxValue\":" #max ",\"hysteresis\":2.0," \
+  "\"actionOnTrigger\":\"turn_on\"}"
+
+static const char SYNC_JSON[] =
+  "{\"success\":true,\"data\":{\"syncToken\":\"7f3c2a91e4b05d68\",\"serverTime\":\"2025-10-11T20:23:16.033Z\","
+  "\"timers\":["
+  SYNC_TIMER(0, 0, "06:00:00", "06:15:00") "," SYNC_TIMER(0, 1, "12:00:00", "12:15:00") ","
+  SYNC_TIMER(0, 2, "18:00:00", "18:15:00") "," SYNC_TIMER(1, 0, "07:00:00", "19:00:00") ","
+  SYNC_TIMER(1, 1, "50:00:00", "50:00:00") "," SYNC_TIMER(1, 2, "50:00:00", "50:00:00") ","
+  SYNC_TIMER(2, 0, "08:00:00", "08:30:00") "," SYNC_TIMER(2, 1, "14:00:00", "14:30:00") ","
+  SYNC_TIMER(2, 2, "20:00:00", "20:30:00") "," SYNC_TIMER(3, 0, "00:00:00", "23:59:00") ","
+  SYNC_TIMER(3, 1, "50:00:00", "50:00:00") "," SYNC_TIMER(3, 2, "50:00:00", "50:00:00")
+  "],\"sensors\":["
+  SYNC_SENSOR(0, "humidity", "min_trigger", 80.0, 95.0) "," SYNC_SENSOR(0, "temperature", "max_trigger", 0, 30.0) ","
+  SYNC_SENSOR(1, "light", "range", 200.0, 2000.0) "," SYNC_SENSOR(1, "temperature", "range", 22.0, 28.0) ","
+  SYNC_SENSOR(2, "soil", "min_trigger", 40.0, 0) "," SYNC_SENSOR(2, "humidity", "range", 70.0, 90.0) ","
+  SYNC_SENSOR(3, "temperature", "max_trigger", 0, 32.0) "," SYNC_SENSOR(3, "humidity", "max_trigger", 0, 98.0)
+  "]}}";
+
+// Soil moisture (%) at SENSOR_SAMPLE_INTERVAL drying out for 2 min, then watered: 100.0 = probe
+// contact lost for a sample or two, NAN = failed read. The watering step is taller than
+// SENSOR_FILTER_SOIL allow per second, it is taken after SENSOR_FILTER_MAX_REJECTS samples.
+static const float SOIL_TRACE[] = {
+  21.9f, 21.8f, 22.0f, 21.6f, 21.9f, 21.8f, 21.5f, 21.8f, 21.5f, 21.7f, 21.4f, 21.4f,
+  21.6f, 21.8f, 21.3f, 21.3f, 21.5f, 21.7f, 21.4f, 21.3f, 21.6f, 21.0f, 21.5f, 21.1f,
+  21.0f, 20.9f, 21.0f, 21.3f, 20.9f, 21.1f, 100.0f, 20.9f, 21.0f, 20.6f, 20.6f, 20.7f,
+  20.9f, 20.7f, 20.6f, 20.8f, 20.6f, 20.5f, 20.8f, 20.7f, 20.4f, 20.5f, 20.5f, 20.7f,
+  20.5f, 20.2f, 20.6f, 20.1f, 20.2f, 20.4f, 20.0f, 20.2f, 19.9f, 20.2f, 20.2f, 20.1f,
+  20.2f, 19.9f, 20.1f, 20.0f, 19.9f, 19.8f, 20.0f, 20.0f, 19.7f, 19.8f, 19.4f, 19.8f,
+  19.7f, 19.9f, 19.7f, 100.0f, 100.0f, 19.5f, 19.1f, 19.3f, 19.1f, 19.1f, 19.0f, 19.4f,
+  19.0f, 19.0f, 19.1f, 19.3f, 18.8f, 19.0f, 19.0f, 19.2f, 19.1f, 19.1f, 18.7f, 18.8f,
+  18.7f, 19.0f, 19.0f, 18.5f, 18.5f, 18.5f, 18.4f, 18.6f, 18.6f, 18.4f, 18.2f, 18.4f,
+  18.3f, 18.4f, 18.6f, 18.4f, 18.3f, 18.3f, 18.3f, 17.9f, 18.4f, 18.3f, 18.3f, 18.2f,
+  84.9f, 84.9f, 84.7f, 85.0f, 84.7f, 84.7f, 84.7f, 84.7f, 84.8f, 84.6f, 84.5f, 84.6f,
+  84.6f, 84.7f, 84.5f, 85.0f, 84.8f, 84.5f, 84.6f, 84.6f, 84.6f, 84.4f, 84.8f, 84.9f,
+  84.6f, 84.6f, 84.3f, 84.3f, 84.4f, 84.4f, NAN, 84.3f, 84.2f, 84.7f, 84.5f, 84.2f,
+  84.4f, 84.1f, 84.4f, 84.6f, 84.6f, 84.4f, 84.2f, 84.2f, 84.1f, 84.4f, 84.3f, 84.4f,
+  84.1f, 84.0f, 84.4f, 84.4f, 84.3f, 84.3f, 84.3f, 84.2f, 83.9f, 84.1f, 83.9f, 83.7f,
+};
+
+#define SOIL_TRACE_REJECTS  7 // 3 probe spikes, 3 samples of the watering step, 1 failed read
+
+struct BenchResult {
+  char name[32];
+  double ns;
+  double allocs;
+  double bytes;
+};
+
+static char payload[API_PAYLOAD_SIZE];
+
+static size_t benchTelemetry() {
+  TelemetryPayload data = { 27.43f, 86.71f, 62.05f, 1234.567f, 0.0f, 0.0f, "2025-10-11T20:23:16.000Z",
+                            -61, 142336, 98304, 65536, 4108288, 1124 };
+  return ApiPayload::buildTelemetry(&data, payload, sizeof(payload));
+}
+
+static size_t benchTelemetryMsgPack() {
+  static uint8_t packet[TELEMETRY_BINARY_SIZE];
+  TelemetryPayload data = { 27.43f, 86.71f, 62.05f, 1234.567f, 0.0f, 0.0f, NULL,
+                            -61, 142336, 98304, 65536, 4108288, 1124, 1760214196 };
+  return ApiPayload::buildTelemetryMsgPack(&data, packet, sizeof(packet));
+}
+
+static size_t benchRelayTrigger() {
+  return ApiPayload::buildRelayTrigger(true, "sensor", "sensor", -1, 31.4f, 30.0f,
+                                       "temperature 31.4 > 30.0", payload, sizeof(payload));
+}
+
+static size_t benchStatus() {
+  return ApiPayload::buildStatus(2, true, "timer", true, false, "timer", payload, sizeof(payload));
+}
+
+static size_t benchLogEvent() {
+  return ApiPayload::buildLogEvent(1, "relay_change", "timer", false, true, 0, 0.0f,
+                                   "Timer 0 ON 07:00-19:00", payload, sizeof(payload));
+}
+
+static size_t benchSwitchStates() {
+  int states[4];
+  uint32_t versions[4];
+  return ApiPayload::parseSwitchStates(SWITCH_LIST_JSON, sizeof(SWITCH_LIST_JSON) - 1, states, versions, 4);
+}
+
+static size_t benchSwitchState() {
+  int state;
+  return ApiPayload::parseSwitchState(SWITCH_ONE_JSON, sizeof(SWITCH_ONE_JSON) - 1, &state);
+}
+
+static size_t benchAutomationSync() {
+  static AutomationTimer timers[12];
+  static AutomationSensor sensors[16];
+  AutomationSyncData data;
+  data.timers = timers;
+  data.max_timers = 12;
+  data.sensors = sensors;
+  data.max_sensors = 16;
+  return ApiPayload::parseAutomationSync(SYNC_JSON, sizeof(SYNC_JSON) - 1, &data) ? data.timer_count : 0;
+}
+
+static size_t benchSoilTrace() {
+  static const SensorFilterConfig config = SENSOR_FILTER_SOIL;
+  static SensorFilter filter;
+  filter.setup(config);
+  size_t accepted = 0;
+  float value;
+  for (size_t i = 0; i < sizeof(SOIL_TRACE) / sizeof(SOIL_TRACE[0]); i++) {
+    if (filter.update(SOIL_TRACE[i], i * SENSOR_SAMPLE_INTERVAL, &value)) {
+      accepted++;
+    }
+  }
+  return (filter.getRejectCount() == SOIL_TRACE_REJECTS) ? accepted : 0;
+}
+
+static const struct {
+  const char *name;
+  size_t (*run)(); // Payload length / parse ok, 0 = the case is broken
+} benchCases[] = {
+  { "build.telemetry", benchTelemetry },        // ApiClient::buildDotNetPayload
+  { "build.telemetry_msgpack", benchTelemetryMsgPack }, // ApiClient::buildTelemetryBinary
+  { "build.relay_trigger", benchRelayTrigger }, // AutomationApiClient::triggerRelay
+  { "build.status", benchStatus },              // AutomationApiClient::updateStatus
+  { "build.log_event", benchLogEvent },         // AutomationApiClient::logEvent
+  { "parse.switch_states", benchSwitchStates }, // SwitchApiClient::getAllSwitchStates
+  { "parse.switch_state", benchSwitchState },   // SwitchApiClient::getSwitchState
+  { "parse.automation_sync", benchAutomationSync }, // AutomationApiClient::syncFromAPI
+  { "filter.soil_trace", benchSoilTrace },      // SensorRegistry, one sample of every soil driver
+};
+
+static bool measure(size_t (*run)(), uint32_t iterations, BenchResult *result) {
+  for (uint32_t i = 0; i < BENCH_WARMUP_ITERATIONS; i++) {
+    if (!run()) {
+      return false;
+    }
+  }
+
+  NativeAllocStats before, after;
+  NativeHal_allocStats(&before);
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; i++) {
+    run();
+  }
+  auto end = std::chrono::steady_clock::now();
+  NativeHal_allocStats(&after);
+
+  result->ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+  result->allocs = (double) (after.count - before.count) / iterations;
+  result->bytes = (double) (after.bytes - before.bytes) / iterations;
+  return true;
+}
+
+static int loadBaseline(const char *path, BenchResult *baseline, int max) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    return -1;
+  }
+  char line[128];
+  int count = 0;
+  while (count < max && fgets(line, sizeof(line), file)) {
+    BenchResult *b = &baseline[count];
+    if (sscanf(line, "%31[^,],%lf,%lf,%lf", b->name, &b->ns, &b->allocs, &b->bytes) == 4) { // Header line fail here
+      count++;
+    }
+  }
+  fclose(file);
+  return count;
+}
+
+static bool checkBaseline(const BenchResult *result, const BenchResult *baseline, int baselineCount, int tolerance) {
+  for (int i = 0; i < baselineCount; i++) {
+    const BenchResult *b = &baseline[i];
+    if (strcmp(b->name, result->name) != 0) {
+      continue;
+    }
+    if (b->ns <= 0) {
+      fprintf(stderr, "NOT MEASURED %s: baseline has 0 ns/op, regenerate it from a native build\n", result->name);
+      return false;
+    }
+    bool ok = true;
+    if (result->allocs > b->allocs) {
+      fprintf(stderr, "REGRESSION %s: %.2f allocs/op, baseline %.2f\n", result->name, result->allocs, b->allocs);
+      ok = false;
+    }
+    if (result->bytes > b->bytes) {
+      fprintf(stderr, "REGRESSION %s: %.0f bytes/op, baseline %.0f\n", result->name, result->bytes, b->bytes);
+      ok = false;
+    }
+    if (result->ns > b->ns * (100 + tolerance) / 100) {
+      fprintf(stderr, "REGRESSION %s: %.0f ns/op, baseline %.0f (+%d %% allowed)\n", result->name, result->ns, b->ns, tolerance);
+      ok = false;
+    }
+    return ok;
+  }
+  fprintf(stderr, "No baseline for %s, regenerate it from a native build\n", result->name);
+  return false;
+}
+
+int NativeBench_run(int argc, char **argv) {
+  uint32_t iterations = (argc > 0) ? atoi(argv[0]) : BENCH_DEFAULT_ITERATIONS;
+  if (iterations == 0) {
+    iterations = BENCH_DEFAULT_ITERATIONS;
+  }
+
+  BenchResult baseline[BENCH_MAX_CASES];
+  int baselineCount = 0;
+  int tolerance = (argc > 2) ? atoi(argv[2]) : BENCH_DEFAULT_TOLERANCE;
+  if (argc > 1) {
+    baselineCount = loadBaseline(argv[1], baseline, BENCH_MAX_CASES);
+    if (baselineCount <= 0) {
+      fprintf(stderr, "Can not read baseline \"%s\" (no measured rows)\n", argv[1]);
+      return 1;
+    }
+  }
+
+  NativeAllocStats stats;
+  if (!NativeHal_allocStats(&stats)) {
+    fprintf(stderr, "Allocation count not supported by this libc, reported as 0\n");
+  }
+
+  bool ok = true;
+  printf("name,ns_per_op,allocs_per_op,bytes_per_op\n");
+  for (size_t i = 0; i < sizeof(benchCases) / sizeof(benchCases[0]); i++) {
+    BenchResult result;
+    snprintf(result.name, sizeof(result.name), "%s", benchCases[i].name);
+    if (!measure(benchCases[i].run, iterations, &result)) {
+      fprintf(stderr, "FAIL %s: payload does not fit / fixture does not parse\n", result.name);
+      ok = false;
+      continue;
+    }
+    printf("%s,%.0f,%.2f,%.0f\n", result.name, result.ns, result.allocs, result.bytes);
+    if (argc > 1 && !checkBaseline(&result, baseline, baselineCount, tolerance)) {
+      ok = false;
+    }
+  }
+  return ok ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+
+// ===================================================================
+// Host micro-benchmark of the ApiPayload builders / parsers and of
+// SensorFilter replaying a soil trace (one op = the whole trace), [env:native]
+//
+//   .pio/build/native/program bench [iterations] [baseline.csv [tolerance %]]
+//
+// stdout is CSV (name,ns_per_op,allocs_per_op,bytes_per_op), the same
+// format as the baseline. ns/op is machine dependent, so no baseline is
+// kept in the repo: measure the commit before the change, then check
+// the change against it on the same machine
+//   program bench 20000 > bench_base.csv      (before)
+//   program bench 20000 bench_base.csv        (after)
+// With a baseline, exit 1 if a case make more allocations / bytes than
+// it, or is slower by more than tolerance (default 25 %). A case
+// missing from the baseline or with 0 ns/op (never measured) also
+// fail, rows are only taken from a real run, not written by hand.
+// ===================================================================
+
+int NativeBench_run(int argc, char **argv);
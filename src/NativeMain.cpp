@@ -0,0 +1,134 @@
+// ===================================================================
+// Native (host) entry point, [env:native] only
+// Run the hardware independent core (sensor registry + filter, timer
+// schedule) against mock sensors on a simulated clock and print one
+// CSV line per minute, so a change can be checked without hardware.
+//
+//   .pio/build/native/program [hours] [timer ...]
+//   timer = relay,HH:MM,HH:MM[,days]   days = 7 x 0/1 from Monday
+//   e.g. program 24 0,06:00,18:00 1,08:00,08:30,1111100
+//
+//   .pio/build/native/program bench ...   see NativeBench.h
+//   .pio/build/native/program net ...     see NativeNetHarness.h
+//   .pio/build/native/program replay ...  see NativeReplay.h
+// Left out of pio test, test/test_native has its own main.
+// ===================================================================
+#if !defined(ARDUINO) && !defined(PIO_UNIT_TESTING)
+
+#include <Arduino.h>
+#include "SensorRegistry.h"
+#include "MockSensorDriver.h"
+#include "AutomationSchedule.h"
+#include "NativeBench.h"
+#include "NativeNetHarness.h"
+#include "NativeReplay.h"
+
+#define NATIVE_MAX_TIMERS 12
+
+static float mockClimate(SensorChannel ch, uint32_t index, void *) { // 1 sample / sec, daily sine
+  float phase = (index % 86400) * (2.0f * (float) M_PI / 86400.0f);
+  switch (ch) {
+    case SENSOR_TEMP: return 27.0f - 5.0f * cosf(phase);
+    case SENSOR_HUMI: return 75.0f + 15.0f * cosf(phase);
+    default: return NAN;
+  }
+}
+
+static float mockSoil(SensorChannel, uint32_t index, void *) { // Dry out, watered every 6 h
+  return 80.0f - (index % 21600) * (40.0f / 21600.0f);
+}
+
+static float mockLight(SensorChannel, uint32_t index, void *) {
+  uint32_t second = index % 86400;
+  if (second < 6 * 3600 || second >= 18 * 3600) {
+    return 0.0f;
+  }
+  return 40000.0f * sinf((second - 6 * 3600) * ((float) M_PI / (12 * 3600)));
+}
+
+static bool parseTimer(const char *text, AutomationTimer *timer) {
+  int relay;
+  char on[8], off[8], days[8] = "1111111";
+  if (sscanf(text, "%d,%7[0-9:],%7[0-9:],%7[01]", &relay, on, off, days) < 3 || relay < 0 || relay > 3) {
+    return false;
+  }
+  memset(timer, 0, sizeof(AutomationTimer));
+  timer->relay_id = relay;
+  timer->enabled = true;
+  timer->time_on = AutomationSchedule::timeStringToMinutes(on);
+  timer->time_off = AutomationSchedule::timeStringToMinutes(off);
+  for (int d = 0; d < 7; d++) {
+    timer->days[d] = days[d] == '1';
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+    return NativeBench_run(argc - 2, argv + 2);
+  }
+  if (argc > 1 && strcmp(argv[1], "net") == 0) {
+    return NativeNetHarness_run(argc - 2, argv + 2);
+  }
+  if (argc > 1 && strcmp(argv[1], "replay") == 0) {
+    return NativeReplay_run(argc - 2, argv + 2);
+  }
+
+  uint32_t hours = (argc > 1) ? atoi(argv[1]) : 24;
+
+  AutomationTimer timers[NATIVE_MAX_TIMERS];
+  int timerCount = 0;
+  for (int i = 2; i < argc && timerCount < NATIVE_MAX_TIMERS; i++) {
+    if (parseTimer(argv[i], &timers[timerCount])) {
+      timerCount++;
+    } else {
+      fprintf(stderr, "Bad timer \"%s\", use relay,HH:MM,HH:MM[,days]\n", argv[i]);
+      return 1;
+    }
+  }
+
+  MockSensorDriver climate("MockSHT", SENSOR_CH_MASK(SENSOR_TEMP) | SENSOR_CH_MASK(SENSOR_HUMI), 10, mockClimate);
+  MockSensorDriver soil("MockSoil", SENSOR_CH_MASK(SENSOR_SOIL), 0, mockSoil);
+  MockSensorDriver light("MockBH1750", SENSOR_CH_MASK(SENSOR_LIGHT), 0, mockLight);
+  SensorRegistry::add(&climate);
+  SensorRegistry::add(&soil);
+  SensorRegistry::add(&light);
+
+  printf("minute,day,temp,humi,soil,light_lux,relay0,relay1,relay2,relay3,next_edge\n");
+  uint32_t end = hours * 3600UL * 1000UL;
+  uint32_t nextPrint = 0;
+  while (millis() < end) {
+    uint32_t wait = SensorRegistry::process(millis());
+    NativeHal_advance(wait > 0 ? wait : 1);
+
+    if (millis() < nextPrint) {
+      continue;
+    }
+    nextPrint += 60000;
+
+    uint32_t minute = millis() / 60000;
+    int minuteOfDay = minute % 1440;
+    int day = (minute / 1440) % 7; // Simulation start on Monday 00:00
+    bool relay[4] = { false, false, false, false };
+    for (int t = 0; t < timerCount; t++) {
+      if (AutomationSchedule::isTimerActive(&timers[t], minuteOfDay, day)) {
+        relay[timers[t].relay_id] = true;
+      }
+    }
+
+    printf("%lu,%d", (unsigned long) minute, day);
+    for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+      SensorSample sample;
+      if (SensorRegistry::getSample((SensorChannel) ch, &sample, millis())) {
+        printf(",%.2f", sample.value);
+      } else {
+        printf(",");
+      }
+    }
+    printf(",%d,%d,%d,%d,%d\n", relay[0], relay[1], relay[2], relay[3],
+           AutomationSchedule::getMinutesToNextEdge(timers, timerCount, minuteOfDay, day));
+  }
+  return 0;
+}
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef ARDUINO
+
+#include <Arduino.h>
+#include <signal.h>
+#include "NativeNetHarness.h"
+#include "ApiClient.h"
+#include "SwitchApiClient.h"
+#include "AutomationApiClient.h"
+#include "HttpTransport.h"
+#include "SwitchSync.h"
+
+// Same pace as HandySense_loop
+#define NET_TELEMETRY_INTERVAL  10000                       // eventInterval_publishData
+#define NET_SWITCH_INTERVAL     5000                        // HandySense.h SWITCH_POLL_INTERVAL
+#define NET_SYNC_INTERVAL       AUTOMATION_SYNC_INTERVAL
+#define NET_REPORT_INTERVAL     30000
+
+static const char *TAG = "NetHarness";
+
+static volatile bool stopRequested = false;
+static String baseUrl;
+static SwitchSyncState switchSync[4];
+static uint32_t switchChanges = 0;
+
+static void onSignal(int) {
+  stopRequested = true;
+}
+
+static void onIntervalHint(HttpEndpoint endpoint, uint32_t seconds) { // Firmware: PollIntervals::hint
+  ESP_LOGI(TAG, "X-Poll-Interval %s: %lu s", HttpTransport::endpointName(endpoint), (unsigned long) seconds);
+}
+
+static int apiRequest(const char *method, const char *endpoint, const char *payload, String *response) {
+  return HttpTransport::request(method, baseUrl + endpoint, DOTNET_API_KEY, payload, response, DOTNET_API_TIMEOUT);
+}
+
+static void sendTelemetry() {
+  TelemetryPayload data = { 27.4f, 86.7f, 62.0f, 1234.5f, 0.0f, 0.0f, "2025-10-11T20:23:16.000Z", -55, 0, 0, 0, 0, 0 };
+  char payload[API_PAYLOAD_SIZE];
+  ApiPayload::buildTelemetry(&data, payload, sizeof(payload));
+  int code = apiRequest("POST", ENDPOINT_TELEMETRY, payload, NULL);
+  if (code < 200 || code >= 300) {
+    ESP_LOGW(TAG, "Telemetry -> %d %s", code, HTTPClient::errorToString(code).c_str());
+  }
+}
+
+static void onSwitchChanged(int relayId, int state) { // What setRelayState queue to ApiWorker for API_SYNC
+  char payload[API_PAYLOAD_SIZE];
+  ApiPayload::buildLogEvent(relayId, state ? "turn_on" : "turn_off", "API_SYNC", !state, state, -1, 0.0f, NULL,
+                            payload, sizeof(payload));
+  apiRequest("POST", ENDPOINT_AUTOMATION_LOGS, payload, NULL);
+}
+
+static void sendSwitch(int relayId) { // ApiWorker PUT + ack
+  char payload[API_PAYLOAD_SIZE];
+  char endpoint[32];
+  snprintf(endpoint, sizeof(endpoint), "%s/%d", SWITCH_API_ENDPOINT, relayId + 1);
+  ApiPayload::buildSwitchState(relayId + 1, switchSync[relayId].state, switchSync[relayId].version, "DEVICE_SYNC",
+                               payload, sizeof(payload));
+  int code = apiRequest("PUT", endpoint, payload, NULL);
+  if (code != 200) {
+    ESP_LOGW(TAG, "Switch %d v%lu -> %d", relayId + 1, (unsigned long) switchSync[relayId].version, code);
+  }
+  SwitchSync::ack(&switchSync[relayId], switchSync[relayId].version);
+}
+
+static void pollSwitches() {
+  String response;
+  int code = apiRequest("GET", SWITCH_API_ENDPOINT, NULL, &response);
+  int states[4];
+  uint32_t versions[4];
+  if (code != 200 || !ApiPayload::parseSwitchStates(response.c_str(), response.length(), states, versions, 4)) {
+    ESP_LOGW(TAG, "Switch poll -> %d %s", code, HTTPClient::errorToString(code).c_str());
+    return;
+  }
+
+  for (int i = 0; i < 4; i++) {
+    SwitchSyncAction action = SwitchSync::remote(&switchSync[i], states[i], versions[i]);
+    if (action == SWITCH_SYNC_APPLY) {
+      ESP_LOGI(TAG, "Switch %d changed: %s (v%lu)", i + 1, states[i] ? "ON" : "OFF", (unsigned long) versions[i]);
+      switchChanges++;
+      onSwitchChanged(i, states[i]);
+    } else if (action == SWITCH_SYNC_SEND) {
+      sendSwitch(i);
+    } else if (action == SWITCH_SYNC_STALE) {
+      ESP_LOGD(TAG, "Switch %d: stale v%lu", i + 1, (unsigned long) versions[i]);
+    }
+  }
+}
+
+static void syncAutomation() {
+  static AutomationTimer timers[12];
+  static AutomationSensor sensors[16];
+  char endpoint[64];
+  snprintf(endpoint, sizeof(endpoint), "%s?userId=%s", ENDPOINT_AUTOMATION_SYNC, USER_ID);
+
+  String response;
+  int code = apiRequest("GET", endpoint, NULL, &response);
+  AutomationSyncData data;
+  data.timers = timers;
+  data.max_timers = 12;
+  data.sensors = sensors;
+  data.max_sensors = 16;
+  if (code != 200 || !ApiPayload::parseAutomationSync(response.c_str(), response.length(), &data)) {
+    ESP_LOGW(TAG, "Automation sync -> %d %s", code, HTTPClient::errorToString(code).c_str());
+    return;
+  }
+  ESP_LOGD(TAG, "Sync %s: %d timers, %d sensors", data.sync_token, data.timer_count, data.sensor_count);
+}
+
+static void report(uint32_t elapsed) {
+  Serial.printf("\n--- %lu s, %lu switch changes ---\n", (unsigned long) (elapsed / 1000), (unsigned long) switchChanges);
+  HttpTransport::print();
+  for (int ep = 0; ep < HTTP_EP_COUNT; ep++) {
+    HttpEndpointStats stats;
+    if (HttpTransport::getStats((HttpEndpoint) ep, &stats)) {
+      uint32_t total = stats.success + stats.fail + stats.timeout;
+      Serial.printf("%-16s %.1f req/min\n", HttpTransport::endpointName((HttpEndpoint) ep),
+                    total * 60000.0 / (elapsed ? elapsed : 1));
+    }
+  }
+  fflush(stdout);
+}
+
+int NativeNetHarness_run(int argc, char **argv) {
+  baseUrl = (argc > 0) ? argv[0] : "http://127.0.0.1:8080/minapi/v1";
+  uint32_t duration = ((argc > 1) ? atoi(argv[1]) : 60) * 1000UL;
+
+  NativeHal_useRealTime();
+  signal(SIGINT, onSignal);
+  HttpTransport::onIntervalHint(onIntervalHint);
+  ESP_LOGI(TAG, "Against %s for %lu s, Ctrl-C to stop early", baseUrl.c_str(), (unsigned long) (duration / 1000));
+
+  uint32_t lastSwitch = 0, lastTelemetry = 0, lastSync = 0, lastReport = 0;
+  bool first = true;
+  while (!stopRequested && millis() < duration) {
+    uint32_t now = millis();
+    if (first || now - lastSwitch >= NET_SWITCH_INTERVAL) {
+      lastSwitch = now;
+      pollSwitches();
+    }
+    if (first || now - lastTelemetry >= NET_TELEMETRY_INTERVAL) {
+      lastTelemetry = now;
+      sendTelemetry();
+    }
+    if (first || now - lastSync >= NET_SYNC_INTERVAL) {
+      lastSync = now;
+      syncAutomation();
+    }
+    if (now - lastReport >= NET_REPORT_INTERVAL) {
+      lastReport = now;
+      if (!first) {
+        report(now);
+      }
+    }
+    first = false;
+    delay(10);
+  }
+
+  report(millis());
+  return 0;
+}
+
+#endif
@@ -0,0 +1,15 @@
+#pragma once
+
+// ===================================================================
+// Host network harness, [env:native]
+// Replay the firmware request pattern (switch poll, telemetry,
+// automation sync, log + switch PUT on a switch change) in real time
+// through HttpTransport and ApiPayload, against tools/mock_api_server.py
+// or any server, then print the per endpoint HttpTransport table and
+// request rates. Faults and command latency are on the mock side.
+//
+//   .pio/build/native/program net [base_url] [seconds]
+//   base_url default http://127.0.0.1:8080/minapi/v1, seconds default 60
+// ===================================================================
+
+int NativeNetHarness_run(int argc, char **argv);
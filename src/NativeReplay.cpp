@@ -0,0 +1,419 @@
+#ifndef ARDUINO
+
+#include <Arduino.h>
+#include <chrono>
+#include <vector>
+#include "NativeReplay.h"
+#include "AutomationEngine.h"
+#include "AutomationApiClient.h"
+
+#define REPLAY_RELAYS           4
+#define REPLAY_MAX_TIMERS       12   // AutomationApiClient local_timers
+#define REPLAY_MAX_SENSORS      16   // AutomationApiClient local_sensors
+#define REPLAY_MAX_OVERRIDES    16
+#define REPLAY_SENSOR_PERIOD    1    // s, eventInterval
+#define REPLAY_LIGHT_PERIOD     6    // s, eventInterval_brightness
+#define REPLAY_TIMER_PERIOD     (TIMER_CHECK_INTERVAL / 1000)
+#define REPLAY_CHECK_PERIOD     (SENSOR_CHECK_INTERVAL / 1000)
+#define REPLAY_SHORT_CYCLE      60   // s, on periods shorter than this are counted
+
+struct ReplayOverride {
+  int relay;
+  int minute;   // Of the day
+  int duration; // Minutes
+  bool on;
+  int day;      // -1 = every day
+};
+
+struct ReplayTrace {
+  std::vector<uint32_t> seconds;
+  std::vector<float> values[AUTOMATION_IN_COUNT];
+  uint32_t period;
+  size_t index;
+};
+
+struct ReplayRelay {
+  bool on;
+  uint32_t overrideUntil;
+  int64_t pendingSince;  // -1 = inputs agree with the relay
+  uint32_t onSince;
+  uint32_t transitions;
+  uint32_t commands;
+  uint32_t onSeconds;
+  uint32_t shortCycles;
+  uint32_t minOn;
+  uint32_t latencyCount;
+  uint64_t latencyTotal;
+  uint32_t latencyMax;
+};
+
+static AutomationTimer timers[REPLAY_MAX_TIMERS];
+static int timerCount = 0;
+static AutomationSensor sensors[REPLAY_MAX_SENSORS];
+static int sensorCount = 0;
+static ReplayOverride overrides[REPLAY_MAX_OVERRIDES];
+static int overrideCount = 0;
+static ReplayTrace trace;
+static bool useTrace = false;
+static float noise = 0.0f;
+static uint32_t noiseState = 2463534242u;
+
+static AutomationRelayRules rules[REPLAY_RELAYS];
+static ReplayRelay relays[REPLAY_RELAYS];
+
+// ---------------- Scenario ----------------
+static bool parseTimer(const char *text, AutomationTimer *timer) {
+  int relay;
+  char on[8], off[8], days[8] = "1111111";
+  if (sscanf(text, "%d,%7[0-9:],%7[0-9:],%7[01]", &relay, on, off, days) < 3 || relay < 0 || relay >= REPLAY_RELAYS) {
+    return false;
+  }
+  memset(timer, 0, sizeof(AutomationTimer));
+  timer->relay_id = relay;
+  timer->enabled = true;
+  timer->time_on = AutomationSchedule::timeStringToMinutes(on);
+  timer->time_off = AutomationSchedule::timeStringToMinutes(off);
+  for (int d = 0; d < 7; d++) {
+    timer->days[d] = days[d] == '1';
+  }
+  return true;
+}
+
+static bool parseSensor(const char *text, AutomationSensor *sensor) {
+  int relay;
+  memset(sensor, 0, sizeof(AutomationSensor));
+  if (sscanf(text, "%d,%19[a-z_],%19[a-z_],%f,%f,%f,%9[a-z_]", &relay, sensor->sensor_type, sensor->control_mode,
+             &sensor->min_value, &sensor->max_value, &sensor->hysteresis, sensor->action) < 6 ||
+      relay < 0 || relay >= REPLAY_RELAYS) {
+    return false;
+  }
+  sensor->relay_id = relay;
+  sensor->enabled = true;
+  return true;
+}
+
+static bool parseOverride(const char *text, ReplayOverride *event) {
+  char state[4];
+  char at[8];
+  event->day = -1;
+  if (sscanf(text, "%d,%7[0-9:],%d,%3[onf],%d", &event->relay, at, &event->duration, state, &event->day) < 4 ||
+      event->relay < 0 || event->relay >= REPLAY_RELAYS) {
+    return false;
+  }
+  event->minute = AutomationSchedule::timeStringToMinutes(at);
+  event->on = strcmp(state, "on") == 0;
+  return true;
+}
+
+static int traceColumn(const char *name, float *scale) {
+  *scale = 1.0f;
+  if (strcmp(name, "temp") == 0 || strcmp(name, "temperature") == 0) return AUTOMATION_IN_TEMPERATURE;
+  if (strcmp(name, "humi") == 0 || strcmp(name, "humidity") == 0) return AUTOMATION_IN_HUMIDITY;
+  if (strcmp(name, "soil") == 0 || strcmp(name, "soil_moisture") == 0) return AUTOMATION_IN_SOIL;
+  if (strcmp(name, "light") == 0) return AUTOMATION_IN_LIGHT;
+  if (strcmp(name, "light_lux") == 0) {
+    *scale = 0.001f; // Firmware compare kLux (lux_44009)
+    return AUTOMATION_IN_LIGHT;
+  }
+  return -1;
+}
+
+static bool loadTrace(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "Can't open %s\n", path);
+    return false;
+  }
+
+  char line[512];
+  int columns[16];
+  float scales[16];
+  int columnCount = 0;
+  int timeColumn = -1;
+  uint32_t timeScale = 1;
+  if (fgets(line, sizeof(line), f)) {
+    for (char *name = strtok(line, ",\r\n"); name && columnCount < 16; name = strtok(NULL, ",\r\n"), columnCount++) {
+      columns[columnCount] = traceColumn(name, &scales[columnCount]);
+      if (strcmp(name, "seconds") == 0 || strcmp(name, "minute") == 0) {
+        timeColumn = columnCount;
+        timeScale = (name[0] == 'm') ? 60 : 1;
+      }
+    }
+  }
+  if (timeColumn < 0) {
+    fprintf(stderr, "%s: header need a seconds or minute column\n", path);
+    fclose(f);
+    return false;
+  }
+
+  while (fgets(line, sizeof(line), f)) {
+    float row[AUTOMATION_IN_COUNT] = { NAN, NAN, NAN, NAN };
+    uint32_t seconds = 0;
+    char *p = line;
+    for (int c = 0; c < columnCount && p; c++) {
+      char *end = strpbrk(p, ",\r\n");
+      if (c == timeColumn) {
+        seconds = strtoul(p, NULL, 10) * timeScale;
+      } else if (columns[c] >= 0 && end != p) {
+        row[columns[c]] = strtof(p, NULL) * scales[c];
+      }
+      p = (end && *end == ',') ? end + 1 : NULL;
+    }
+    trace.seconds.push_back(seconds);
+    for (int in = 0; in < AUTOMATION_IN_COUNT; in++) {
+      trace.values[in].push_back(row[in]);
+    }
+  }
+  fclose(f);
+
+  size_t rows = trace.seconds.size();
+  if (rows < 2) {
+    fprintf(stderr, "%s: need 2 rows or more\n", path);
+    return false;
+  }
+  trace.period = trace.seconds[rows - 1] + (trace.seconds[rows - 1] - trace.seconds[rows - 2]);
+  trace.index = 0;
+  return true;
+}
+
+static bool loadScenario(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "Can't open %s\n", path);
+    return false;
+  }
+
+  char line[256];
+  int lineNumber = 0;
+  bool ok = true;
+  while (ok && fgets(line, sizeof(line), f)) {
+    lineNumber++;
+    char keyword[16];
+    char args[224] = "";
+    if (line[0] == '#' || sscanf(line, "%15s %223[^\r\n]", keyword, args) < 1) {
+      continue;
+    }
+
+    if (strcmp(keyword, "timer") == 0 && timerCount < REPLAY_MAX_TIMERS) {
+      ok = parseTimer(args, &timers[timerCount]);
+      timers[timerCount].timer_id = 0;
+      for (int t = 0; t < timerCount; t++) { // Next free timer_id of the relay
+        timers[timerCount].timer_id += (timers[t].relay_id == timers[timerCount].relay_id);
+      }
+      timerCount++;
+    } else if (strcmp(keyword, "sensor") == 0 && sensorCount < REPLAY_MAX_SENSORS) {
+      ok = parseSensor(args, &sensors[sensorCount++]);
+    } else if (strcmp(keyword, "override") == 0 && overrideCount < REPLAY_MAX_OVERRIDES) {
+      ok = parseOverride(args, &overrides[overrideCount++]);
+    } else if (strcmp(keyword, "trace") == 0) {
+      ok = useTrace = loadTrace(args);
+    } else if (strcmp(keyword, "synthetic") == 0) {
+      noise = atof(args);
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      fprintf(stderr, "%s:%d: bad or too many \"%s\"\n", path, lineNumber, keyword);
+    }
+  }
+  fclose(f);
+  return ok;
+}
+
+// ---------------- Inputs ----------------
+static float noiseSample() { // xorshift32, -1 .. 1
+  noiseState ^= noiseState << 13;
+  noiseState ^= noiseState >> 17;
+  noiseState ^= noiseState << 5;
+  return (noiseState / 2147483648.0f) - 1.0f;
+}
+
+static float syntheticInput(int input, uint32_t second) { // Same curves as the plain native run
+  uint32_t ofDay = second % 86400;
+  float phase = ofDay * (2.0f * (float) M_PI / 86400.0f);
+  float value;
+  switch (input) {
+    case AUTOMATION_IN_TEMPERATURE: value = 27.0f - 5.0f * cosf(phase); break;
+    case AUTOMATION_IN_HUMIDITY: value = 75.0f + 15.0f * cosf(phase); break;
+    case AUTOMATION_IN_SOIL: value = 80.0f - (second % 21600) * (40.0f / 21600.0f); break;
+    default:
+      value = (ofDay < 6 * 3600 || ofDay >= 18 * 3600) ? 0.0f : 40.0f * sinf((ofDay - 6 * 3600) * ((float) M_PI / (12 * 3600)));
+      break;
+  }
+  return (noise > 0.0f) ? value + noise * noiseSample() : value;
+}
+
+static void readInputs(uint32_t second, float *inputs) {
+  if (!useTrace) {
+    for (int in = 0; in < AUTOMATION_IN_COUNT; in++) {
+      inputs[in] = syntheticInput(in, second);
+    }
+    return;
+  }
+
+  uint32_t at = second % trace.period; // Sample and hold, time only move forward
+  if (at < trace.seconds[trace.index]) {
+    trace.index = 0;
+  }
+  while (trace.index + 1 < trace.seconds.size() && trace.seconds[trace.index + 1] <= at) {
+    trace.index++;
+  }
+  for (int in = 0; in < AUTOMATION_IN_COUNT; in++) {
+    float value = trace.values[in][trace.index];
+    if (!isnan(value)) { // Empty cell, keep the last reading like the firmware
+      inputs[in] = value;
+    }
+  }
+}
+
+// ---------------- Relays ----------------
+static void setRelay(int r, bool on, uint32_t now, bool automation) {
+  ReplayRelay &relay = relays[r];
+  if (automation) {
+    relay.commands++;
+  }
+  if (relay.on == on) {
+    return;
+  }
+
+  relay.transitions++;
+  if (relay.on) {
+    uint32_t period = now - relay.onSince;
+    relay.onSeconds += period;
+    relay.shortCycles += (period < REPLAY_SHORT_CYCLE);
+    if (period < relay.minOn) {
+      relay.minOn = period;
+    }
+  } else {
+    relay.onSince = now;
+  }
+  relay.on = on;
+
+  if (automation && relay.pendingSince >= 0) {
+    uint32_t latency = now - (uint32_t) relay.pendingSince;
+    relay.latencyCount++;
+    relay.latencyTotal += latency;
+    if (latency > relay.latencyMax) {
+      relay.latencyMax = latency;
+    }
+  }
+  relay.pendingSince = -1;
+}
+
+static void apply(int r, AutomationDecision decision, uint32_t now) {
+  if (decision != AUTOMATION_NONE) {
+    setRelay(r, decision == AUTOMATION_TURN_ON, now, true);
+  }
+}
+
+// What checkAndTriggerTimers + checkAndTriggerSensors would leave the relay at right now
+static bool wantedState(int r, bool on, const float *inputs, int minutes, int day, uint32_t now) {
+  if (now >= relays[r].overrideUntil) {
+    AutomationDecision decision = AutomationEngine::decideTimers(&rules[r], minutes, day);
+    if (decision != AUTOMATION_NONE) {
+      on = (decision == AUTOMATION_TURN_ON);
+    }
+  }
+  if (AutomationEngine::isTimerActive(&rules[r], minutes, day)) {
+    return on;
+  }
+  for (int in = 0; in < AUTOMATION_IN_COUNT; in++) {
+    if (rules[r].sensors[in]) {
+      AutomationDecision decision = AutomationEngine::decideSensor(rules[r].sensors[in], inputs[in]);
+      if (decision != AUTOMATION_NONE) {
+        on = (decision == AUTOMATION_TURN_ON);
+      }
+    }
+  }
+  return on;
+}
+
+int NativeReplay_run(int argc, char **argv) {
+  if (argc < 1) {
+    fprintf(stderr, "Use: replay <scenario> [days], see NativeReplay.h\n");
+    return 1;
+  }
+  if (!loadScenario(argv[0])) {
+    return 1;
+  }
+  uint32_t days = (argc > 1) ? atoi(argv[1]) : 30;
+  uint32_t end = days * 86400UL;
+
+  for (int r = 0; r < REPLAY_RELAYS; r++) {
+    AutomationEngine::resolve(r, timers, timerCount, sensors, sensorCount, &rules[r]);
+    relays[r].pendingSince = -1;
+    relays[r].minOn = UINT32_MAX;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  float sampled[AUTOMATION_IN_COUNT] = { NAN, NAN, NAN, NAN };  // What the firmware variables hold
+  float inputs[AUTOMATION_IN_COUNT] = { NAN, NAN, NAN, NAN };   // Trace right now
+  for (uint32_t now = 0; now < end; now++) { // Simulation start on Monday 00:00
+    int minutes = (now / 60) % 1440;
+    int day = (now / 86400) % 7;
+
+    readInputs(now, inputs);
+    if (now % REPLAY_SENSOR_PERIOD == 0) {
+      sampled[AUTOMATION_IN_TEMPERATURE] = inputs[AUTOMATION_IN_TEMPERATURE];
+      sampled[AUTOMATION_IN_HUMIDITY] = inputs[AUTOMATION_IN_HUMIDITY];
+      sampled[AUTOMATION_IN_SOIL] = inputs[AUTOMATION_IN_SOIL];
+    }
+    if (now % REPLAY_LIGHT_PERIOD == 0) {
+      sampled[AUTOMATION_IN_LIGHT] = inputs[AUTOMATION_IN_LIGHT];
+    }
+
+    for (int o = 0; o < overrideCount; o++) {
+      const ReplayOverride &event = overrides[o];
+      if (now % 60 == 0 && minutes == event.minute && (event.day < 0 || (uint32_t) event.day == now / 86400)) {
+        setRelay(event.relay, event.on, now, false); // Manual switch, setManualOverride
+        relays[event.relay].overrideUntil = now + event.duration * 60;
+      }
+    }
+
+    if (now % REPLAY_TIMER_PERIOD == 0) {
+      for (int r = 0; r < REPLAY_RELAYS; r++) {
+        if (now >= relays[r].overrideUntil) {
+          apply(r, AutomationEngine::decideTimers(&rules[r], minutes, day), now);
+        }
+      }
+    }
+    if (now % REPLAY_CHECK_PERIOD == 0) {
+      for (int r = 0; r < REPLAY_RELAYS; r++) {
+        if (AutomationEngine::isTimerActive(&rules[r], minutes, day)) {
+          continue;
+        }
+        for (int in = 0; in < AUTOMATION_IN_COUNT; in++) {
+          if (rules[r].sensors[in]) {
+            apply(r, AutomationEngine::decideSensor(rules[r].sensors[in], sampled[in]), now);
+          }
+        }
+      }
+    }
+
+    for (int r = 0; r < REPLAY_RELAYS; r++) {
+      bool wanted = wantedState(r, relays[r].on, inputs, minutes, day, now);
+      if (wanted == relays[r].on) {
+        relays[r].pendingSince = -1;
+      } else if (relays[r].pendingSince < 0) {
+        relays[r].pendingSince = now;
+      }
+    }
+  }
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("relay,transitions,per_day,duty_pct,commands_per_day,latency_avg_s,latency_max_s,short_cycles,min_on_s\n");
+  for (int r = 0; r < REPLAY_RELAYS; r++) {
+    ReplayRelay &relay = relays[r];
+    uint32_t onSeconds = relay.onSeconds + (relay.on ? end - relay.onSince : 0);
+    printf("%d,%lu,%.1f,%.1f,%.0f,%.1f,%lu,%lu,%ld\n", r, (unsigned long) relay.transitions,
+           (double) relay.transitions / (days ? days : 1), onSeconds * 100.0 / (end ? end : 1),
+           (double) relay.commands / (days ? days : 1),
+           relay.latencyCount ? (double) relay.latencyTotal / relay.latencyCount : 0.0, (unsigned long) relay.latencyMax,
+           (unsigned long) relay.shortCycles, relay.minOn == UINT32_MAX ? -1L : (long) relay.minOn);
+  }
+  fprintf(stderr, "%lu simulated days in %.2f s (%.0f days/min)\n", (unsigned long) days, wall,
+          wall > 0 ? days * 60.0 / wall : 0.0);
+  return 0;
+}
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+// ===================================================================
+// Automation replay, [env:native]
+// Feed a recorded or synthetic sensor trace through AutomationEngine
+// on a simulated clock, with the firmware pace (sensor read 1 s,
+// light 6 s, timer / sensor check TIMER_CHECK_INTERVAL /
+// SENSOR_CHECK_INTERVAL) and the same order (override, timers, then
+// temperature, soil, humidity, light), and report per relay:
+// transitions, duty cycle, relay commands (Open/Close calls, each one
+// is a switch PUT on the device), on periods under a minute and
+// decision latency = time from the inputs asking for a state to the
+// relay reaching it.
+//
+//   .pio/build/native/program replay <scenario> [days]   days default 30
+//
+// Scenario, one item per line, # comment:
+//   timer    relay,HH:MM,HH:MM[,days]                days = 7 x 0/1 from Monday
+//   sensor   relay,type,mode,min,max,hysteresis[,action]
+//            type temperature / soil_moisture / humidity / light (kLux)
+//            mode max_trigger / min_trigger / range, action "" = threshold
+//   override relay,HH:MM,minutes,on|off[,day]        manual switch, daily or on day N only
+//   trace    file.csv                                recorded, loop if shorter than days
+//   synthetic [noise]                                daily curves (default) +- noise
+// Trace CSV need a header: seconds or minute, then any of temperature
+// (temp), humidity (humi), soil_moisture (soil), light (kLux) or
+// light_lux, so `program 24 > day.csv` output can be replayed as is.
+// ===================================================================
+
+int NativeReplay_run(int argc, char **argv);
@@ -0,0 +1,263 @@
+// ===================================================================
+// Headless UI simulator, [env:ui_sim] only
+// Build the SquareLine UI (src/gui) with LVGL against an in-memory
+// framebuffer and a scripted touch panel, walk the dashboard and
+// config screens, and for each screen time full redraws and the
+// partial redraw UI_loop cause every call (clock + sensor labels).
+// Writes <out_dir>/<screen>.ppm and <out_dir>/frames.csv, compare
+// two runs with tools/ui_diff.py before shipping asset / font /
+// layout changes.
+//
+//   pio run -e ui_sim && .pio/build/ui_sim/program [out_dir] [frames]
+//   out_dir default ui_sim_out, frames default 50
+//   exit 1 = a scripted tap missed its button
+//
+// Times are host CPU, compare runs on the same machine only. LVGL
+// tick is simulated so animations and screenshots are deterministic.
+// ===================================================================
+#if !defined(ARDUINO) && defined(LV_SIM)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <sys/stat.h>
+#include <lvgl.h>
+#include "gui/ui.h"
+
+#define UI_SIM_WIDTH        480  // ATD3.5-S3 panel, Display.begin(0)
+#define UI_SIM_HEIGHT       320
+#define UI_SIM_BUF_LINES    40   // Partial draw buffer, like the device
+#define UI_SIM_FRAME_MS     LV_DISP_DEF_REFR_PERIOD
+#define UI_SIM_SETTLE_MS    1000 // Let tap / screen animations finish
+#define UI_SIM_MAX_FRAMES   1000
+
+static lv_color_t framebuffer[UI_SIM_WIDTH * UI_SIM_HEIGHT];
+static lv_color_t drawBuffer[UI_SIM_WIDTH * UI_SIM_BUF_LINES];
+static uint32_t flushedPixels = 0;
+
+static lv_point_t touchPoint = { 0, 0 };
+static bool touchPressed = false;
+
+static uint32_t frameTimes[UI_SIM_MAX_FRAMES];
+static int missedTaps = 0;
+
+static void flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color) {
+  int32_t width = lv_area_get_width(area);
+  for (int32_t y = area->y1; y <= area->y2; y++) {
+    memcpy(&framebuffer[y * UI_SIM_WIDTH + area->x1], color, width * sizeof(lv_color_t));
+    color += width;
+  }
+  flushedPixels += lv_area_get_size(area);
+  lv_disp_flush_ready(drv);
+}
+
+static void readTouch(lv_indev_drv_t *, lv_indev_data_t *data) {
+  data->point = touchPoint;
+  data->state = touchPressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+}
+
+static void runFor(uint32_t ms) { // Simulated time, what Display.loop() do on the device
+  for (uint32_t t = 0; t < ms; t += UI_SIM_FRAME_MS) {
+    lv_tick_inc(UI_SIM_FRAME_MS);
+    lv_timer_handler();
+  }
+}
+
+static void tap(lv_obj_t *obj) {
+  lv_obj_update_layout(obj);
+  lv_area_t area;
+  lv_obj_get_coords(obj, &area);
+  touchPoint.x = (area.x1 + area.x2) / 2;
+  touchPoint.y = (area.y1 + area.y2) / 2;
+  touchPressed = true;
+  runFor(100);
+  touchPressed = false;
+  runFor(100);
+
+  if (lv_obj_has_flag(obj, LV_OBJ_FLAG_CHECKABLE) && !lv_obj_has_state(obj, LV_STATE_CHECKED)) {
+    fprintf(stderr, "Tap at %d,%d missed, layout changed?\n", touchPoint.x, touchPoint.y);
+    missedTaps++;
+  }
+}
+
+static void updateLabels(uint32_t i) { // Same labels UI_loop set every call
+  lv_label_set_text_fmt(ui_time_now_label, "%d:%02d:%02d", 12, (int) (i / 60) % 60, (int) i % 60);
+  lv_label_set_text_fmt(ui_temp_sensor_value, "%.01f °C", 27.0 + (i % 10) * 0.1);
+  lv_label_set_text_fmt(ui_humi_sensor_value, "%.01f %%RH", 86.0 + (i % 7) * 0.1);
+  lv_label_set_text_fmt(ui_soil_sensor_value, "%.0f %%", 60.0 + (i % 3));
+  lv_label_set_text_fmt(ui_light_sensor_value, "%.02f kLux", 12.34 + (i % 5) * 0.01);
+}
+
+// ---------------- Screens ----------------
+static void showLoading() {
+  lv_disp_load_scr(ui_loading_page);
+}
+
+static void showDashboard() {
+  lv_disp_load_scr(ui_Index);
+  lv_obj_clear_flag(ui_wifi_status_icon, LV_OBJ_FLAG_HIDDEN);
+  lv_obj_clear_flag(ui_cloud_status_icon, LV_OBJ_FLAG_HIDDEN);
+  lv_obj_add_state(ui_o1_switch, LV_STATE_CHECKED);
+  lv_obj_add_state(ui_o4_switch, LV_STATE_CHECKED);
+  updateLabels(0);
+  tap(ui_home_btn);
+}
+
+static void showSwitchAuto() {
+  tap(ui_switch_btn);
+  tap(ui_switch2_select);
+  tap(ui_auto_select_btn);
+}
+
+static void showSwitchTimer() {
+  tap(ui_timer_select_btn);
+  tap(ui_timer1_select);
+}
+
+static void showTimeDialog() { // What time_input() in UI.cpp open
+  lv_obj_clear_flag(ui_number_and_time_dialog, LV_OBJ_FLAG_HIDDEN);
+}
+
+static void showWifi() {
+  lv_obj_add_flag(ui_number_and_time_dialog, LV_OBJ_FLAG_HIDDEN);
+  tap(ui_wifi_btn);
+}
+
+static void showSensor() {
+  tap(ui_sensor_btn);
+}
+
+struct UiSimScreen {
+  const char *name;
+  void (*show)();
+};
+
+static const UiSimScreen screens[] = {
+  { "loading",      showLoading },
+  { "dashboard",    showDashboard },
+  { "switch_auto",  showSwitchAuto },
+  { "switch_timer", showSwitchTimer },
+  { "time_dialog",  showTimeDialog },
+  { "wifi",         showWifi },
+  { "sensor",       showSensor },
+};
+
+// ---------------- Measure ----------------
+static uint32_t refreshTimed() {
+  auto start = std::chrono::steady_clock::now();
+  lv_refr_now(NULL);
+  return (uint32_t) std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static uint32_t average(const uint32_t *times, int count) {
+  uint64_t total = 0;
+  for (int i = 0; i < count; i++) {
+    total += times[i];
+  }
+  return count ? (uint32_t) (total / count) : 0;
+}
+
+static bool writePPM(const char *path) {
+  FILE *f = fopen(path, "wb");
+  if (!f) {
+    return false;
+  }
+  fprintf(f, "P6\n%d %d\n255\n", UI_SIM_WIDTH, UI_SIM_HEIGHT);
+  for (int i = 0; i < UI_SIM_WIDTH * UI_SIM_HEIGHT; i++) {
+    uint32_t argb = lv_color_to32(framebuffer[i]); // Undo LV_COLOR_16_SWAP
+    uint8_t rgb[3] = { (uint8_t) (argb >> 16), (uint8_t) (argb >> 8), (uint8_t) argb };
+    fwrite(rgb, 1, 3, f);
+  }
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  const char *outDir = (argc > 1) ? argv[1] : "ui_sim_out";
+  int frames = (argc > 2) ? atoi(argv[2]) : 50;
+  if (frames < 1 || frames > UI_SIM_MAX_FRAMES) {
+    fprintf(stderr, "frames 1..%d\n", UI_SIM_MAX_FRAMES);
+    return 2;
+  }
+  mkdir(outDir, 0755);
+
+  lv_init();
+
+  static lv_disp_draw_buf_t drawBuf;
+  lv_disp_draw_buf_init(&drawBuf, drawBuffer, NULL, UI_SIM_WIDTH * UI_SIM_BUF_LINES);
+  static lv_disp_drv_t dispDrv;
+  lv_disp_drv_init(&dispDrv);
+  dispDrv.hor_res = UI_SIM_WIDTH;
+  dispDrv.ver_res = UI_SIM_HEIGHT;
+  dispDrv.flush_cb = flush;
+  dispDrv.draw_buf = &drawBuf;
+  lv_disp_drv_register(&dispDrv);
+
+  static lv_indev_drv_t indevDrv;
+  lv_indev_drv_init(&indevDrv);
+  indevDrv.type = LV_INDEV_TYPE_POINTER;
+  indevDrv.read_cb = readTouch;
+  lv_indev_drv_register(&indevDrv);
+
+  ui_init();
+
+  char path[256];
+  snprintf(path, sizeof(path), "%s/frames.csv", outDir);
+  FILE *csv = fopen(path, "w");
+  if (!csv) {
+    fprintf(stderr, "Can't write %s\n", path);
+    return 1;
+  }
+  const char *header = "screen,full_avg_us,full_med_us,full_max_us,update_avg_us,update_px,mem_used\n";
+  fputs(header, csv);
+  fputs(header, stdout);
+
+  for (size_t s = 0; s < sizeof(screens) / sizeof(screens[0]); s++) {
+    screens[s].show();
+    runFor(UI_SIM_SETTLE_MS);
+
+    for (int i = 0; i < frames; i++) { // Whole screen, what a screen change cost
+      lv_obj_invalidate(lv_scr_act());
+      frameTimes[i] = refreshTimed();
+    }
+    uint32_t fullAvg = average(frameTimes, frames);
+    std::sort(frameTimes, frameTimes + frames);
+    uint32_t fullMedian = frameTimes[frames / 2];
+    uint32_t fullMax = frameTimes[frames - 1];
+
+    flushedPixels = 0;
+    for (int i = 0; i < frames; i++) { // Steady state, once a second on the device
+      updateLabels(i + 1);
+      frameTimes[i] = refreshTimed();
+    }
+    uint32_t updateAvg = average(frameTimes, frames);
+    uint32_t updatePixels = flushedPixels / frames;
+
+    updateLabels(0); // Screenshot with the fixed values
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);
+    snprintf(path, sizeof(path), "%s/%s.ppm", outDir, screens[s].name);
+    if (!writePPM(path)) {
+      fprintf(stderr, "Can't write %s\n", path);
+    }
+
+    lv_mem_monitor_t mem;
+    lv_mem_monitor(&mem);
+    char line[160];
+    snprintf(line, sizeof(line), "%s,%lu,%lu,%lu,%lu,%lu,%lu\n", screens[s].name, (unsigned long) fullAvg,
+             (unsigned long) fullMedian, (unsigned long) fullMax, (unsigned long) updateAvg,
+             (unsigned long) updatePixels, (unsigned long) (mem.total_size - mem.free_size));
+    fputs(line, csv);
+    fputs(line, stdout);
+  }
+  fclose(csv);
+  if (missedTaps) { // Screenshots show the wrong screen, don't diff them
+    fprintf(stderr, "%d tap(s) missed\n", missedTaps);
+    return 1;
+  }
+  return 0;
+}
+
+#endif
@@ -0,0 +1,133 @@
+#include "Perf.h"
+
+static portMUX_TYPE perfMux = portMUX_INITIALIZER_UNLOCKED;
+
+Perf::Slot Perf::slots[PERF_MAX_SLOTS] = {};
+int Perf::slotCount = 0;
+
+// ---------------- PerfHistogram ----------------
+void PerfHistogram::clear() {
+    memset(this, 0, sizeof(PerfHistogram));
+}
+
+void PerfHistogram::add(uint32_t us) {
+    int bucket = (us == 0) ? 0 : (31 - __builtin_clz(us));
+    if (bucket >= PERF_BUCKETS) {
+        bucket = PERF_BUCKETS - 1;
+    }
+
+    if (count == 0 || us < min_us) {
+        min_us = us;
+    }
+    count++;
+    total_us += us;
+    if (us > max_us) {
+        max_us = us;
+    }
+    buckets[bucket]++;
+}
+
+void PerfHistogram::snapshot(PerfSnapshot* snapshot) const {
+    snapshot->count = count;
+    snapshot->min_us = min_us;
+    snapshot->max_us = max_us;
+    snapshot->avg_us = count ? (uint32_t)(total_us / count) : 0;
+
+    // p99 = upper edge of the bucket that hold the 99th percentile sample
+    snapshot->p99_us = 0;
+    uint32_t target = count - (count / 100);
+    uint32_t seen = 0;
+    for (int b = 0; b < PERF_BUCKETS && count; b++) {
+        seen += buckets[b];
+        if (seen >= target) {
+            uint32_t upper = (b >= 31) ? 0xFFFFFFFF : ((1UL << (b + 1)) - 1);
+            snapshot->p99_us = (upper < max_us) ? upper : max_us;
+            break;
+        }
+    }
+}
+
+// ---------------- Perf ----------------
+
+int Perf::slot(const char* name) {
+    int index = -1;
+    portENTER_CRITICAL(&perfMux);
+    for (int i = 0; i < slotCount; i++) {
+        if (strcmp(slots[i].name, name) == 0) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0 && slotCount < PERF_MAX_SLOTS) {
+        index = slotCount++;
+        slots[index].name = name;
+        slots[index].histogram.clear();
+    }
+    portEXIT_CRITICAL(&perfMux);
+    return index;
+}
+
+void Perf::record(int slot, uint32_t us) {
+    if (slot < 0 || slot >= PERF_MAX_SLOTS) {
+        return;
+    }
+
+    portENTER_CRITICAL(&perfMux);
+    slots[slot].histogram.add(us);
+    portEXIT_CRITICAL(&perfMux);
+}
+
+int Perf::getSlotCount() {
+    return slotCount;
+}
+
+bool Perf::getSnapshot(int slot, PerfSnapshot* snapshot) {
+    if (slot < 0 || slot >= slotCount || !snapshot) {
+        return false;
+    }
+
+    PerfHistogram histogram;
+    portENTER_CRITICAL(&perfMux);
+    histogram = slots[slot].histogram;
+    portEXIT_CRITICAL(&perfMux);
+
+    snapshot->name = slots[slot].name;
+    histogram.snapshot(snapshot);
+    return true;
+}
+
+size_t Perf::summaryJSON(char* output, size_t len) {
+    size_t used = snprintf(output, len, "{");
+    for (int i = 0; i < slotCount && used < len; i++) {
+        PerfSnapshot snap;
+        if (!getSnapshot(i, &snap)) {
+            continue;
+        }
+        used += snprintf(&output[used], len - used, "%s\"%s\":{\"n\":%lu,\"min\":%lu,\"avg\":%lu,\"p99\":%lu,\"max\":%lu}",
+                         i ? "," : "", snap.name, (unsigned long)snap.count, (unsigned long)snap.min_us,
+                         (unsigned long)snap.avg_us, (unsigned long)snap.p99_us, (unsigned long)snap.max_us);
+    }
+    if (used < len) {
+        used += snprintf(&output[used], len - used, "}");
+    }
+    return (used < len) ? used : len - 1;
+}
+
+void Perf::print() {
+    Serial.printf("%-24s %8s %8s %8s %8s %8s (us)\n", "name", "n", "min", "avg", "p99", "max");
+    for (int i = 0; i < slotCount; i++) {
+        PerfSnapshot snap;
+        if (getSnapshot(i, &snap)) {
+            Serial.printf("%-24s %8lu %8lu %8lu %8lu %8lu\n", snap.name, (unsigned long)snap.count, (unsigned long)snap.min_us,
+                          (unsigned long)snap.avg_us, (unsigned long)snap.p99_us, (unsigned long)snap.max_us);
+        }
+    }
+}
+
+void Perf::reset() {
+    portENTER_CRITICAL(&perfMux);
+    for (int i = 0; i < slotCount; i++) {
+        slots[i].histogram.clear();
+    }
+    portEXIT_CRITICAL(&perfMux);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ===================================================================
+// Timing instrumentation
+// Each named slot keep count / min / avg / max and a log2 histogram
+// (bucket n = 2^n .. 2^(n+1) us) for p99, no allocation.
+//
+//   void foo() {
+//     PERF_SCOPE("foo");
+//     ...
+//   }
+// ===================================================================
+
+#define PERF_MAX_SLOTS          24
+#define PERF_BUCKETS            22     // Last bucket >= 2^21 us (~2 s)
+#define PERF_PUBLISH_INTERVAL   60000  // ms, summary to PERF_MQTT_TOPIC
+#define PERF_MQTT_TOPIC         "@msg/diag/perf"
+#define PERF_SUMMARY_SIZE       2048
+
+struct PerfSnapshot {
+    const char* name;
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t avg_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+};
+
+// log2 histogram, all zero = empty, caller does the locking
+struct PerfHistogram {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t buckets[PERF_BUCKETS];
+
+    void clear();
+    void add(uint32_t us);
+    void snapshot(PerfSnapshot* snapshot) const; // Everything but name
+};
+
+class Perf {
+public:
+    static int slot(const char* name); // Find or add, -1 if table full
+    static void record(int slot, uint32_t us);
+
+    static int getSlotCount();
+    static bool getSnapshot(int slot, PerfSnapshot* snapshot);
+    static size_t summaryJSON(char* output, size_t len); // {"name":{"n":..,"min":..,"avg":..,"p99":..,"max":..},...}
+    static void print(); // Table over Serial
+    static void reset();
+
+private:
+    struct Slot {
+        const char* name;
+        PerfHistogram histogram;
+    };
+
+    static Slot slots[PERF_MAX_SLOTS];
+    static int slotCount;
+};
+
+class PerfScope {
+public:
+    PerfScope(int slot) : slot(slot), start(micros()) { }
+    ~PerfScope() { Perf::record(slot, micros() - start); }
+
+private:
+    int slot;
+    uint32_t start;
+};
+
+#define PERF_CONCAT_(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_(a, b)
+#define PERF_SCOPE(name) \
+    static int PERF_CONCAT(_perfSlot, __LINE__) = Perf::slot(name); \
+    PerfScope PERF_CONCAT(_perfScope, __LINE__)(PERF_CONCAT(_perfSlot, __LINE__))
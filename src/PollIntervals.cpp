@@ -0,0 +1,126 @@
+#include "PollIntervals.h"
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "SwitchApiClient.h"
+#include "AutomationApiClient.h"
+#include "ApiPayload.h"
+
+static const char* TAG = "PollIntervals";
+
+#define EEPROM_MAGIC    0xB7
+#define EEPROM_VERSION  1
+// magic, version, POLL_COUNT x uint16 seconds (big endian like the timer table), xor checksum
+#define EEPROM_LENGTH   (2 + POLL_COUNT * 2 + 1)
+
+struct IntervalBounds {
+    uint16_t default_s;
+    uint16_t min_s;
+    uint16_t max_s;
+};
+
+// Max keep a device useful at the slowest (timers have minute resolution)
+static const IntervalBounds BOUNDS[POLL_COUNT] = {
+    { SWITCH_POLL_INTERVAL / 1000,      1,  300 },      // POLL_SWITCH
+    { AUTOMATION_SYNC_INTERVAL / 1000,  5,  3600 },     // POLL_AUTOMATION_SYNC
+    { POLL_TELEMETRY_INTERVAL / 1000,   5,  3600 },     // POLL_TELEMETRY
+    { TIMER_CHECK_INTERVAL / 1000,      1,  60 },       // POLL_TIMER_CHECK
+    { SENSOR_CHECK_INTERVAL / 1000,     1,  600 },      // POLL_SENSOR_CHECK
+};
+
+volatile uint16_t PollIntervals::hints[POLL_COUNT];
+volatile bool PollIntervals::dirty = false;
+uint32_t PollIntervals::lastSave = 0;
+
+void PollIntervals::begin() {
+    if (EEPROM.read(POLL_INTERVALS_EEPROM_ADDR) != EEPROM_MAGIC ||
+        EEPROM.read(POLL_INTERVALS_EEPROM_ADDR + 1) != EEPROM_VERSION) {
+        ESP_LOGI(TAG, "No saved intervals, use defaults");
+        return;
+    }
+
+    uint8_t checksum = 0;
+    uint16_t saved[POLL_COUNT];
+    for (int i = 0; i < POLL_COUNT; i++) {
+        uint8_t hi = EEPROM.read(POLL_INTERVALS_EEPROM_ADDR + 2 + i * 2);
+        uint8_t lo = EEPROM.read(POLL_INTERVALS_EEPROM_ADDR + 3 + i * 2);
+        checksum ^= hi ^ lo;
+        saved[i] = (hi << 8) | lo;
+    }
+    if (EEPROM.read(POLL_INTERVALS_EEPROM_ADDR + EEPROM_LENGTH - 1) != checksum) {
+        ESP_LOGW(TAG, "Saved intervals corrupt, use defaults");
+        return;
+    }
+
+    for (int i = 0; i < POLL_COUNT; i++) {
+        if (saved[i] != 0) {
+            hints[i] = constrain(saved[i], BOUNDS[i].min_s, BOUNDS[i].max_s); // Bounds may have changed since
+            ESP_LOGI(TAG, "%s: %u s (saved hint)", ApiPayload::intervalKey((PollInterval) i), hints[i]);
+        }
+    }
+}
+
+void PollIntervals::loop() {
+    if (!dirty || (lastSave != 0 && millis() - lastSave < POLL_INTERVALS_SAVE_INTERVAL)) {
+        return;
+    }
+    dirty = false;
+    lastSave = millis();
+
+    uint8_t checksum = 0;
+    EEPROM.write(POLL_INTERVALS_EEPROM_ADDR, EEPROM_MAGIC);
+    EEPROM.write(POLL_INTERVALS_EEPROM_ADDR + 1, EEPROM_VERSION);
+    for (int i = 0; i < POLL_COUNT; i++) {
+        uint16_t value = hints[i];
+        EEPROM.write(POLL_INTERVALS_EEPROM_ADDR + 2 + i * 2, value >> 8);
+        EEPROM.write(POLL_INTERVALS_EEPROM_ADDR + 3 + i * 2, value & 0xFF);
+        checksum ^= (value >> 8) ^ (value & 0xFF);
+    }
+    EEPROM.write(POLL_INTERVALS_EEPROM_ADDR + EEPROM_LENGTH - 1, checksum);
+    EEPROM.commit();
+    ESP_LOGD(TAG, "Saved");
+}
+
+uint32_t PollIntervals::get(PollInterval interval) {
+    if (interval >= POLL_COUNT) {
+        return 0;
+    }
+    uint16_t seconds = hints[interval];
+    return (seconds ? seconds : BOUNDS[interval].default_s) * 1000UL;
+}
+
+bool PollIntervals::hint(PollInterval interval, uint32_t seconds) {
+    if (interval >= POLL_COUNT) {
+        return false;
+    }
+
+    uint16_t value = 0;
+    if (seconds != 0) {
+        value = constrain(seconds, (uint32_t) BOUNDS[interval].min_s, (uint32_t) BOUNDS[interval].max_s);
+        if (value != seconds) {
+            ESP_LOGW(TAG, "%s: hint %lu s out of [%u, %u], use %u s", ApiPayload::intervalKey(interval),
+                     (unsigned long) seconds, BOUNDS[interval].min_s, BOUNDS[interval].max_s, value);
+        }
+        if (value == BOUNDS[interval].default_s) {
+            value = 0; // Follow the default if it change with a firmware update
+        }
+    }
+
+    if (hints[interval] == value) {
+        return false;
+    }
+    uint32_t before = get(interval);
+    hints[interval] = value;
+    dirty = true;
+    ESP_LOGI(TAG, "%s: %lu s -> %lu s%s", ApiPayload::intervalKey(interval), (unsigned long) (before / 1000),
+             (unsigned long) (get(interval) / 1000), value ? "" : " (default)");
+    return true;
+}
+
+void PollIntervals::print() {
+    Serial.printf("%-12s %8s %8s %8s %8s\n", "interval", "now_s", "default", "min", "max");
+    for (int i = 0; i < POLL_COUNT; i++) {
+        Serial.printf("%-12s %8lu %8u %8u %8u%s\n", ApiPayload::intervalKey((PollInterval) i),
+                      (unsigned long) (get((PollInterval) i) / 1000), BOUNDS[i].default_s, BOUNDS[i].min_s,
+                      BOUNDS[i].max_s, hints[i] ? " (hint)" : "");
+    }
+}
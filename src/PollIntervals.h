@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ===================================================================
+// Polling intervals the server can tune
+// - Defaults are the compile time intervals (SWITCH_POLL_INTERVAL ...)
+// - Hints in seconds: "intervals" object of the automation sync
+//   response, X-Poll-Interval header on an API response (interval of
+//   that endpoint), or the "intervals" serial command
+// - Clamped to [min, max] of each interval, 0 = back to the default
+// - Kept in EEPROM at POLL_INTERVALS_EEPROM_ADDR, written from the main
+//   loop at most once per POLL_INTERVALS_SAVE_INTERVAL
+// Retry-After is not an interval, HttpTransport hold that endpoint.
+// ===================================================================
+
+#define POLL_INTERVALS_EEPROM_ADDR      2500    // After the timer table (2100 - 2435)
+#define POLL_INTERVALS_SAVE_INTERVAL    60000   // ms, a flapping server doesn't wear the flash
+#define POLL_TELEMETRY_INTERVAL         10000   // ms, default of eventInterval_publishData
+
+enum PollInterval : uint8_t {
+    POLL_SWITCH,            // GET /api/switch
+    POLL_AUTOMATION_SYNC,   // GET /api/automation/sync
+    POLL_TELEMETRY,         // POST /api/telemetry
+    POLL_TIMER_CHECK,       // Local timer check
+    POLL_SENSOR_CHECK,      // Local sensor check
+    POLL_COUNT
+};
+
+class PollIntervals {
+public:
+    static void begin();    // Load saved hints, after EEPROM.begin
+    static void loop();     // Save when changed, call from main loop
+
+    static uint32_t get(PollInterval interval); // ms, hint or default
+
+    // seconds, 0 = default. Clamped, safe from any task. true if the interval changed
+    static bool hint(PollInterval interval, uint32_t seconds);
+
+    static void print();
+
+private:
+    static volatile uint16_t hints[POLL_COUNT]; // seconds, 0 = default
+    static volatile bool dirty;
+    static uint32_t lastSave;
+};
@@ -0,0 +1,278 @@
+#include "Rs485Bus.h"
+
+static const char* TAG = "RS485";
+
+HardwareSerial* Rs485Bus::serial = NULL;
+SemaphoreHandle_t Rs485Bus::lock = NULL;
+Rs485Bus::Node Rs485Bus::nodes[RS485_MAX_NODES] = {};
+int Rs485Bus::nodeCount = 0;
+uint32_t Rs485Bus::frameGapUs = 4010;
+uint32_t Rs485Bus::lastFrameEnd = 0;
+uint32_t Rs485Bus::lastCycleBusTime = 0;
+uint32_t Rs485Bus::maxCycleBusTime = 0;
+
+void Rs485Bus::begin(HardwareSerial& port, int rxPin, int txPin, uint32_t baud) {
+    serial = &port;
+    serial->begin(baud, SERIAL_8N1, rxPin, txPin);
+    if (!lock) {
+        lock = xSemaphoreCreateMutex();
+    }
+
+    // Modbus RTU silent interval = 3.5 char (11 bit per char)
+    frameGapUs = (uint32_t)((3.5f * 11.0f * 1000000.0f) / baud);
+    if (baud > 19200) {
+        frameGapUs = 1750; // Fixed value for baud rate > 19200
+    }
+
+    ESP_LOGI(TAG, "RS485 bus started, %lu baud", (unsigned long)baud);
+}
+
+int Rs485Bus::addNode(uint8_t slave_id, uint8_t function, uint16_t start_register, uint8_t register_count,
+                      uint32_t period_ms, Rs485NodeCallback callback, void* arg,
+                      uint16_t timeout_ms, uint8_t retries) {
+    if (nodeCount >= RS485_MAX_NODES || register_count == 0 || register_count > RS485_MAX_REGISTERS) {
+        ESP_LOGE(TAG, "Add node fail, slave=%d count=%d", slave_id, register_count);
+        return -1;
+    }
+
+    Node& node = nodes[nodeCount];
+    memset(&node, 0, sizeof(node));
+    node.slave_id = slave_id;
+    node.function = function;
+    node.start_register = start_register;
+    node.register_count = register_count;
+    node.retries = retries;
+    node.timeout_ms = timeout_ms;
+    node.period_ms = period_ms;
+    node.callback = callback;
+    node.arg = arg;
+    node.stats.slave_id = slave_id;
+
+    ESP_LOGI(TAG, "Node %d: slave=%d fn=0x%02X reg=0x%04X count=%d period=%lu ms timeout=%d ms",
+             nodeCount, slave_id, function, start_register, register_count, (unsigned long)period_ms, timeout_ms);
+    return nodeCount++;
+}
+
+uint32_t Rs485Bus::poll() {
+    if (!serial || nodeCount == 0) {
+        return 1000;
+    }
+
+    uint32_t busTime = 0;
+    bool anyPolled = false;
+
+    for (int i = 0; i < nodeCount; i++) {
+        Node& node = nodes[i];
+        if (node.polled && ((millis() - node.last_poll) + RS485_POLL_TOLERANCE) < node.period_ms) {
+            continue;
+        }
+        node.last_poll = millis();
+        node.polled = true;
+        anyPolled = true;
+
+        uint16_t registers[RS485_MAX_REGISTERS];
+        Rs485Result result = RS485_TIMEOUT;
+        for (uint8_t attempt = 0; attempt <= node.retries; attempt++) {
+            if (attempt > 0) {
+                node.stats.retries++;
+            }
+
+            uint32_t start = millis();
+            result = transaction(node.slave_id, node.function, node.start_register, node.register_count, registers, node.timeout_ms);
+            uint32_t latency = millis() - start;
+            busTime += latency;
+
+            node.stats.requests++;
+            if (result == RS485_OK) {
+                node.stats.success++;
+                node.stats.last_latency_ms = latency;
+                if (latency > node.stats.max_latency_ms) {
+                    node.stats.max_latency_ms = latency;
+                }
+                node.stats.last_success = millis();
+                break;
+            } else if (result == RS485_TIMEOUT) {
+                node.stats.timeouts++;
+            } else if (result == RS485_CRC_ERROR) {
+                node.stats.crc_errors++;
+            } else if (result == RS485_EXCEPTION || result == RS485_INVALID_RESPONSE) {
+                node.stats.exceptions++;
+            }
+        }
+
+        if (result == RS485_OK) {
+            if (node.callback) {
+                node.callback(registers, node.register_count, node.arg);
+            }
+        } else {
+            ESP_LOGW(TAG, "Node %d (slave %d) read fail, result=%d", i, node.slave_id, result);
+        }
+    }
+
+    if (anyPolled) {
+        lastCycleBusTime = busTime;
+        if (busTime > maxCycleBusTime) {
+            maxCycleBusTime = busTime;
+        }
+        ESP_LOGV(TAG, "Bus time this cycle: %lu ms", (unsigned long)busTime);
+    }
+
+    // Time until the next node is due
+    uint32_t nextDue = 0xFFFFFFFF;
+    for (int i = 0; i < nodeCount; i++) {
+        uint32_t elapsed = millis() - nodes[i].last_poll;
+        uint32_t remain = elapsed >= nodes[i].period_ms ? 0 : nodes[i].period_ms - elapsed;
+        if (remain < nextDue) {
+            nextDue = remain;
+        }
+    }
+    return nextDue;
+}
+
+Rs485Result Rs485Bus::readRegisters(uint8_t slave_id, uint8_t function, uint16_t start_register,
+                                    uint8_t register_count, uint16_t* output, uint16_t timeout_ms) {
+    if (!serial || register_count == 0 || register_count > RS485_MAX_REGISTERS) {
+        return RS485_INVALID_RESPONSE;
+    }
+    return transaction(slave_id, function, start_register, register_count, output, timeout_ms);
+}
+
+int Rs485Bus::getNodeCount() {
+    return nodeCount;
+}
+
+bool Rs485Bus::getNodeStats(int index, Rs485NodeStats* stats) {
+    if (index < 0 || index >= nodeCount || !stats) {
+        return false;
+    }
+    *stats = nodes[index].stats;
+    return true;
+}
+
+uint32_t Rs485Bus::getLastCycleBusTime() {
+    return lastCycleBusTime;
+}
+
+uint32_t Rs485Bus::getMaxCycleBusTime() {
+    return maxCycleBusTime;
+}
+
+size_t Rs485Bus::summaryJSON(char* output, size_t len) {
+    size_t used = snprintf(output, len, "{\"bus_ms\":%lu,\"bus_max_ms\":%lu", (unsigned long)lastCycleBusTime,
+                           (unsigned long)maxCycleBusTime);
+    for (int i = 0; i < nodeCount && used < len; i++) {
+        Rs485NodeStats stats;
+        getNodeStats(i, &stats);
+        used += snprintf(&output[used], len - used,
+                         ",\"%u\":{\"req\":%lu,\"ok\":%lu,\"timeout\":%lu,\"crc\":%lu,\"exc\":%lu,\"retry\":%lu,\"last_ms\":%u,\"max_ms\":%u}",
+                         stats.slave_id, (unsigned long)stats.requests, (unsigned long)stats.success,
+                         (unsigned long)stats.timeouts, (unsigned long)stats.crc_errors,
+                         (unsigned long)stats.exceptions, (unsigned long)stats.retries, stats.last_latency_ms,
+                         stats.max_latency_ms);
+    }
+    if (used < len) {
+        used += snprintf(&output[used], len - used, "}");
+    }
+    return (used < len) ? used : len - 1;
+}
+
+void Rs485Bus::print() {
+    Serial.printf("RS485 bus time last cycle %lu ms, max %lu ms\n", (unsigned long)lastCycleBusTime,
+                  (unsigned long)maxCycleBusTime);
+    Serial.printf("%-5s %8s %8s %7s %5s %5s %6s %8s %8s (ms)\n", "slave", "req", "ok", "timeout", "crc", "exc",
+                  "retry", "last", "max");
+    for (int i = 0; i < nodeCount; i++) {
+        Rs485NodeStats stats;
+        getNodeStats(i, &stats);
+        Serial.printf("%-5u %8lu %8lu %7lu %5lu %5lu %6lu %8u %8u\n", stats.slave_id, (unsigned long)stats.requests,
+                      (unsigned long)stats.success, (unsigned long)stats.timeouts, (unsigned long)stats.crc_errors,
+                      (unsigned long)stats.exceptions, (unsigned long)stats.retries, stats.last_latency_ms,
+                      stats.max_latency_ms);
+    }
+}
+
+Rs485Result Rs485Bus::transaction(uint8_t slave_id, uint8_t function, uint16_t start_register,
+                                  uint8_t register_count, uint16_t* output, uint16_t timeout_ms) {
+    if (xSemaphoreTake(lock, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        return RS485_BUS_BUSY;
+    }
+
+    // Keep the silent interval between frames
+    uint32_t gap = micros() - lastFrameEnd;
+    if (gap < frameGapUs) {
+        delayMicroseconds(frameGapUs - gap);
+    }
+
+    // Drop garbage from the previous transaction
+    while (serial->available()) {
+        serial->read();
+    }
+
+    uint8_t request[8];
+    request[0] = slave_id;
+    request[1] = function;
+    request[2] = start_register >> 8;
+    request[3] = start_register & 0xFF;
+    request[4] = 0;
+    request[5] = register_count;
+    uint16_t crc = crc16(request, 6);
+    request[6] = crc & 0xFF;
+    request[7] = crc >> 8;
+
+    serial->write(request, sizeof(request));
+    serial->flush(); // Wait until TX done
+
+    // Response: id, fn, byte count, data (2 * count), crc (2)
+    uint8_t response[5 + (2 * RS485_MAX_REGISTERS)];
+    size_t expected = 5 + (2 * register_count);
+    size_t received = 0;
+    uint32_t start = millis();
+    Rs485Result result = RS485_TIMEOUT;
+    while ((millis() - start) < timeout_ms) {
+        while (serial->available() && received < expected) {
+            response[received++] = serial->read();
+        }
+
+        if (received >= 5 && (response[1] & 0x80)) { // Exception response is 5 bytes
+            expected = 5;
+        }
+        if (received >= expected) {
+            result = RS485_OK;
+            break;
+        }
+        delay(1);
+    }
+    lastFrameEnd = micros();
+
+    if (result == RS485_OK) {
+        uint16_t responseCRC = response[expected - 2] | (response[expected - 1] << 8);
+        if (crc16(response, expected - 2) != responseCRC) {
+            result = RS485_CRC_ERROR;
+        } else if (response[0] != slave_id) {
+            result = RS485_INVALID_RESPONSE;
+        } else if (response[1] & 0x80) {
+            ESP_LOGD(TAG, "Slave %d exception code %d", slave_id, response[2]);
+            result = RS485_EXCEPTION;
+        } else if (response[1] != function || response[2] != (2 * register_count)) {
+            result = RS485_INVALID_RESPONSE;
+        } else {
+            for (uint8_t i = 0; i < register_count; i++) {
+                output[i] = (response[3 + (i * 2)] << 8) | response[4 + (i * 2)];
+            }
+        }
+    }
+
+    xSemaphoreGive(lock);
+    return result;
+}
+
+uint16_t Rs485Bus::crc16(const uint8_t* data, size_t len) { // Modbus CRC-16, poly 0xA001
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x0001) ? ((crc >> 1) ^ 0xA001) : (crc >> 1);
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ===================================================================
+// RS485 bus manager (Modbus RTU master)
+// - One request reads a contiguous block of registers
+// - Several slave IDs polled on their own period
+// - Per-node response timeout, retry count and statistics, shown by
+//   the "perf" serial command and published to RS485_MQTT_TOPIC with
+//   the bus time of the last poll cycle
+// ===================================================================
+
+#define RS485_BAUD_RATE             9600
+#define RS485_MAX_NODES             8
+#define RS485_MAX_REGISTERS         16
+#define RS485_DEFAULT_TIMEOUT       200   // ms, response timeout per request
+#define RS485_DEFAULT_RETRIES       1
+#define RS485_POLL_TOLERANCE        20    // ms, node is due when this close to its period
+#define RS485_MQTT_TOPIC            "@msg/diag/rs485"
+
+// Modbus function codes
+#define MODBUS_READ_HOLDING_REGISTERS   0x03
+#define MODBUS_READ_INPUT_REGISTERS     0x04
+
+enum Rs485Result : uint8_t {
+    RS485_OK = 0,
+    RS485_TIMEOUT,
+    RS485_CRC_ERROR,
+    RS485_EXCEPTION,
+    RS485_INVALID_RESPONSE,
+    RS485_BUS_BUSY,
+};
+
+struct Rs485NodeStats {
+    uint8_t slave_id;
+    uint32_t requests;      // transactions sent (include retries)
+    uint32_t success;
+    uint32_t timeouts;
+    uint32_t crc_errors;
+    uint32_t exceptions;    // Modbus exception response or invalid frame
+    uint32_t retries;
+    uint16_t last_latency_ms;
+    uint16_t max_latency_ms;
+    uint32_t last_success;  // millis()
+};
+
+// Called from the polling task with a fresh block of registers
+typedef void (*Rs485NodeCallback)(const uint16_t* registers, uint8_t count, void* arg);
+
+class Rs485Bus {
+public:
+    static void begin(HardwareSerial& serial, int rxPin, int txPin, uint32_t baud = RS485_BAUD_RATE);
+
+    /**
+     * @brief Register a node polled every period_ms
+     * @return node index, -1 if table full or invalid
+     */
+    static int addNode(uint8_t slave_id, uint8_t function, uint16_t start_register, uint8_t register_count,
+                       uint32_t period_ms, Rs485NodeCallback callback, void* arg = NULL,
+                       uint16_t timeout_ms = RS485_DEFAULT_TIMEOUT, uint8_t retries = RS485_DEFAULT_RETRIES);
+
+    /**
+     * @brief Poll every node that is due
+     * @return ms until the next node is due
+     */
+    static uint32_t poll();
+
+    /**
+     * @brief Single read transaction (blocking in caller task)
+     */
+    static Rs485Result readRegisters(uint8_t slave_id, uint8_t function, uint16_t start_register,
+                                     uint8_t register_count, uint16_t* output,
+                                     uint16_t timeout_ms = RS485_DEFAULT_TIMEOUT);
+
+    static int getNodeCount();
+    static bool getNodeStats(int index, Rs485NodeStats* stats);
+    static uint32_t getLastCycleBusTime();
+    static uint32_t getMaxCycleBusTime();
+    static size_t summaryJSON(char* output, size_t len); // {"bus_ms":..,"bus_max_ms":..,"1":{"req":..,"ok":..,"timeout":..,"crc":..,"exc":..,"retry":..,"last_ms":..,"max_ms":..},...}
+    static void print(); // Table over Serial
+
+private:
+    struct Node {
+        uint8_t slave_id;
+        uint8_t function;
+        uint16_t start_register;
+        uint8_t register_count;
+        uint8_t retries;
+        uint16_t timeout_ms;
+        uint32_t period_ms;
+        uint32_t last_poll;
+        bool polled;
+        Rs485NodeCallback callback;
+        void* arg;
+        Rs485NodeStats stats;
+    };
+
+    static Rs485Result transaction(uint8_t slave_id, uint8_t function, uint16_t start_register,
+                                   uint8_t register_count, uint16_t* output, uint16_t timeout_ms);
+    static uint16_t crc16(const uint8_t* data, size_t len);
+
+    static HardwareSerial* serial;
+    static SemaphoreHandle_t lock;
+    static Node nodes[RS485_MAX_NODES];
+    static int nodeCount;
+    static uint32_t frameGapUs;
+    static uint32_t lastFrameEnd;
+    static uint32_t lastCycleBusTime;
+    static uint32_t maxCycleBusTime;
+};
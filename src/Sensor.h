@@ -3,9 +3,25 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-void Sensor_init() ; // Setup sensor
+// Sensor channels published by the acquisition task
+typedef enum {
+  SENSOR_TEMP = 0,
+  SENSOR_HUMI,
+  SENSOR_SOIL,
+  SENSOR_LIGHT,
+  SENSOR_CHANNEL_COUNT
+} SensorChannel;
+
+// Latest sample of one channel, timestamp is millis() when the value was collected
+typedef struct {
+  float value;
+  uint32_t timestamp;
+  bool valid;
+} SensorSample;
+
+void Sensor_init() ; // Setup sensor and start acquisition task
+bool Sensor_getSample(SensorChannel ch, SensorSample *sample) ; // Latest sample, never blocks
 bool Sensor_getTemp(float*) ; // Get Temperature from sensor in °C unit
 bool Sensor_getHumi(float*) ; // Get Humidity from sensor in %RH unit
 bool Sensor_getSoil(float*) ; // Get Soil Humidity from sensor in % unit
 bool Sensor_getLight(float*) ; // Get Light from sensor in lux uint
-
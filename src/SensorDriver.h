@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "Sensor.h"
+
+// ===================================================================
+// Sensor driver interface
+// A driver starts a conversion (trigger), then the acquisition task
+// comes back after the returned wait time to read it (collect).
+// No driver may block for the conversion time itself.
+// ===================================================================
+
+#define SENSOR_CH_MASK(ch) (1 << (ch))
+
+enum SensorStep {
+  SENSOR_STEP_DONE = 0, // Finished, go to next step
+  SENSOR_STEP_WAIT,     // Call collect() again after waitTime
+  SENSOR_STEP_FAIL
+};
+
+// Values produced by one collect(), mask bit n = channel n is set
+struct SensorReading {
+  float value[SENSOR_CHANNEL_COUNT];
+  uint8_t mask;
+
+  void set(SensorChannel ch, float v) {
+    value[ch] = v;
+    mask |= SENSOR_CH_MASK(ch);
+  }
+};
+
+class SensorDriver {
+  public:
+    virtual ~SensorDriver() { }
+
+    virtual const char * name() const = 0;
+    virtual uint8_t channels() const = 0; // Mask of SensorChannel this driver publish
+
+    virtual bool begin() = 0; // Probe and setup, false if device not found
+    virtual SensorStep trigger(uint32_t *waitTime) = 0; // Start conversion
+    virtual SensorStep collect(SensorReading *reading, uint32_t *waitTime) = 0; // Read result
+
+};
@@ -0,0 +1,289 @@
+#include "SensorDrivers.h"
+#include "SensorRegistry.h"
+#include "PinConfigs.h"
+#include "UserConfigs.h"
+#include "Rs485Bus.h"
+#include "AnalogInput.h"
+#include "I2CBus.h"
+#include <SHT2x.h>
+
+static const char * TAG = "SensorDrivers";
+
+#define SHT2X_ADDR 0x40
+
+static SHT2x sht; // SHT2x has a fixed address, only one on the bus
+
+// ---------------- Raw I2C helpers (trigger now, collect later) ----------------
+static bool i2cPresent(uint8_t addr) {
+  return I2CBus::probe(addr);
+}
+
+static bool i2cWrite(uint8_t addr, const uint8_t *data, size_t len) {
+  return I2CBus::write(addr, data, len);
+}
+
+static bool i2cRead(uint8_t addr, uint8_t *data, size_t len) {
+  return I2CBus::read(addr, data, len);
+}
+
+static uint8_t shtCRC8(const uint8_t *data, size_t len) { // CRC-8 poly 0x31, init 0xFF
+  uint8_t crc = 0xFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? ((crc << 1) ^ 0x31) : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+static bool shtReadWords(uint8_t addr, uint16_t *word0, uint16_t *word1) { // 2 words, each with CRC
+  uint8_t buff[6];
+  if (!i2cRead(addr, buff, sizeof(buff))) {
+    return false;
+  }
+  if ((shtCRC8(&buff[0], 2) != buff[2]) || (shtCRC8(&buff[3], 2) != buff[5])) {
+    return false;
+  }
+  *word0 = (buff[0] << 8) | buff[1];
+  *word1 = (buff[3] << 8) | buff[4];
+  return true;
+}
+
+// ---------------- SHT3x / SHT45 ----------------
+bool ShtDriver::isSht4x(uint8_t addr) {
+  static const uint8_t cmd[] = { 0x89 }; // Read serial number, SHT3x use 16 bit command so it never answer this
+  if (!i2cWrite(addr, cmd, sizeof(cmd))) {
+    return false;
+  }
+  delay(1);
+  uint16_t serial0, serial1;
+  return shtReadWords(addr, &serial0, &serial1);
+}
+
+bool ShtDriver::begin() {
+  return i2cPresent(addr);
+}
+
+SensorStep ShtDriver::trigger(uint32_t *waitTime) {
+  if (sht4x) {
+    static const uint8_t cmd[] = { 0xFD }; // Measure T & RH with high precision
+    *waitTime = SHT45_CONVERSION_TIME;
+    return i2cWrite(addr, cmd, sizeof(cmd)) ? SENSOR_STEP_DONE : SENSOR_STEP_FAIL;
+  }
+
+  static const uint8_t cmd[] = { 0x24, 0x00 }; // Single shot, high repeatability, no clock stretching
+  *waitTime = SHT3X_CONVERSION_TIME;
+  return i2cWrite(addr, cmd, sizeof(cmd)) ? SENSOR_STEP_DONE : SENSOR_STEP_FAIL;
+}
+
+SensorStep ShtDriver::collect(SensorReading *reading, uint32_t *) {
+  uint16_t rawT, rawH;
+  if (!shtReadWords(addr, &rawT, &rawH)) {
+    ESP_LOGE(TAG, "%s (0x%02X) read fail", name(), addr);
+    return SENSOR_STEP_FAIL;
+  }
+
+  reading->set(SENSOR_TEMP, -45.0f + (175.0f * rawT / 65535.0f));
+  if (sht4x) {
+    float humi = -6.0f + (125.0f * rawH / 65535.0f);
+    reading->set(SENSOR_HUMI, constrain(humi, 0.0f, 100.0f));
+  } else {
+    reading->set(SENSOR_HUMI, 100.0f * rawH / 65535.0f);
+  }
+  return SENSOR_STEP_DONE;
+}
+
+// ---------------- SHT2x (temperature then humidity) ----------------
+bool Sht2xDriver::begin() {
+  I2CBusLock bus(SHT2X_ADDR);
+  return bus.isLocked() && bus.check(sht.begin() && sht.isConnected());
+}
+
+SensorStep Sht2xDriver::trigger(uint32_t *waitTime) {
+  I2CBusLock bus(SHT2X_ADDR);
+  humidityStep = false;
+  *waitTime = SHT2X_T_CONVERSION_TIME;
+  return (bus.isLocked() && bus.check(sht.requestTemperature())) ? SENSOR_STEP_DONE : SENSOR_STEP_FAIL;
+}
+
+SensorStep Sht2xDriver::collect(SensorReading *reading, uint32_t *waitTime) {
+  I2CBusLock bus(SHT2X_ADDR);
+  if (!bus.isLocked()) {
+    humidityStep = false;
+    return SENSOR_STEP_FAIL;
+  }
+
+  if (!humidityStep) {
+    if (!bus.check(sht.readTemperature())) {
+      ESP_LOGE(TAG, "SHT2x read fail");
+      return SENSOR_STEP_FAIL;
+    }
+    reading->set(SENSOR_TEMP, sht.getTemperature());
+
+    if (!bus.check(sht.requestHumidity())) {
+      return SENSOR_STEP_FAIL;
+    }
+    humidityStep = true;
+    *waitTime = SHT2X_H_CONVERSION_TIME;
+    return SENSOR_STEP_WAIT;
+  }
+
+  humidityStep = false;
+  if (!bus.check(sht.readHumidity())) {
+    ESP_LOGE(TAG, "SHT2x read fail");
+    return SENSOR_STEP_FAIL;
+  }
+  reading->set(SENSOR_HUMI, sht.getHumidity());
+  return SENSOR_STEP_DONE;
+}
+
+// ---------------- BH1750 ----------------
+bool Bh1750Driver::begin() {
+  static const uint8_t powerOn[] = { 0x01 };
+  static const uint8_t continuouslyHMode[] = { 0x10 };
+  return i2cWrite(addr, powerOn, sizeof(powerOn)) && i2cWrite(addr, continuouslyHMode, sizeof(continuouslyHMode));
+}
+
+SensorStep Bh1750Driver::trigger(uint32_t *waitTime) { // Continuously H-resolution mode, new value every 120 ms
+  *waitTime = 0;
+  return SENSOR_STEP_DONE;
+}
+
+SensorStep Bh1750Driver::collect(SensorReading *reading, uint32_t *) {
+  uint8_t buff[2];
+  if (!i2cRead(addr, buff, sizeof(buff))) {
+    ESP_LOGE(TAG, "BH1750 (0x%02X) read fail", addr);
+    return SENSOR_STEP_FAIL;
+  }
+  reading->set(SENSOR_LIGHT, ((buff[0] << 8) | buff[1]) / 1.2f);
+  return SENSOR_STEP_DONE;
+}
+
+// ---------------- Analog soil ----------------
+bool AnalogSoilDriver::begin() { // Can't probe analog input, always there
+  return pin >= 0;
+}
+
+SensorStep AnalogSoilDriver::trigger(uint32_t *waitTime) {
+  *waitTime = 0;
+  return SENSOR_STEP_DONE;
+}
+
+SensorStep AnalogSoilDriver::collect(SensorReading *reading, uint32_t *) {
+  uint16_t raw;
+  if (AnalogInput_isRunning()) { // Oversampled by ADC DMA, no conversion here
+    if (!AnalogInput_getRaw(pin, &raw)) {
+      return SENSOR_STEP_DONE; // First window not finish yet
+    }
+  } else {
+    raw = analogRead(pin);
+  }
+  ESP_LOGV(TAG, "Soil analog value (pin %d) : %d", pin, raw);
+  float value = map(raw, rawDry, rawWet, 0, 100);
+  reading->set(SENSOR_SOIL, constrain(value, 0, 100));
+  return SENSOR_STEP_DONE;
+}
+
+// ---------------- RS485 ----------------
+const char * ModbusSensorDriver::name() const {
+  switch (model) {
+    case ATS_TH:  return "ATS-TH";
+    case XY_MD02: return "XY-MD02";
+    case ATS_LUX: return "ATS-LUX";
+    default:      return "Modbus";
+  }
+}
+
+uint8_t ModbusSensorDriver::channels() const {
+  if (model == ATS_LUX) {
+    return SENSOR_CH_MASK(SENSOR_LIGHT);
+  }
+  return SENSOR_CH_MASK(SENSOR_TEMP) | SENSOR_CH_MASK(SENSOR_HUMI);
+}
+
+bool ModbusSensorDriver::begin() {
+  if ((model != ATS_TH) && (model != XY_MD02) && (model != ATS_LUX)) {
+    ESP_LOGE(TAG, "Unknown Modbus sensor model %d", model);
+    return false;
+  }
+
+  // 0x0001-0x0002 is the data block of every supported model
+  if (Rs485Bus::readRegisters(slaveId, MODBUS_READ_INPUT_REGISTERS, 0x0001, 2, registers, MODBUS_SENSOR_PROBE_TIMEOUT) != RS485_OK) {
+    return false;
+  }
+  return Rs485Bus::addNode(slaveId, MODBUS_READ_INPUT_REGISTERS, 0x0001, 2, SENSOR_SAMPLE_INTERVAL, onRegisters, this) >= 0;
+}
+
+void ModbusSensorDriver::onRegisters(const uint16_t *data, uint8_t count, void *arg) { // Rs485Bus::poll() run in the sensor task too
+  ModbusSensorDriver *driver = (ModbusSensorDriver *) arg;
+  driver->registers[0] = data[0];
+  driver->registers[1] = data[1];
+  driver->sequence++;
+}
+
+SensorStep ModbusSensorDriver::trigger(uint32_t *waitTime) {
+  *waitTime = 0;
+  return SENSOR_STEP_DONE;
+}
+
+SensorStep ModbusSensorDriver::collect(SensorReading *reading, uint32_t *) {
+  if (sequence == collected) { // Nothing new since last cycle, let the sample age
+    return SENSOR_STEP_DONE;
+  }
+  collected = sequence;
+
+  if (model == ATS_LUX) { // 0x0001-0x0002 Lux (32 bit)
+    reading->set(SENSOR_LIGHT, (uint32_t)((registers[1] << 16) | registers[0]));
+  } else { // 0x0001 Temp, 0x0002 Humi
+    reading->set(SENSOR_TEMP, ((int16_t) registers[0]) / 10.0);
+    reading->set(SENSOR_HUMI, registers[1] / 10.0);
+  }
+  return SENSOR_STEP_DONE;
+}
+
+// ---------------- Probe ----------------
+static void addDriver(SensorDriver *driver) {
+  if (!SensorRegistry::add(driver)) {
+    ESP_LOGW(TAG, "%s not found", driver->name());
+    delete driver;
+  }
+}
+
+void SensorDrivers_probe() {
+  // Temperature & Humidity, SHT3x ADDR pin jump to GND => 0x44, VCC => 0x45 (SHT45-AD1B => 0x44)
+  static const uint8_t shtAddr[] = { 0x44, 0x45 };
+  for (uint8_t i = 0; i < sizeof(shtAddr); i++) {
+    if (i2cPresent(shtAddr[i])) {
+      addDriver(new ShtDriver(shtAddr[i], ShtDriver::isSht4x(shtAddr[i])));
+    }
+  }
+  if (i2cPresent(SHT2X_ADDR)) {
+    addDriver(new Sht2xDriver());
+  }
+
+  // Light, BH1750 ADDR pin jump to GND => 0x23, VCC => 0x5C
+  static const uint8_t bh1750Addr[] = { 0x23, 0x5C };
+  for (uint8_t i = 0; i < sizeof(bh1750Addr); i++) {
+    if (i2cPresent(bh1750Addr[i])) {
+      addDriver(new Bh1750Driver(bh1750Addr[i]));
+    }
+  }
+
+  // Soil
+  static const int soilPins[] = SOIL_PINS;
+  for (uint8_t i = 0; i < (sizeof(soilPins) / sizeof(soilPins[0])); i++) {
+    addDriver(new AnalogSoilDriver(soilPins[i], SOIL_ANALOG_MIN, SOIL_ANALOG_MAX));
+  }
+
+  // RS485, model can't be read from the device so use the list in UserConfigs.h
+  static const struct {
+    int model;
+    uint8_t id;
+  } modbusSensors[] = { MODBUS_SENSOR_LIST { 0, 0 } };
+  for (uint8_t i = 0; modbusSensors[i].id != 0; i++) {
+    addDriver(new ModbusSensorDriver(modbusSensors[i].model, modbusSensors[i].id));
+  }
+
+  ESP_LOGI(TAG, "%d sensor driver(s) registered", SensorRegistry::count());
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <Arduino.h>
+#include "SensorDriver.h"
+
+// ===================================================================
+// Hardware sensor drivers
+// SensorDrivers_probe() scan I2C / RS485 at boot and register every
+// sensor found into SensorRegistry, more than one instance is allowed.
+// ===================================================================
+
+// Datasheet max conversion time (ms)
+#define SHT45_CONVERSION_TIME   10 // High repeatability, max 8.3 ms
+#define SHT3X_CONVERSION_TIME   16 // High repeatability, max 15.5 ms
+#define SHT2X_T_CONVERSION_TIME 85 // 14 bit temperature
+#define SHT2X_H_CONVERSION_TIME 29 // 12 bit humidity
+
+#define MODBUS_SENSOR_PROBE_TIMEOUT 100 // ms
+
+void SensorDrivers_probe() ; // Find sensors and add them to SensorRegistry
+
+// ---------------- I2C ----------------
+class ShtDriver : public SensorDriver { // SHT3x / SHT45, same result frame
+  public:
+    ShtDriver(uint8_t addr, bool sht4x) : addr(addr), sht4x(sht4x) { }
+
+    const char * name() const { return sht4x ? "SHT45" : "SHT3x"; }
+    uint8_t channels() const { return SENSOR_CH_MASK(SENSOR_TEMP) | SENSOR_CH_MASK(SENSOR_HUMI); }
+    bool begin() ;
+    SensorStep trigger(uint32_t *waitTime) ;
+    SensorStep collect(SensorReading *reading, uint32_t *waitTime) ;
+
+    static bool isSht4x(uint8_t addr) ; // SHT4x answer "read serial number" (0x89), SHT3x not
+
+  private:
+    uint8_t addr;
+    bool sht4x;
+};
+
+class Sht2xDriver : public SensorDriver {
+  public:
+    Sht2xDriver() : humidityStep(false) { }
+
+    const char * name() const { return "SHT2x"; }
+    uint8_t channels() const { return SENSOR_CH_MASK(SENSOR_TEMP) | SENSOR_CH_MASK(SENSOR_HUMI); }
+    bool begin() ;
+    SensorStep trigger(uint32_t *waitTime) ;
+    SensorStep collect(SensorReading *reading, uint32_t *waitTime) ;
+
+  private:
+    bool humidityStep;
+};
+
+class Bh1750Driver : public SensorDriver {
+  public:
+    Bh1750Driver(uint8_t addr) : addr(addr) { }
+
+    const char * name() const { return "BH1750"; }
+    uint8_t channels() const { return SENSOR_CH_MASK(SENSOR_LIGHT); }
+    bool begin() ;
+    SensorStep trigger(uint32_t *waitTime) ;
+    SensorStep collect(SensorReading *reading, uint32_t *waitTime) ;
+
+  private:
+    uint8_t addr;
+};
+
+// ---------------- Analog ----------------
+class AnalogSoilDriver : public SensorDriver {
+  public:
+    AnalogSoilDriver(int pin, int rawDry, int rawWet) : pin(pin), rawDry(rawDry), rawWet(rawWet) { }
+
+    const char * name() const { return "Analog soil"; }
+    uint8_t channels() const { return SENSOR_CH_MASK(SENSOR_SOIL); }
+    bool begin() ;
+    SensorStep trigger(uint32_t *waitTime) ;
+    SensorStep collect(SensorReading *reading, uint32_t *waitTime) ;
+
+  private:
+    int pin;
+    int rawDry;
+    int rawWet;
+};
+
+// ---------------- RS485 (polled by Rs485Bus, collect return the last block) ----------------
+class ModbusSensorDriver : public SensorDriver {
+  public:
+    ModbusSensorDriver(int model, uint8_t slaveId) : model(model), slaveId(slaveId), sequence(0), collected(0) { }
+
+    const char * name() const ;
+    uint8_t channels() const ;
+    bool begin() ;
+    SensorStep trigger(uint32_t *waitTime) ;
+    SensorStep collect(SensorReading *reading, uint32_t *waitTime) ;
+
+  private:
+    static void onRegisters(const uint16_t *registers, uint8_t count, void *arg) ;
+
+    int model;
+    uint8_t slaveId;
+    uint16_t registers[2];
+    volatile uint32_t sequence; // Increase on every block received
+    uint32_t collected;
+};
@@ -0,0 +1,102 @@
+#include "SensorFilter.h"
+#include <string.h>
+
+SensorFilter::SensorFilter() {
+  config.medianWindow = 1;
+  config.emaAlpha = 1.0f;
+  config.maxRate = 0.0f;
+  reset();
+}
+
+void SensorFilter::setup(const SensorFilterConfig &newConfig) {
+  config = newConfig;
+  if (config.medianWindow < 1) {
+    config.medianWindow = 1;
+  } else if (config.medianWindow > SENSOR_FILTER_MAX_WINDOW) {
+    config.medianWindow = SENSOR_FILTER_MAX_WINDOW;
+  }
+  if ((config.emaAlpha <= 0.0f) || (config.emaAlpha > 1.0f)) {
+    config.emaAlpha = 1.0f;
+  }
+  reset();
+}
+
+void SensorFilter::reset() {
+  memset(window, 0, sizeof(window));
+  head = 0;
+  fill = 0;
+  ema = 0;
+  lastAccepted = 0;
+  lastTime = 0;
+  started = false;
+  rejectsInRow = 0;
+  rejectCount = 0;
+}
+
+float SensorFilter::median() const { // Insertion sort on a copy, window is small
+  float sorted[SENSOR_FILTER_MAX_WINDOW];
+  for (uint8_t i = 0; i < fill; i++) {
+    float value = window[i];
+    int8_t j = i - 1;
+    while ((j >= 0) && (sorted[j] > value)) {
+      sorted[j + 1] = sorted[j];
+      j--;
+    }
+    sorted[j + 1] = value;
+  }
+  if (fill % 2) {
+    return sorted[fill / 2];
+  }
+  return (sorted[(fill / 2) - 1] + sorted[fill / 2]) / 2.0f;
+}
+
+bool SensorFilter::update(float raw, uint32_t now, float *output) {
+  if (raw != raw) { // NAN
+    rejectCount++;
+    return false;
+  }
+
+  // Rate of change, compare with the last accepted raw value
+  if (started && (config.maxRate > 0.0f)) {
+    float dt = (now - lastTime) / 1000.0f;
+    if (dt < 0.001f) {
+      dt = 0.001f;
+    }
+    float rate = (raw - lastAccepted) / dt;
+    if (rate < 0) {
+      rate = -rate;
+    }
+    if ((rate > config.maxRate) && (rejectsInRow < SENSOR_FILTER_MAX_REJECTS)) {
+      rejectsInRow++;
+      rejectCount++;
+      return false;
+    }
+    if (rejectsInRow >= SENSOR_FILTER_MAX_REJECTS) { // Value really moved, start over from here
+      fill = 0;
+      head = 0;
+      started = false;
+    }
+  }
+  rejectsInRow = 0;
+  lastAccepted = raw;
+  lastTime = now;
+
+  // Median of N
+  window[head] = raw;
+  head = (head + 1) % config.medianWindow;
+  if (fill < config.medianWindow) {
+    fill++;
+  }
+  float value = median();
+
+  // EMA
+  if (!started) {
+    ema = value;
+    started = true;
+  } else {
+    ema += config.emaAlpha * (value - ema);
+  }
+
+  *output = ema;
+  return true;
+}
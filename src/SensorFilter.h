@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ===================================================================
+// Sensor filter pipeline: rate-of-change rejection -> median-of-N -> EMA
+// Fixed size ring buffer, no allocation, no Arduino dependency.
+// ===================================================================
+
+#define SENSOR_FILTER_MAX_WINDOW   9
+#define SENSOR_FILTER_MAX_REJECTS  3 // Accept the value after this many rejects in a row (real step change)
+
+typedef struct {
+  uint8_t medianWindow; // 1 = off
+  float emaAlpha;       // 0.0 - 1.0, 1.0 = off
+  float maxRate;        // unit per second, 0 = off
+} SensorFilterConfig;
+
+class SensorFilter {
+  public:
+    SensorFilter() ;
+
+    void setup(const SensorFilterConfig &config) ;
+    void reset() ;
+
+    /**
+     * @brief Feed one raw value
+     * @param now time of the value in ms
+     * @param output filtered value
+     * @return false if the value was rejected as an outlier
+     */
+    bool update(float raw, uint32_t now, float *output) ;
+
+    uint32_t getRejectCount() const { return rejectCount; }
+
+  private:
+    float median() const ;
+
+    SensorFilterConfig config;
+    float window[SENSOR_FILTER_MAX_WINDOW];
+    uint8_t head;
+    uint8_t fill;
+    float ema;
+    float lastAccepted;
+    uint32_t lastTime;
+    bool started;
+    uint8_t rejectsInRow;
+    uint32_t rejectCount;
+};
@@ -0,0 +1,210 @@
+#include "SensorRegistry.h"
+#include "UserConfigs.h"
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+static const char * TAG = "SensorRegistry";
+static portMUX_TYPE samplesMux = portMUX_INITIALIZER_UNLOCKED;
+#define SAMPLES_LOCK()    portENTER_CRITICAL(&samplesMux)
+#define SAMPLES_UNLOCK()  portEXIT_CRITICAL(&samplesMux)
+#else
+#define SAMPLES_LOCK()
+#define SAMPLES_UNLOCK()
+#define ESP_LOGI(tag, ...)
+#define ESP_LOGW(tag, ...)
+#endif
+
+SensorDriver * SensorRegistry::drivers[SENSOR_MAX_DRIVERS] = { };
+uint32_t SensorRegistry::deadline[SENSOR_MAX_DRIVERS] = { };
+bool SensorRegistry::pending[SENSOR_MAX_DRIVERS] = { };
+SensorSample SensorRegistry::samples[SENSOR_MAX_DRIVERS][SENSOR_CHANNEL_COUNT] = { };
+SensorFilter SensorRegistry::filters[SENSOR_MAX_DRIVERS][SENSOR_CHANNEL_COUNT];
+int SensorRegistry::driverCount = 0;
+int SensorRegistry::state = SensorRegistry::ACQ_TRIGGER;
+uint32_t SensorRegistry::cycleStart = 0;
+uint32_t SensorRegistry::cycleCount = 0;
+
+bool SensorRegistry::add(SensorDriver *driver) {
+  if ((!driver) || (driverCount >= SENSOR_MAX_DRIVERS)) {
+    return false;
+  }
+  if (!driver->begin()) {
+    return false;
+  }
+
+  static const SensorFilterConfig filterConfig[SENSOR_CHANNEL_COUNT] = {
+    SENSOR_FILTER_TEMP,
+    SENSOR_FILTER_HUMI,
+    SENSOR_FILTER_SOIL,
+    SENSOR_FILTER_LIGHT
+  };
+  for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+    filters[driverCount][ch].setup(filterConfig[ch]);
+  }
+
+  SAMPLES_LOCK();
+  memset(samples[driverCount], 0, sizeof(samples[driverCount]));
+  drivers[driverCount] = driver;
+  pending[driverCount] = false;
+  driverCount++;
+  SAMPLES_UNLOCK();
+
+  ESP_LOGI(TAG, "Driver %d: %s", driverCount - 1, driver->name());
+  return true;
+}
+
+int SensorRegistry::count() {
+  return driverCount;
+}
+
+SensorDriver * SensorRegistry::get(int index) {
+  if ((index < 0) || (index >= driverCount)) {
+    return NULL;
+  }
+  return drivers[index];
+}
+
+void SensorRegistry::clear() { // Drivers are owned by the caller
+  SAMPLES_LOCK();
+  driverCount = 0;
+  state = ACQ_TRIGGER;
+  cycleCount = 0;
+  SAMPLES_UNLOCK();
+}
+
+void SensorRegistry::publish(int index, const SensorReading *reading, uint32_t now) {
+  for (int ch = 0; ch < SENSOR_CHANNEL_COUNT; ch++) {
+    if (!(reading->mask & SENSOR_CH_MASK(ch))) {
+      continue;
+    }
+
+    float value;
+    if (!filters[index][ch].update(reading->value[ch], now, &value)) { // Outlier, keep the last sample
+      continue;
+    }
+
+    SAMPLES_LOCK();
+    samples[index][ch].value = value;
+    samples[index][ch].timestamp = now;
+    samples[index][ch].valid = true;
+    SAMPLES_UNLOCK();
+  }
+}
+
+uint32_t SensorRegistry::process(uint32_t now) {
+  uint32_t waitTime = 0;
+
+  switch (state) {
+    case ACQ_TRIGGER: // Start every conversion first, so their wait time overlap
+      cycleStart = now;
+      for (int i = 0; i < driverCount; i++) {
+        uint32_t wait = 0;
+        pending[i] = drivers[i]->trigger(&wait) != SENSOR_STEP_FAIL;
+        deadline[i] = now + wait;
+        if (!pending[i]) {
+          ESP_LOGW(TAG, "%s trigger fail", drivers[i]->name());
+        }
+      }
+      state = ACQ_COLLECT;
+      break;
+
+    case ACQ_COLLECT: { // Collect each driver when its conversion is due
+      bool anyPending = false;
+      uint32_t nextDue = 0xFFFFFFFF;
+      for (int i = 0; i < driverCount; i++) {
+        if (!pending[i]) {
+          continue;
+        }
+        if ((int32_t)(deadline[i] - now) > 0) {
+          anyPending = true;
+          if ((deadline[i] - now) < nextDue) {
+            nextDue = deadline[i] - now;
+          }
+          continue;
+        }
+
+        SensorReading reading;
+        memset(&reading, 0, sizeof(reading));
+        uint32_t wait = 0;
+        SensorStep step = drivers[i]->collect(&reading, &wait);
+        if (reading.mask) {
+          publish(i, &reading, now);
+        }
+        if (step == SENSOR_STEP_WAIT) { // Multi step driver (SHT2x)
+          deadline[i] = now + wait;
+          anyPending = true;
+          if (wait < nextDue) {
+            nextDue = wait;
+          }
+        } else {
+          pending[i] = false;
+        }
+      }
+
+      if (anyPending) {
+        waitTime = nextDue;
+      } else {
+        cycleCount++;
+        state = ACQ_IDLE;
+      }
+      break;
+    }
+
+    case ACQ_IDLE:
+    default: {
+      uint32_t elapsed = now - cycleStart;
+      if (elapsed < SENSOR_SAMPLE_INTERVAL) {
+        waitTime = SENSOR_SAMPLE_INTERVAL - elapsed;
+      }
+      state = ACQ_TRIGGER;
+      break;
+    }
+  }
+
+  return waitTime;
+}
+
+bool SensorRegistry::getInstanceSample(int index, SensorChannel ch, SensorSample *sample, uint32_t now) {
+  if ((index < 0) || (index >= driverCount) || (ch < 0) || (ch >= SENSOR_CHANNEL_COUNT) || (!sample)) {
+    return false;
+  }
+
+  SAMPLES_LOCK();
+  *sample = samples[index][ch];
+  SAMPLES_UNLOCK();
+
+  if (sample->valid && ((now - sample->timestamp) > SENSOR_SAMPLE_MAX_AGE)) {
+    sample->valid = false; // Sensor stop responding
+  }
+
+  return sample->valid;
+}
+
+bool SensorRegistry::getSample(SensorChannel ch, SensorSample *sample, uint32_t now) {
+  if ((ch < 0) || (ch >= SENSOR_CHANNEL_COUNT) || (!sample)) {
+    return false;
+  }
+
+  memset(sample, 0, sizeof(SensorSample));
+  for (int i = 0; i < driverCount; i++) {
+    if (!(drivers[i]->channels() & SENSOR_CH_MASK(ch))) {
+      continue;
+    }
+    if (getInstanceSample(i, ch, sample, now)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint32_t SensorRegistry::getCycleCount() {
+  return cycleCount;
+}
+
+uint32_t SensorRegistry::getRejectCount(int index, SensorChannel ch) {
+  if ((index < 0) || (index >= driverCount) || (ch < 0) || (ch >= SENSOR_CHANNEL_COUNT)) {
+    return 0;
+  }
+  return filters[index][ch].getRejectCount();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "SensorDriver.h"
+#include "SensorFilter.h"
+
+// ===================================================================
+// Sensor registry + acquisition scheduler
+// Hardware independent (no Arduino API) so the whole pipeline can run
+// on a host with mock drivers. Time is passed in by the caller.
+// ===================================================================
+
+#define SENSOR_MAX_DRIVERS      8
+#define SENSOR_SAMPLE_INTERVAL  1000  // ms, start a new acquisition cycle every 1 sec
+#define SENSOR_SAMPLE_MAX_AGE   10000 // ms, older samples are reported as not valid
+
+class SensorRegistry {
+  public:
+    static bool add(SensorDriver *driver); // Call begin() and keep the driver if found
+    static int count() ;
+    static SensorDriver * get(int index) ;
+    static void clear() ;
+
+    /**
+     * @brief Run the acquisition state machine
+     * @param now current time in ms
+     * @return ms until process() must be called again
+     */
+    static uint32_t process(uint32_t now) ;
+
+    // First valid instance that publish this channel
+    static bool getSample(SensorChannel ch, SensorSample *sample, uint32_t now) ;
+
+    // Sample of one driver instance
+    static bool getInstanceSample(int index, SensorChannel ch, SensorSample *sample, uint32_t now) ;
+
+    static uint32_t getCycleCount() ;
+    static uint32_t getRejectCount(int index, SensorChannel ch) ; // Values dropped by the filter
+
+  private:
+    enum {
+      ACQ_TRIGGER,
+      ACQ_COLLECT,
+      ACQ_IDLE
+    };
+
+    static void publish(int index, const SensorReading *reading, uint32_t now) ;
+
+    static SensorDriver *drivers[SENSOR_MAX_DRIVERS];
+    static uint32_t deadline[SENSOR_MAX_DRIVERS];
+    static bool pending[SENSOR_MAX_DRIVERS];
+    static SensorSample samples[SENSOR_MAX_DRIVERS][SENSOR_CHANNEL_COUNT];
+    static SensorFilter filters[SENSOR_MAX_DRIVERS][SENSOR_CHANNEL_COUNT];
+    static int driverCount;
+    static int state;
+    static uint32_t cycleStart;
+    static uint32_t cycleCount;
+};
@@ -1,5 +1,6 @@
 #include "SwitchApiClient.h"
 #include <esp_log.h>
+#include "HttpTransport.h"
 
 static const char* TAG = "SwitchAPI";
 
@@ -14,7 +15,7 @@ String SwitchApiClient::stateToString(int state) {
 }
 
 int SwitchApiClient::stringToState(const String& stateStr) {
-    return (stateStr == "on") ? 1 : 0;
+    return ApiPayload::stateFromString(stateStr.c_str());
 }
 
 int SwitchApiClient::sendRequest(const String& method, const String& endpoint, 
@@ -24,7 +25,6 @@ int SwitchApiClient::sendRequest(const String& method, const String& endpoint,
         return -1;
     }
 
-    HTTPClient http;
     String url = buildUrl(endpoint);
     
     ESP_LOGD(TAG, "Request: %s %s", method.c_str(), url.c_str());
@@ -32,38 +32,22 @@ int SwitchApiClient::sendRequest(const String& method, const String& endpoint,
         ESP_LOGV(TAG, "Payload: %s", payload.c_str());
     }
 
-    http.begin(url);
-    http.addHeader("Content-Type", "application/json");
-    http.addHeader("X-API-KEY", SWITCH_API_KEY);
-    http.setTimeout(5000); // 5 seconds timeout
-
-    int httpCode = -1;
-    
-    if (method == "GET") {
-        httpCode = http.GET();
-    } else if (method == "PUT") {
-        httpCode = http.PUT(payload);
-    } else if (method == "POST") {
-        httpCode = http.POST(payload);
-    } else if (method == "PATCH") {
-        httpCode = http.PATCH(payload);
-    }
+    int httpCode = HttpTransport::request(method.c_str(), url, SWITCH_API_KEY,
+                                          (method == "GET") ? NULL : payload.c_str(), response, 5000); // 5 seconds timeout
 
     if (httpCode > 0) {
         ESP_LOGD(TAG, "HTTP Response code: %d", httpCode);
         if (response) {
-            *response = http.getString();
             ESP_LOGV(TAG, "Response: %s", response->c_str());
         }
     } else {
-        ESP_LOGE(TAG, "HTTP Request failed: %s", http.errorToString(httpCode).c_str());
+        ESP_LOGE(TAG, "HTTP Request failed: %s", HTTPClient::errorToString(httpCode).c_str());
     }
 
-    http.end();
     return httpCode;
 }
 
-bool SwitchApiClient::getAllSwitchStates(int* states) {
+bool SwitchApiClient::getAllSwitchStates(int* states, uint32_t* versions) {
     if (!API_ENABLE_SWITCH || !states) {
         return false;
     }
@@ -72,33 +56,8 @@ bool SwitchApiClient::getAllSwitchStates(int* states) {
     int httpCode = sendRequest("GET", SWITCH_API_ENDPOINT, "", &response);
 
     if (httpCode == 200) {
-        DynamicJsonDocument doc(1024);
-        DeserializationError error = deserializeJson(doc, response);
-
-        if (error) {
-            ESP_LOGE(TAG, "JSON parsing failed: %s", error.c_str());
-            return false;
-        }
-
-        if (doc["success"] == true && doc["data"].is<JsonArray>()) {
-            JsonArray data = doc["data"].as<JsonArray>();
-            
-            // Parse all 4 switches
-            for (JsonObject item : data) {
-                int id = item["id"];
-                String state = item["state"];
-                
-                if (id >= 1 && id <= 4) {
-                    states[id - 1] = stringToState(state);
-                    ESP_LOGD(TAG, "Switch %d: %s", id, state.c_str());
-                }
-            }
-            
-            return true;
-        } else {
-            ESP_LOGW(TAG, "API returned success=false or invalid data");
-            return false;
-        }
+        // Parse all 4 switches
+        return ApiPayload::parseSwitchStates(response.c_str(), response.length(), states, versions, 4);
     } else if (httpCode == 401) {
         ESP_LOGE(TAG, "Unauthorized - Invalid API Key");
     }
@@ -115,38 +74,22 @@ bool SwitchApiClient::getSwitchState(int id, int* state) {
     String response;
     int httpCode = sendRequest("GET", endpoint, "", &response);
 
-    if (httpCode == 200) {
-        DynamicJsonDocument doc(512);
-        DeserializationError error = deserializeJson(doc, response);
-
-        if (error) {
-            ESP_LOGE(TAG, "JSON parsing failed: %s", error.c_str());
-            return false;
-        }
-
-        if (doc["success"] == true) {
-            String stateStr = doc["data"]["state"];
-            *state = stringToState(stateStr);
-            ESP_LOGD(TAG, "Switch %d state: %s", id, stateStr.c_str());
-            return true;
-        }
+    if (httpCode == 200 && ApiPayload::parseSwitchState(response.c_str(), response.length(), state)) {
+        ESP_LOGD(TAG, "Switch %d state: %s", id, stateToString(*state).c_str());
+        return true;
     }
 
     return false;
 }
 
-bool SwitchApiClient::updateSwitchState(int id, int state) {
+bool SwitchApiClient::updateSwitchState(int id, int state, uint32_t version, const char* origin, bool* conflict) {
     if (!API_ENABLE_SWITCH || id < 1 || id > 4) {
         return false;
     }
 
     // Build JSON payload
-    DynamicJsonDocument doc(128);
-    doc["id"] = id;
-    doc["state"] = stateToString(state);
-
-    String payload;
-    serializeJson(doc, payload);
+    char payload[128];
+    ApiPayload::buildSwitchState(id, state, version, origin, payload, sizeof(payload));
 
     // Send PUT request
     String endpoint = String(SWITCH_API_ENDPOINT) + "/" + String(id);
@@ -160,6 +103,12 @@ bool SwitchApiClient::updateSwitchState(int id, int state) {
         ESP_LOGW(TAG, "Bad Request - Invalid state or ID mismatch");
     } else if (httpCode == 404) {
         ESP_LOGW(TAG, "Switch ID %d not found", id);
+    } else if (httpCode == 409) {
+        // Server has a newer write (web / other device), the next poll apply it
+        ESP_LOGI(TAG, "Switch %d version %lu rejected, server is newer", id, (unsigned long) version);
+        if (conflict) {
+            *conflict = true;
+        }
     }
 
     return false;
@@ -209,7 +158,7 @@ void SwitchManager::update() {
         
         // Get current states from API
         int currentStates[4];
-        if (SwitchApiClient::getAllSwitchStates(currentStates)) {
+        if (SwitchApiClient::getAllSwitchStates(currentStates, NULL)) {
             // Check for changes
             for (int i = 0; i < 4; i++) {
                 if (previousStates[i] != currentStates[i]) {
@@ -236,7 +185,7 @@ bool SwitchManager::forceUpdate(int switchId, int state) {
         return false;
     }
 
-    if (SwitchApiClient::updateSwitchState(switchId, state)) {
+    if (SwitchApiClient::updateSwitchState(switchId, state, 0, NULL)) {
         previousStates[switchId - 1] = state;
         ESP_LOGI(TAG, "Force updated switch %d to %s", switchId, 
                  SwitchApiClient::stateToString(state).c_str());
@@ -248,7 +197,7 @@ bool SwitchManager::forceUpdate(int switchId, int state) {
 
 bool SwitchManager::syncFromAPI() {
     int states[4];
-    if (SwitchApiClient::getAllSwitchStates(states)) {
+    if (SwitchApiClient::getAllSwitchStates(states, NULL)) {
         for (int i = 0; i < 4; i++) {
             previousStates[i] = states[i];
         }
@@ -5,11 +5,12 @@
 #include <HTTPClient.h>
 #include <WiFi.h>
 #include <ArduinoJson.h>
+#include "ApiClient.h"
 
-// .NET Switch API Configuration
-#define SWITCH_API_BASE_URL     "http://203.159.93.240/minapi/v1"
+// .NET Switch API Configuration (same server as ApiClient)
+#define SWITCH_API_BASE_URL     DOTNET_BASE_URL
 #define SWITCH_API_ENDPOINT     "/api/switch"
-#define SWITCH_API_KEY          "DD5B523CF73EF3386DB2DE4A7AEDD"
+#define SWITCH_API_KEY          DOTNET_API_KEY
 
 // Enable/Disable Switch API
 #ifndef API_ENABLE_SWITCH
@@ -33,9 +34,10 @@ public:
     /**
      * @brief ดึงสถานะ Switch ทั้งหมด (4 ตัว)
      * @param states Array สำหรับเก็บสถานะ [4] (0=off, 1=on)
+     * @param versions Array สำหรับเก็บ version [4] (0 = server ไม่ส่ง version), NULL = ไม่ใช้
      * @return true ถ้าสำเร็จ, false ถ้าล้มเหลว
      */
-    static bool getAllSwitchStates(int* states);
+    static bool getAllSwitchStates(int* states, uint32_t* versions);
 
     /**
      * @brief ดึงสถานะ Switch เฉพาะ ID
@@ -49,9 +51,13 @@ public:
      * @brief อัปเดตสถานะ Switch
      * @param id Switch ID (1-4)
      * @param state สถานะที่ต้องการตั้ง (0=off, 1=on)
+     * @param version Version ของการเปลี่ยนแปลง (SwitchSync), 0 = ไม่ส่ง
+     * @param origin ที่มาของการเปลี่ยนแปลง เช่น "MQTT", "TIMER", NULL = ไม่ส่ง
+     * @param conflict ตั้งเป็น true ถ้า server ตอบ 409 (มี version ที่ใหม่กว่า ไม่ต้องส่งซ้ำ), NULL = ไม่ใช้
      * @return true ถ้าสำเร็จ, false ถ้าล้มเหลว
      */
-    static bool updateSwitchState(int id, int state);
+    static bool updateSwitchState(int id, int state, uint32_t version, const char* origin,
+                                  bool* conflict = NULL);
 
     /**
      * @brief แปลงสถานะจาก int เป็น string ("on"/"off")
@@ -0,0 +1,102 @@
+#include "SwitchSync.h"
+
+// true = keep dropping polls until the ack, false = give up on a lost ack
+static bool waitAck(SwitchSyncState *s)
+{
+    if (!s->pending)
+    {
+        return false;
+    }
+    if (++s->stale < SWITCH_SYNC_MAX_STALE)
+    {
+        return true;
+    }
+    s->pending = 0;
+    s->stale = 0;
+    return false;
+}
+
+uint32_t SwitchSync::change(SwitchSyncState *s, int state)
+{
+    s->version++;
+    s->state = state ? 1 : 0;
+    s->pending = s->version;
+    s->stale = 0;
+    return s->version;
+}
+
+SwitchSyncAction SwitchSync::remote(SwitchSyncState *s, int state, uint32_t version)
+{
+    state = state ? 1 : 0;
+
+    if (!s->known)
+    {
+        s->known = true;
+        if (version > s->version)
+        {
+            s->version = version;
+        }
+        if (state == s->state)
+        {
+            return SWITCH_SYNC_NONE;
+        }
+        change(s, s->state);
+        return SWITCH_SYNC_SEND;
+    }
+
+    if (version == 0) // Server without versions
+    {
+        if (waitAck(s))
+        {
+            return SWITCH_SYNC_STALE;
+        }
+        if (state == s->state)
+        {
+            return SWITCH_SYNC_NONE;
+        }
+        s->state = state;
+        return SWITCH_SYNC_APPLY;
+    }
+
+    if (version < s->version)
+    {
+        if (waitAck(s))
+        {
+            return SWITCH_SYNC_STALE;
+        }
+        s->pending = s->version; // Our PUT was lost, send the same version again
+        return SWITCH_SYNC_SEND;
+    }
+
+    s->version = version;
+    if (state == s->state)
+    {
+        return SWITCH_SYNC_NONE;
+    }
+    s->state = state;
+    return SWITCH_SYNC_APPLY;
+}
+
+void SwitchSync::ack(SwitchSyncState *s, uint32_t version)
+{
+    if (s->pending && version >= s->pending)
+    {
+        s->pending = 0;
+        s->stale = 0;
+    }
+}
+
+const char *SwitchSync::actionName(SwitchSyncAction action)
+{
+    switch (action)
+    {
+    case SWITCH_SYNC_STALE:
+        return "stale";
+    case SWITCH_SYNC_APPLY:
+        return "apply";
+    case SWITCH_SYNC_SEND:
+        return "send";
+    default:
+        return "none";
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ===================================================================
+// Versioned switch state shared by device and Switch API (no Arduino
+// dependency)
+// Every change (MQTT, automation, web) take the next version of that
+// switch and carry its origin. The higher version win on both sides;
+// on the same version the server answer win (it took another write
+// first). A poll older than what the device sent is an echo of a
+// write still in flight and is dropped, no extra round trip needed.
+// Server without versions (0 in the response): changes are applied
+// when no write is in flight.
+// A write whose ack never came (dropped job, worker stuck) stops
+// holding the polls after SWITCH_SYNC_MAX_STALE of them, resending the
+// same version is harmless.
+// ===================================================================
+
+#define SWITCH_SYNC_MAX_STALE   12  // Polls, above the worst ApiWorker job (token wait + PUT retry)
+
+struct SwitchSyncState {
+    uint32_t version;   // Of state, local or from the server
+    uint32_t pending;   // Version sent and not finished, 0 = none
+    int8_t state;       // 0 / 1
+    bool known;         // Server seen once since boot
+    uint8_t stale;      // Polls dropped while pending
+};
+
+enum SwitchSyncAction {
+    SWITCH_SYNC_NONE = 0,   // Same version / state
+    SWITCH_SYNC_STALE,      // Older than a write in flight, drop
+    SWITCH_SYNC_APPLY,      // Newer state from the server, set the relay
+    SWITCH_SYNC_SEND        // Server missed our state (boot, lost PUT), send state / version
+};
+
+class SwitchSync {
+public:
+    // Local change: next version, in flight until ack
+    static uint32_t change(SwitchSyncState* s, int state);
+
+    // State / version from GET /api/switch. First call after boot keep the device
+    // state (SEND with a version above the server) like the old power-on push
+    static SwitchSyncAction remote(SwitchSyncState* s, int state, uint32_t version);
+
+    // PUT of version finished (ok, conflict or error), the next poll settle the rest
+    static void ack(SwitchSyncState* s, uint32_t version);
+
+    static const char* actionName(SwitchSyncAction action);
+};
@@ -0,0 +1,213 @@
+#include "SystemHealth.h"
+#include <esp_heap_caps.h>
+
+static const char* TAG = "SystemHealth";
+
+static portMUX_TYPE healthMux = portMUX_INITIALIZER_UNLOCKED;
+
+SystemHealth::Task SystemHealth::tasks[SYSTEM_HEALTH_MAX_TASKS] = {};
+int SystemHealth::taskCount = 0;
+uint8_t SystemHealth::alerts = 0;
+uint32_t SystemHealth::lastUpdate = 0;
+SystemHealthAlertCallback SystemHealth::alertCallback = NULL;
+
+void SystemHealth::begin() {
+    registerTask(NULL, "loopTask", getArduinoLoopTaskStackSize());
+    lastUpdate = millis() - SYSTEM_HEALTH_INTERVAL; // First sample on next update()
+}
+
+bool SystemHealth::registerTask(TaskHandle_t handle, const char* name, uint32_t stackSize) {
+    if (!handle) {
+        handle = xTaskGetCurrentTaskHandle();
+    }
+
+    bool added = false;
+    portENTER_CRITICAL(&healthMux);
+    int index = -1;
+    for (int i = 0; i < taskCount; i++) {
+        if (strcmp(tasks[i].name, name) == 0) { // Short-lived task created again
+            index = i;
+            break;
+        }
+    }
+    if (index < 0 && taskCount < SYSTEM_HEALTH_MAX_TASKS) {
+        index = taskCount++;
+        tasks[index].name = name;
+        tasks[index].min_free = stackSize;
+    }
+    if (index >= 0) {
+        tasks[index].handle = handle;
+        tasks[index].stack_size = stackSize;
+        added = true;
+    }
+    portEXIT_CRITICAL(&healthMux);
+
+    if (!added) {
+        ESP_LOGW(TAG, "Task table full, %s not watched", name);
+    }
+    return added;
+}
+
+void SystemHealth::taskExiting() {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    portENTER_CRITICAL(&healthMux);
+    for (int i = 0; i < taskCount; i++) {
+        if (tasks[i].handle == self) {
+            sampleTask(tasks[i]);
+            tasks[i].handle = NULL;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&healthMux);
+}
+
+void SystemHealth::sampleTask(Task& task) { // Under healthMux, the handle can't be deleted while we look
+    if (!task.handle) {
+        return;
+    }
+    uint32_t free = uxTaskGetStackHighWaterMark(task.handle); // ESP-IDF return bytes, not words
+    if (free < task.min_free) {
+        task.min_free = free;
+    }
+}
+
+void SystemHealth::update() {
+    if (millis() - lastUpdate < SYSTEM_HEALTH_INTERVAL) {
+        return;
+    }
+    lastUpdate = millis();
+
+    portENTER_CRITICAL(&healthMux);
+    for (int i = 0; i < taskCount; i++) {
+        sampleTask(tasks[i]);
+    }
+    portEXIT_CRITICAL(&healthMux);
+
+    char message[128];
+    uint8_t now = checkLimits(message, sizeof(message));
+    uint8_t raised = now & ~alerts;
+    if (raised) {
+        ESP_LOGE(TAG, "Low memory: %s", message);
+        if (alertCallback) {
+            alertCallback(raised, message);
+        }
+    } else if (alerts & ~now) {
+        ESP_LOGI(TAG, "Memory back to normal (alerts 0x%02X -> 0x%02X)", alerts, now);
+    }
+    alerts = now;
+}
+
+uint8_t SystemHealth::checkLimits(char* message, size_t len) {
+    uint8_t result = 0;
+    size_t used = 0;
+    message[0] = '\0';
+
+    HeapStats heap;
+    getInternalHeap(&heap);
+    if (heap.free < SYSTEM_HEALTH_LOW_HEAP) {
+        result |= HEALTH_ALERT_LOW_HEAP;
+        used += snprintf(&message[used], len - used, "heap %lu ", (unsigned long) heap.free);
+    }
+    if (heap.largest_block < SYSTEM_HEALTH_LOW_BLOCK && used < len) {
+        result |= HEALTH_ALERT_LOW_BLOCK;
+        used += snprintf(&message[used], len - used, "block %lu ", (unsigned long) heap.largest_block);
+    }
+
+    getPsramHeap(&heap);
+    if (heap.total > 0 && heap.free < SYSTEM_HEALTH_LOW_PSRAM && used < len) {
+        result |= HEALTH_ALERT_LOW_PSRAM;
+        used += snprintf(&message[used], len - used, "psram %lu ", (unsigned long) heap.free);
+    }
+
+    for (int i = 0; i < taskCount && used < len; i++) {
+        if (tasks[i].min_free < SYSTEM_HEALTH_LOW_STACK) {
+            result |= HEALTH_ALERT_LOW_STACK;
+            used += snprintf(&message[used], len - used, "%s stack %lu/%lu ", tasks[i].name,
+                             (unsigned long) tasks[i].min_free, (unsigned long) tasks[i].stack_size);
+        }
+    }
+    return result;
+}
+
+void SystemHealth::onAlert(SystemHealthAlertCallback callback) {
+    alertCallback = callback;
+}
+
+void SystemHealth::getInternalHeap(HeapStats* stats) {
+    stats->free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    stats->largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    stats->min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    stats->total = heap_caps_get_total_size(MALLOC_CAP_INTERNAL);
+}
+
+void SystemHealth::getPsramHeap(HeapStats* stats) {
+    stats->total = heap_caps_get_total_size(MALLOC_CAP_SPIRAM);
+    if (stats->total == 0) {
+        stats->free = 0;
+        stats->largest_block = 0;
+        stats->min_free = 0;
+        return;
+    }
+    stats->free = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    stats->largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+    stats->min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM);
+}
+
+uint8_t SystemHealth::getAlerts() {
+    return alerts;
+}
+
+uint32_t SystemHealth::getMinStackFree() {
+    uint32_t result = 0xFFFFFFFF;
+    portENTER_CRITICAL(&healthMux);
+    for (int i = 0; i < taskCount; i++) {
+        if (tasks[i].min_free < result) {
+            result = tasks[i].min_free;
+        }
+    }
+    portEXIT_CRITICAL(&healthMux);
+    return result;
+}
+
+int SystemHealth::getTaskCount() {
+    return taskCount;
+}
+
+bool SystemHealth::getTaskStats(int index, TaskStackStats* stats) {
+    if (index < 0 || index >= taskCount || !stats) {
+        return false;
+    }
+
+    portENTER_CRITICAL(&healthMux);
+    stats->name = tasks[index].name;
+    stats->stack_size = tasks[index].stack_size;
+    stats->min_free = tasks[index].min_free;
+    stats->running = tasks[index].handle != NULL;
+    portEXIT_CRITICAL(&healthMux);
+    return true;
+}
+
+size_t SystemHealth::summaryJSON(char* output, size_t len) {
+    HeapStats heap, psram;
+    getInternalHeap(&heap);
+    getPsramHeap(&psram);
+
+    size_t used = snprintf(output, len,
+                           "{\"heap\":{\"free\":%lu,\"block\":%lu,\"min\":%lu,\"total\":%lu},"
+                           "\"psram\":{\"free\":%lu,\"block\":%lu,\"min\":%lu,\"total\":%lu},\"tasks\":{",
+                           (unsigned long) heap.free, (unsigned long) heap.largest_block,
+                           (unsigned long) heap.min_free, (unsigned long) heap.total,
+                           (unsigned long) psram.free, (unsigned long) psram.largest_block,
+                           (unsigned long) psram.min_free, (unsigned long) psram.total);
+    for (int i = 0; i < taskCount && used < len; i++) { // "name":[min free, stack size]
+        TaskStackStats task;
+        if (getTaskStats(i, &task)) {
+            used += snprintf(&output[used], len - used, "%s\"%s\":[%lu,%lu]", i ? "," : "", task.name,
+                             (unsigned long) task.min_free, (unsigned long) task.stack_size);
+        }
+    }
+    if (used < len) {
+        used += snprintf(&output[used], len - used, "},\"alerts\":%u}", alerts);
+    }
+    return (used < len) ? used : len - 1;
+}
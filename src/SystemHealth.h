@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ===================================================================
+// Heap / stack headroom monitor
+// Tasks register with their stack size, update() sample heap (internal
+// + PSRAM) and every stack high-water mark. A low-memory alert fires
+// once when a limit is crossed and again only after it recovered.
+// ===================================================================
+
+#define SYSTEM_HEALTH_INTERVAL          10000           // ms, sample period
+#define SYSTEM_HEALTH_MAX_TASKS         12
+#define SYSTEM_HEALTH_LOW_HEAP          (24 * 1024)     // Internal free heap, bytes
+#define SYSTEM_HEALTH_LOW_BLOCK         (8 * 1024)      // Internal largest free block, bytes
+#define SYSTEM_HEALTH_LOW_STACK         256             // Stack left in any task, bytes
+#define SYSTEM_HEALTH_LOW_PSRAM         (64 * 1024)     // PSRAM free heap (if fitted), bytes
+#define SYSTEM_HEALTH_MQTT_TOPIC        "@msg/diag/health"
+#define SYSTEM_HEALTH_SUMMARY_SIZE      1024
+
+enum SystemHealthAlert : uint8_t {
+    HEALTH_ALERT_LOW_HEAP   = (1 << 0),
+    HEALTH_ALERT_LOW_BLOCK  = (1 << 1),    // Fragmented, big allocation (TLS, JSON) will fail
+    HEALTH_ALERT_LOW_STACK  = (1 << 2),
+    HEALTH_ALERT_LOW_PSRAM  = (1 << 3),
+};
+
+struct HeapStats {
+    uint32_t free;          // bytes
+    uint32_t largest_block;
+    uint32_t min_free;      // Lowest since boot
+    uint32_t total;         // 0 = not available (no PSRAM)
+};
+
+struct TaskStackStats {
+    const char* name;
+    uint32_t stack_size;    // bytes
+    uint32_t min_free;      // Lowest high-water mark seen, bytes
+    bool running;
+};
+
+// Called from the loop that run update()
+typedef void (*SystemHealthAlertCallback)(uint8_t alerts, const char* message);
+
+class SystemHealth {
+public:
+    static void begin(); // Register the calling task (Arduino loopTask)
+
+    /**
+     * @brief Add a task to the stack watch list (same name = same slot)
+     * @param handle NULL = calling task
+     */
+    static bool registerTask(TaskHandle_t handle, const char* name, uint32_t stackSize);
+
+    // Call from a task right before vTaskDelete(NULL), keep its last watermark
+    static void taskExiting();
+
+    static void update(); // Sample when due, call from main loop
+    static void onAlert(SystemHealthAlertCallback callback);
+
+    static void getInternalHeap(HeapStats* stats);
+    static void getPsramHeap(HeapStats* stats);
+    static uint8_t getAlerts();
+    static uint32_t getMinStackFree(); // Lowest across every task
+    static int getTaskCount();
+    static bool getTaskStats(int index, TaskStackStats* stats);
+
+    static size_t summaryJSON(char* output, size_t len); // {"heap":{..},"psram":{..},"tasks":{"name":[free,size],..},"alerts":n}
+
+private:
+    struct Task {
+        TaskHandle_t handle;
+        const char* name;
+        uint32_t stack_size;
+        uint32_t min_free;
+    };
+
+    static void sampleTask(Task& task);
+    static uint8_t checkLimits(char* message, size_t len);
+
+    static Task tasks[SYSTEM_HEALTH_MAX_TASKS];
+    static int taskCount;
+    static uint8_t alerts;
+    static uint32_t lastUpdate;
+    static SystemHealthAlertCallback alertCallback;
+};
@@ -0,0 +1,125 @@
+#include "TimeService.h"
+#include "I2CBus.h"
+#include <sys/time.h>
+#include <esp_sntp.h>
+#include <esp_timer.h>
+
+static const char* TAG = "TimeService";
+
+ArtronShop_RTC* TimeService::rtc = NULL;
+TimeSyncCallback TimeService::syncCallback = NULL;
+bool TimeService::sntpStarted = false;
+volatile bool TimeService::synced = false;
+volatile bool TimeService::rtcWritePending = false;
+volatile uint32_t TimeService::lastSync = 0;
+uint32_t TimeService::lastRtcWrite = 0;
+bool TimeService::rtcWritten = false;
+
+void TimeService::begin(ArtronShop_RTC* rtcDevice) {
+    rtc = rtcDevice;
+
+    // Same TZ string as configTime() so localtime() is right before SNTP start
+    char tz[16];
+    long offset = -(TIME_GMT_OFFSET_SEC + TIME_DAYLIGHT_OFFSET_SEC);
+    snprintf(tz, sizeof(tz), "UTC%ld:%02ld", offset / 3600, labs(offset % 3600) / 60);
+    setenv("TZ", tz, 1);
+    tzset();
+
+    // RTC keep local time
+    struct tm info;
+    bool rtcValid = false;
+    if (rtc) {
+        I2CBusLock bus(rtc->getAddress());
+        rtcValid = bus.isLocked() && bus.check(rtc->read(&info)) && (info.tm_year + 1900) >= TIME_VALID_YEAR;
+    }
+    if (rtcValid) {
+        info.tm_isdst = -1;
+        struct timeval tv = { mktime(&info), 0 };
+        settimeofday(&tv, NULL);
+        ESP_LOGI(TAG, "Clock seeded from RTC: %04d-%02d-%02d %02d:%02d:%02d",
+                 info.tm_year + 1900, info.tm_mon + 1, info.tm_mday, info.tm_hour, info.tm_min, info.tm_sec);
+    } else {
+        ESP_LOGW(TAG, "RTC time not valid, wait for SNTP");
+    }
+}
+
+void TimeService::onNetworkConnected() {
+    if (sntpStarted) {
+        return; // lwIP keep resync by itself, reconnect must not restart it
+    }
+    sntpStarted = true;
+
+    sntp_set_sync_interval(TIME_SNTP_SYNC_INTERVAL);
+    sntp_set_time_sync_notification_cb(sntpCallback);
+    configTime(TIME_GMT_OFFSET_SEC, TIME_DAYLIGHT_OFFSET_SEC, TIME_NTP_SERVER_1, TIME_NTP_SERVER_2);
+    ESP_LOGI(TAG, "SNTP started, resync every %lu s", (unsigned long)(TIME_SNTP_SYNC_INTERVAL / 1000));
+}
+
+void TimeService::sntpCallback(struct timeval* tv) {
+    synced = true;
+    lastSync = millis();
+    rtcWritePending = true; // I2C is done later from loop()
+
+    if (syncCallback) {
+        syncCallback(tv->tv_sec);
+    }
+}
+
+void TimeService::loop() {
+    if (!rtcWritePending || !rtc) {
+        return;
+    }
+    if (rtcWritten && (millis() - lastRtcWrite) < TIME_RTC_DISCIPLINE_INTERVAL) {
+        return;
+    }
+
+    struct tm info;
+    if (!getLocalTime(&info)) {
+        return;
+    }
+    I2CBusLock bus(rtc->getAddress());
+    if (bus.isLocked() && bus.check(rtc->write(&info))) {
+        rtcWritten = true;
+        lastRtcWrite = millis();
+        rtcWritePending = false;
+        ESP_LOGI(TAG, "RTC updated from SNTP");
+    } else {
+        ESP_LOGW(TAG, "RTC write fail");
+    }
+}
+
+void TimeService::onSync(TimeSyncCallback callback) {
+    syncCallback = callback;
+}
+
+bool TimeService::isValid() {
+    time_t t = time(NULL);
+    struct tm info;
+    localtime_r(&t, &info);
+    return (info.tm_year + 1900) >= TIME_VALID_YEAR;
+}
+
+bool TimeService::isSynced() {
+    return synced;
+}
+
+time_t TimeService::now() {
+    return isValid() ? time(NULL) : 0;
+}
+
+bool TimeService::getLocalTime(struct tm* info) {
+    time_t t = time(NULL);
+    localtime_r(&t, info);
+    return (info->tm_year + 1900) >= TIME_VALID_YEAR;
+}
+
+uint64_t TimeService::monotonicMs() {
+    return esp_timer_get_time() / 1000ULL;
+}
+
+uint32_t TimeService::getLastSyncAge() {
+    if (!synced) {
+        return 0xFFFFFFFF;
+    }
+    return millis() - lastSync;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Arduino.h>
+#include <time.h>
+#include "ArtronShop_RTC.h"
+
+// ===================================================================
+// Time service
+// - System clock seeded from RTC at boot, served from RAM after that
+// - SNTP started once on connect, then resync by lwIP every interval
+// - RTC written back after a sync, at most once per discipline interval
+// ===================================================================
+
+#define TIME_NTP_SERVER_1               "pool.ntp.org"
+#define TIME_NTP_SERVER_2               "time.nist.gov"
+#define TIME_GMT_OFFSET_SEC             (7 * 3600)
+#define TIME_DAYLIGHT_OFFSET_SEC        0
+#define TIME_SNTP_SYNC_INTERVAL         (6UL * 3600UL * 1000UL) // ms
+#define TIME_RTC_DISCIPLINE_INTERVAL    (3600UL * 1000UL)       // ms, min time between RTC write
+#define TIME_VALID_YEAR                 2024                    // Older is "not set"
+
+// Called from the SNTP (lwIP) task, keep it short
+typedef void (*TimeSyncCallback)(time_t now);
+
+class TimeService {
+public:
+    static void begin(ArtronShop_RTC* rtc); // Seed system clock from RTC
+    static void onNetworkConnected();       // Start SNTP (only the first call do anything)
+    static void loop();                     // Write RTC when due, call from main loop
+
+    static void onSync(TimeSyncCallback callback);
+
+    static bool isValid();                       // Wall clock can be trusted (RTC or SNTP)
+    static bool isSynced();                      // SNTP sync at least once
+    static time_t now();                         // Wall clock, 0 if not valid
+    static bool getLocalTime(struct tm* info);   // Never wait (unlike Arduino getLocalTime)
+    static uint64_t monotonicMs();               // Since boot, never jump
+    static uint32_t getLastSyncAge();            // ms since last SNTP sync, 0xFFFFFFFF if never
+
+private:
+    static void sntpCallback(struct timeval* tv);
+
+    static ArtronShop_RTC* rtc;
+    static TimeSyncCallback syncCallback;
+    static bool sntpStarted;
+    static volatile bool synced;
+    static volatile bool rtcWritePending;
+    static volatile uint32_t lastSync;
+    static uint32_t lastRtcWrite;
+    static bool rtcWritten;
+};
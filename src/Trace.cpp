@@ -0,0 +1,113 @@
+#include "Trace.h"
+
+#if TRACE_ENABLE
+
+#include <esp_heap_caps.h>
+
+static const char* TAG = "Trace";
+
+static portMUX_TYPE traceMux = portMUX_INITIALIZER_UNLOCKED;
+
+Trace::Event* Trace::events = NULL;
+uint32_t Trace::capacity = 0;
+uint32_t Trace::written = 0;
+volatile bool Trace::paused = false;
+char Trace::threadNames[TRACE_MAX_THREADS][configMAX_TASK_NAME_LEN] = {};
+TaskHandle_t Trace::threadHandles[TRACE_MAX_THREADS] = {};
+uint8_t Trace::threadCount = 0;
+
+bool Trace::begin() {
+    if (events) {
+        return true;
+    }
+
+    capacity = TRACE_BUFFER_EVENTS;
+    events = (Event*)heap_caps_malloc(capacity * sizeof(Event), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!events) {
+        capacity = TRACE_BUFFER_EVENTS_INTERNAL;
+        events = (Event*)heap_caps_malloc(capacity * sizeof(Event), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (!events) {
+        capacity = 0;
+        ESP_LOGE(TAG, "No memory for trace buffer");
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Trace started, %lu events", (unsigned long)capacity);
+    return true;
+}
+
+uint8_t Trace::threadIndex() { // Under traceMux
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (uint8_t i = 0; i < threadCount; i++) {
+        if (threadHandles[i] == self) {
+            return i;
+        }
+    }
+    if (threadCount >= TRACE_MAX_THREADS) {
+        return TRACE_MAX_THREADS - 1; // Share the last one
+    }
+    threadHandles[threadCount] = self;
+    strncpy(threadNames[threadCount], pcTaskGetTaskName(NULL), configMAX_TASK_NAME_LEN - 1); // Copy, the task may be deleted before dump
+    return threadCount++;
+}
+
+void Trace::record(const char* name, TracePhase phase, int32_t arg) {
+    if (!events || paused) {
+        return;
+    }
+
+    uint32_t now = micros();
+    portENTER_CRITICAL(&traceMux);
+    Event& event = events[written % capacity];
+    event.name = name;
+    event.ts = now;
+    event.arg = arg;
+    event.phase = phase;
+    event.thread = threadIndex();
+    written++;
+    portEXIT_CRITICAL(&traceMux);
+}
+
+void Trace::dump(Print& output) {
+    if (!events) {
+        output.println("{\"traceEvents\":[]}");
+        return;
+    }
+
+    paused = true;
+    uint32_t first = (written > capacity) ? (written - capacity) : 0;
+
+    output.print("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (uint8_t i = 0; i < threadCount; i++) {
+        output.printf("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                      i ? "," : "", i, threadNames[i]);
+    }
+
+    uint64_t base = 0; // micros() wrap every ~71 min
+    uint32_t last = (first < written) ? events[first % capacity].ts : 0;
+    for (uint32_t n = first; n < written; n++) {
+        const Event& event = events[n % capacity];
+        if (event.ts < last && (last - event.ts) > 0x80000000UL) {
+            base += 0x100000000ULL;
+        }
+        last = event.ts;
+
+        output.printf(",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu,\"pid\":1,\"tid\":%u", event.name, event.phase,
+                      (unsigned long long)(base + event.ts), event.thread);
+        if (event.phase == TRACE_PH_INSTANT) {
+            output.printf(",\"s\":\"t\",\"args\":{\"v\":%ld}", (long)event.arg);
+        }
+        output.print("}");
+    }
+    output.println("]}");
+    paused = false;
+}
+
+void Trace::clear() {
+    portENTER_CRITICAL(&traceMux);
+    written = 0;
+    portEXIT_CRITICAL(&traceMux);
+}
+
+#endif
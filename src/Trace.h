@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Arduino.h>
+
+// ===================================================================
+// Event trace (build with -DTRACE_ENABLE=1, on in [env:debug])
+// begin / end / instant events with a us timestamp go into a fixed
+// ring buffer (PSRAM if any), oldest overwritten. Trace::dump() write
+// Chrome trace JSON, open it in chrome://tracing or ui.perfetto.dev.
+// With TRACE_ENABLE 0 every macro is empty and Trace.cpp is empty.
+// ===================================================================
+
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE 0
+#endif
+
+#define TRACE_BUFFER_EVENTS             4096 // PSRAM, 16 byte each
+#define TRACE_BUFFER_EVENTS_INTERNAL    512  // No PSRAM
+#define TRACE_MAX_THREADS               16
+
+#if TRACE_ENABLE
+
+enum TracePhase : uint8_t {
+    TRACE_PH_BEGIN = 'B',
+    TRACE_PH_END = 'E',
+    TRACE_PH_INSTANT = 'i',
+};
+
+class Trace {
+public:
+    static bool begin();
+    static void record(const char* name, TracePhase phase, int32_t arg); // name must be a literal
+    static void dump(Print& output); // Chrome trace JSON, recording pause while writing
+    static void clear();
+
+private:
+    struct Event {
+        const char* name;
+        uint32_t ts;    // micros()
+        int32_t arg;
+        uint8_t phase;
+        uint8_t thread; // Index in threadNames
+    };
+
+    static uint8_t threadIndex();
+
+    static Event* events;
+    static uint32_t capacity;
+    static uint32_t written; // Total since clear, index = written % capacity
+    static volatile bool paused;
+    static char threadNames[TRACE_MAX_THREADS][configMAX_TASK_NAME_LEN];
+    static TaskHandle_t threadHandles[TRACE_MAX_THREADS];
+    static uint8_t threadCount;
+};
+
+class TraceScope {
+public:
+    TraceScope(const char* name) : name(name) { Trace::record(name, TRACE_PH_BEGIN, 0); }
+    ~TraceScope() { Trace::record(name, TRACE_PH_END, 0); }
+
+private:
+    const char* name;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_BEGIN(name)           Trace::record(name, TRACE_PH_BEGIN, 0)
+#define TRACE_END(name)             Trace::record(name, TRACE_PH_END, 0)
+#define TRACE_INSTANT(name, arg)    Trace::record(name, TRACE_PH_INSTANT, arg)
+#define TRACE_SCOPE(name)           TraceScope TRACE_CONCAT(_traceScope, __LINE__)(name)
+
+#else
+
+#define TRACE_BEGIN(name)           do { } while (0)
+#define TRACE_END(name)             do { } while (0)
+#define TRACE_INSTANT(name, arg)    do { } while (0)
+#define TRACE_SCOPE(name)           do { } while (0)
+
+#endif
@@ -3,9 +3,11 @@
 #include <ATD3.5-S3.h>
 #include "gui/ui.h"
 #include <WiFi.h>
-#include <PubSubClient.h>
 #include "UI.h"
 #include "HandySense.h"
+#include "Perf.h"
+#include "SystemHealth.h"
+#include "Trace.h"
 #include <PinConfigs.h>
 
 static const char * TAG = "UI";
@@ -15,6 +17,7 @@ static void o_switch_click_handle(lv_event_t * e) {
   int ch = (int) lv_event_get_user_data(e);
   bool value = lv_obj_has_state(target, LV_STATE_CHECKED);
 
+  // Relay GPIO + widget change right here, Switch API / log HTTP calls are queued to ApiWorker
   extern void ControlRelay_Bymanual(String topic, String message, unsigned int length);
   ControlRelay_Bymanual(String("@private/led") + String(ch - 1), value ? "on" : "off", 0);
 }
@@ -23,12 +26,16 @@ static bool wait_wifi_scan = false;
 static bool scan_finch = false;
 static int scan_found = 0;
 
+#define WIFI_SCAN_TASK_STACK_SIZE (2 * 1024)
+
 void wifi_scan_task(void *) {
+  SystemHealth::registerTask(NULL, "WiFiScanTask", WIFI_SCAN_TASK_STACK_SIZE);
   WiFi.mode(WIFI_STA);
   WiFi.disconnect();
   delay(100);
   scan_found = WiFi.scanNetworks();
   scan_finch = true;
+  SystemHealth::taskExiting();
   vTaskDelete(NULL);
 }
 
@@ -41,7 +48,7 @@ static void wifi_refresh_click_handle(lv_event_t * e) {
   xTaskHandle wifi_scan_task_handle;
   static int n = 0;
   scan_finch = false;
-  xTaskCreate(wifi_scan_task, "WiFiScanTask", 2 * 1024, &n, 10, &wifi_scan_task_handle);
+  xTaskCreate(wifi_scan_task, "WiFiScanTask", WIFI_SCAN_TASK_STACK_SIZE, &n, 10, &wifi_scan_task_handle);
   wait_wifi_scan = true;
 }
 
@@ -369,7 +376,12 @@ void UI_init() {
 }
 
 void UI_loop() {
-  Display.loop();
+  PERF_SCOPE("ui.loop");
+  {
+    PERF_SCOPE("ui.lvgl");
+    TRACE_SCOPE("lvgl.refresh");
+    Display.loop();
+  }
 
   // Time
   extern struct tm timeinfo;
@@ -380,8 +392,7 @@ void UI_loop() {
     lv_obj_clear_flag(ui_wifi_status_icon, LV_OBJ_FLAG_HIDDEN);
 
     // Update cloud status
-    extern PubSubClient client;
-    if (client.connected()) {
+    if (HandySense_mqttConnected()) {
       lv_obj_clear_flag(ui_cloud_status_icon, LV_OBJ_FLAG_HIDDEN);
     } else {
       static unsigned long timer = 0;
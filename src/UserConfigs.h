@@ -2,29 +2,26 @@
 #include "SensorSupport.h"
 
 // Configs use Sensor
-#define TEMP_HUMID_SENSOR SHT45 // <<--- Select your temp & humid sensor model
-#define SOIL_SENSOR       ANALOG_SOIL_SENSOR // <<--- Select your soil sensor model
-#define LIGHT_SENSOR      BH1750 // <<--- Select your light (lux) sensor model
+// I2C sensors (SHT20, SHT30, SHT45, BH1750) are found automatically at boot, see SensorDrivers.cpp
 
-
-#if TEMP_HUMID_SENSOR == SHT30
-#define SHT30_ADDR (0x44) // ADDR pin jump to GND => 0x44, ADDR pin jump to VCC => 0x45
-#elif TEMP_HUMID_SENSOR == SHT45
-#define SHT45_ADDR (0x44) // SHT45-AD1B => 0x44
-#elif TEMP_HUMID_SENSOR == ATS_TH
-#define ATS_TH_ID  (1)
-#elif TEMP_HUMID_SENSOR == XY_MD02
-#define XY_MD02_ID  (1)
-#endif
-
-#if SOIL_SENSOR == ANALOG_SOIL_SENSOR
-#define SOIL_PIN        A1_PIN
+// Analog soil sensor, one driver per pin (A1_PIN, A2_PIN)
+#define SOIL_PINS       { A1_PIN } // 2 probes => { A1_PIN, A2_PIN }
 #define SOIL_ANALOG_MIN (2900)
 #define SOIL_ANALOG_MAX (1500)
-#endif
 
-#if LIGHT_SENSOR == BH1750
-#define BH1750_ADDR (0x23) // ADDR pin jump to GND => 0x23, ADDR pin jump to VCC => 0x5C
-#elif LIGHT_SENSOR == ATS_LUX
-#define ATS_LUX_ID  (1)
-#endif
+// Flow meter (water_delta_l), one PCNT unit per pin (D1_PIN - D3_PIN)
+#define FLOW_METER_PINS       { D1_PIN }
+#define FLOW_PULSES_PER_LITER (450.0f) // YF-S201 : F = 7.5 * Q (L/min) => 450 pulses/L
+
+// Sensor filter { median window (1 = off), EMA alpha (1.0 = off), max change per second (0 = off) }
+#define SENSOR_FILTER_TEMP  { 3, 0.5f, 2.0f }   // °C
+#define SENSOR_FILTER_HUMI  { 3, 0.5f, 10.0f }  // %RH
+#define SENSOR_FILTER_SOIL  { 5, 0.3f, 20.0f }  // %, one noisy ADC sample must not switch the pump
+#define SENSOR_FILTER_LIGHT { 3, 1.0f, 0.0f }   // lux, cloud / shade change it fast
+
+// RS485 sensors can't be identified by probing, list every expected node here as { model, slave id },
+// nodes that do not answer at boot are skipped
+#define MODBUS_SENSOR_LIST \
+  /* { ATS_TH,  1 }, */ \
+  /* { XY_MD02, 1 }, */ \
+  /* { ATS_LUX, 2 }, */
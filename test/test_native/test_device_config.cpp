@@ -0,0 +1,125 @@
+#include <unity.h>
+#include <string.h>
+#include "DeviceConfig.h"
+
+static DeviceConfigFields validFields() {
+  DeviceConfigFields fields;
+  fields.server = "mqtt.netpie.io";
+  fields.client = "3b1c7d0e-5a2f-4d7e-9c1a-0f6e2b8d4a11";
+  fields.user = "token";
+  fields.pass = "secret";
+  fields.ssid = "farm-ap";
+  fields.password = "12345678";
+  fields.port = 1883;
+  return fields;
+}
+
+static DeviceConfigResult readAndCheck(const char *json) {
+  StaticJsonDocument<512> doc;
+  TEST_ASSERT_TRUE(deserializeJson(doc, json) == DeserializationError::Ok);
+  DeviceConfigFields fields;
+  DeviceConfig::read(doc.as<JsonVariantConst>(), &fields);
+  return DeviceConfig::check(&fields);
+}
+
+static void test_config_valid() {
+  DeviceConfigFields fields = validFields();
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_OK, DeviceConfig::check(&fields));
+
+  // ssid / password / user / pass are optional
+  fields.user = NULL;
+  fields.pass = NULL;
+  fields.ssid = NULL;
+  fields.password = NULL;
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_OK, DeviceConfig::check(&fields));
+}
+
+static void test_config_command_is_not_a_config() {
+  DeviceConfigFields fields = validFields();
+  fields.client = NULL;
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_NONE, DeviceConfig::check(&fields));
+}
+
+static void test_config_required_fields() {
+  DeviceConfigFields fields = validFields();
+  fields.client = "";
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_BAD_CLIENT, DeviceConfig::check(&fields));
+
+  fields = validFields();
+  fields.server = NULL;
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_BAD_SERVER, DeviceConfig::check(&fields));
+  fields.server = "";
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_BAD_SERVER, DeviceConfig::check(&fields));
+}
+
+static void test_config_port_range() {
+  DeviceConfigFields fields = validFields();
+  long bad[] = {-1, 0, 65536, 100000};
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+    fields.port = bad[i];
+    TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_BAD_PORT, DeviceConfig::check(&fields));
+  }
+  fields.port = 1;
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_OK, DeviceConfig::check(&fields));
+  fields.port = 65535;
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_OK, DeviceConfig::check(&fields));
+}
+
+static void test_config_field_lengths() {
+  char longest[DEVICE_CONFIG_FIELD_MAX + 2];
+  memset(longest, 'a', sizeof(longest) - 1);
+  longest[sizeof(longest) - 1] = '\0';
+
+  DeviceConfigFields fields = validFields();
+  longest[DEVICE_CONFIG_FIELD_MAX] = '\0';
+  fields.client = longest; // At the limit
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_OK, DeviceConfig::check(&fields));
+  longest[DEVICE_CONFIG_FIELD_MAX] = 'a';
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_BAD_CLIENT, DeviceConfig::check(&fields));
+
+  fields = validFields();
+  fields.pass = longest;
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_BAD_CREDENTIALS, DeviceConfig::check(&fields));
+
+  fields = validFields();
+  longest[DEVICE_CONFIG_SSID_MAX + 1] = '\0';
+  fields.ssid = longest;
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_BAD_SSID, DeviceConfig::check(&fields));
+  longest[DEVICE_CONFIG_SSID_MAX] = '\0';
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_OK, DeviceConfig::check(&fields));
+
+  fields = validFields();
+  memset(longest, 'b', DEVICE_CONFIG_PASSWORD_MAX + 1);
+  longest[DEVICE_CONFIG_PASSWORD_MAX + 1] = '\0';
+  fields.password = longest;
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_BAD_PASSWORD, DeviceConfig::check(&fields));
+}
+
+static void test_config_read_json() {
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_OK, readAndCheck(
+    "{\"server\":\"mqtt.netpie.io\",\"port\":1883,\"client\":\"c\",\"user\":\"u\",\"pass\":\"p\","
+    "\"ssid\":\"farm-ap\",\"password\":\"12345678\"}"));
+  // Older installer send the port as a string
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_OK, readAndCheck(
+    "{\"server\":\"mqtt.netpie.io\",\"port\":\"1883\",\"client\":\"c\"}"));
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_BAD_PORT, readAndCheck(
+    "{\"server\":\"mqtt.netpie.io\",\"port\":\"18x3\",\"client\":\"c\"}"));
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_BAD_PORT, readAndCheck(
+    "{\"server\":\"mqtt.netpie.io\",\"client\":\"c\"}"));
+  TEST_ASSERT_EQUAL_INT(DEVICE_CONFIG_NONE, readAndCheck("{\"command\":\"restart\"}"));
+}
+
+static void test_config_result_name() {
+  TEST_ASSERT_EQUAL_STRING("ok", DeviceConfig::resultName(DEVICE_CONFIG_OK));
+  TEST_ASSERT_EQUAL_STRING("bad port", DeviceConfig::resultName(DEVICE_CONFIG_BAD_PORT));
+}
+
+void run_device_config_tests() {
+  RUN_TEST(test_config_valid);
+  RUN_TEST(test_config_command_is_not_a_config);
+  RUN_TEST(test_config_required_fields);
+  RUN_TEST(test_config_port_range);
+  RUN_TEST(test_config_field_lengths);
+  RUN_TEST(test_config_read_json);
+  RUN_TEST(test_config_result_name);
+}
@@ -0,0 +1,97 @@
+#include <unity.h>
+#include "FlowCounter.h"
+
+#define PCNT_LIMIT 10000 // FLOW_PCNT_HIGH_LIMIT
+
+static void test_flow_pcnt_overflows_accumulate() {
+  TEST_ASSERT_EQUAL_UINT32(1234, FlowCounter::fromPcnt(0, 1234, PCNT_LIMIT));
+  TEST_ASSERT_EQUAL_UINT32(30000, FlowCounter::fromPcnt(3, 0, PCNT_LIMIT));
+  TEST_ASSERT_EQUAL_UINT32(39999, FlowCounter::fromPcnt(3, 9999, PCNT_LIMIT));
+  // Past what the 16 bit counter alone can hold
+  TEST_ASSERT_EQUAL_UINT32(700000 + 5, FlowCounter::fromPcnt(70, 5, PCNT_LIMIT));
+}
+
+static void test_flow_pcnt_wrap_between_reads() {
+  FlowCounter counter;
+  counter.update(FlowCounter::fromPcnt(0, 9990, PCNT_LIMIT));
+  counter.commit(counter.getDeltaPulses());
+  counter.update(FlowCounter::fromPcnt(1, 20, PCNT_LIMIT)); // Counter reset to 0 at the limit
+  TEST_ASSERT_EQUAL_UINT32(30, counter.getDeltaPulses());
+}
+
+static void test_flow_total_only_goes_up() {
+  FlowCounter counter;
+  counter.update(500);
+  counter.update(400); // Older read, ignored
+  TEST_ASSERT_EQUAL_UINT32(500, counter.getTotalPulses());
+  counter.update(500);
+  TEST_ASSERT_EQUAL_UINT32(500, counter.getTotalPulses());
+}
+
+static void test_flow_total_wraps_32_bit() {
+  FlowCounter counter;
+  // Get near the top in steps below 2^31, a bigger jump is read as going back
+  for (uint32_t total = 0x40000000; total != 0; total += 0x40000000) {
+    counter.update(total);
+  }
+  counter.update(0xFFFFFF00);
+  counter.commit(counter.getDeltaPulses());
+  counter.update(0x00000100); // Wrapped, 0x200 pulses later
+  TEST_ASSERT_EQUAL_UINT32(0x100, counter.getTotalPulses());
+  TEST_ASSERT_EQUAL_UINT32(0x200, counter.getDeltaPulses());
+}
+
+static void test_flow_delta_read_then_commit() {
+  FlowCounter counter;
+  counter.update(900);
+  uint32_t delta = counter.getDeltaPulses();
+  TEST_ASSERT_EQUAL_UINT32(900, delta);
+  TEST_ASSERT_EQUAL_UINT32(900, counter.getDeltaPulses()); // Reading doesn't consume
+
+  counter.update(1350); // Pulses while the upload was in flight
+  counter.commit(delta);
+  TEST_ASSERT_EQUAL_UINT32(450, counter.getDeltaPulses());
+}
+
+static void test_flow_failed_upload_is_sent_again() {
+  FlowCounter counter;
+  counter.update(450);
+  counter.getDeltaPulses(); // Upload failed, not committed
+  counter.update(900);
+  TEST_ASSERT_EQUAL_UINT32(900, counter.getDeltaPulses());
+  counter.commit(counter.getDeltaPulses());
+  TEST_ASSERT_EQUAL_UINT32(0, counter.getDeltaPulses());
+}
+
+static void test_flow_pulses_per_liter_conversion() {
+  FlowCounter counter(450.0f);
+  counter.update(900);
+  TEST_ASSERT_FLOAT_WITHIN(0.0001f, 2.0f, counter.getTotalLiters());
+  TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.5f, counter.toLiters(225));
+
+  counter.setPulsesPerLiter(98.0f); // YF-B6 : F = 6.6 * Q, rounded
+  TEST_ASSERT_FLOAT_WITHIN(0.0001f, 900.0f / 98.0f, counter.getTotalLiters());
+}
+
+static void test_flow_zero_pulses_per_liter_keeps_default() {
+  FlowCounter unconfigured(0.0f);
+  TEST_ASSERT_EQUAL_FLOAT(FLOW_COUNTER_DEFAULT_PULSES_PER_LITER, unconfigured.getPulsesPerLiter());
+  unconfigured.update(450);
+  TEST_ASSERT_FLOAT_WITHIN(0.0001f, 1.0f, unconfigured.getTotalLiters());
+
+  FlowCounter counter(300.0f);
+  counter.setPulsesPerLiter(0.0f);
+  counter.setPulsesPerLiter(-5.0f);
+  TEST_ASSERT_EQUAL_FLOAT(300.0f, counter.getPulsesPerLiter());
+}
+
+void run_flow_counter_tests() {
+  RUN_TEST(test_flow_pcnt_overflows_accumulate);
+  RUN_TEST(test_flow_pcnt_wrap_between_reads);
+  RUN_TEST(test_flow_total_only_goes_up);
+  RUN_TEST(test_flow_total_wraps_32_bit);
+  RUN_TEST(test_flow_delta_read_then_commit);
+  RUN_TEST(test_flow_failed_upload_is_sent_again);
+  RUN_TEST(test_flow_pulses_per_liter_conversion);
+  RUN_TEST(test_flow_zero_pulses_per_liter_keeps_default);
+}
@@ -0,0 +1,36 @@
+// ===================================================================
+// Host unit tests of the Arduino free modules, [env:native]
+//   pio test -e native
+// One runner, each test_*.cpp register its cases with a run_*() below.
+// ===================================================================
+#include <unity.h>
+#include <Arduino.h>
+#include "SensorRegistry.h"
+
+void run_schedule_tests();
+void run_payload_tests();
+void run_device_config_tests();
+void run_switch_sync_tests();
+void run_sensor_filter_tests();
+void run_sensor_registry_tests();
+void run_flow_counter_tests();
+
+void setUp() {
+  NativeHal_setMillis(0);
+}
+
+void tearDown() {
+  SensorRegistry::clear(); // Drivers are locals of the test
+}
+
+int main() {
+  UNITY_BEGIN();
+  run_schedule_tests();
+  run_payload_tests();
+  run_device_config_tests();
+  run_switch_sync_tests();
+  run_sensor_filter_tests();
+  run_sensor_registry_tests();
+  run_flow_counter_tests();
+  return UNITY_END();
+}
@@ -0,0 +1,302 @@
+#include <unity.h>
+#include <string.h>
+#include "ApiPayload.h"
+
+static const char SWITCH_LIST_JSON[] =
+  "{\"success\":true,\"data\":["
+  "{\"id\":1,\"name\":\"Switch 1\",\"state\":\"on\",\"version\":412,\"origin\":\"web\"},"
+  "{\"id\":2,\"name\":\"Switch 2\",\"state\":\"off\",\"version\":87},"
+  "{\"id\":4,\"name\":\"Switch 4\",\"state\":\"on\"},"
+  "{\"id\":9,\"name\":\"Switch 9\",\"state\":\"on\",\"version\":5}]}";
+
+static const char SYNC_JSON[] =
+  "{\"success\":true,\"data\":{\"syncToken\":\"7f3c2a91e4b05d68\","
+  "\"intervals\":{\"switchPoll\":5,\"sync\":0,\"telemetry\":\"fast\"},"
+  "\"timers\":["
+  "{\"relayId\":1,\"timerId\":2,\"enabled\":true,\"days\":[1,0,1,0,1,0,0],\"timeOn\":\"07:30:00\",\"timeOff\":\"19:00:00\"},"
+  "{\"relayId\":0,\"timerId\":0,\"enabled\":false,\"days\":[1,1,1,1,1,1,1],\"timeOn\":\"50:00:00\",\"timeOff\":\"50:00:00\"},"
+  "{\"relayId\":3,\"timerId\":1,\"enabled\":true,\"days\":[0,0,0,0,0,1,1],\"timeOn\":\"12:00:00\",\"timeOff\":\"12:15:00\"}],"
+  "\"sensors\":["
+  "{\"relayId\":2,\"sensorType\":\"temperature\",\"enabled\":true,\"controlMode\":\"max_trigger\","
+  "\"minValue\":20,\"maxValue\":30.5,\"actionOnTrigger\":\"Turn-Off\"},"
+  "{\"relayId\":1,\"sensorType\":\"soil\",\"enabled\":true,\"controlMode\":\"min_trigger\","
+  "\"minValue\":40,\"maxValue\":80,\"hysteresis\":5}]}}";
+
+static TelemetryPayload makeTelemetry() {
+  TelemetryPayload data;
+  memset(&data, 0, sizeof(data));
+  data.temp_c = 24.46f;
+  data.hum_rh = 81.04f;
+  data.hum_dirt = 55.55f;
+  data.light_lux = 1234.567f;
+  data.water_delta_l = 0.125f;
+  data.energy_delta_kwh = 0.0042f;
+  data.ts = "2025-10-11T20:23:16.000Z";
+  data.rssi = -67;
+  data.heap_free = 182344;
+  data.heap_min = 150112;
+  data.heap_block = 110580;
+  data.psram_free = 8123456;
+  data.stack_min = 1840;
+  data.ts_unix = 1760214196;
+  return data;
+}
+
+static void test_build_telemetry() {
+  TelemetryPayload data = makeTelemetry();
+  char output[API_PAYLOAD_SIZE];
+  size_t length = ApiPayload::buildTelemetry(&data, output, sizeof(output));
+  TEST_ASSERT_GREATER_THAN(0, length);
+  TEST_ASSERT_EQUAL_UINT(strlen(output), length);
+
+  DynamicJsonDocument doc(1024);
+  TEST_ASSERT_TRUE(deserializeJson(doc, output, length) == DeserializationError::Ok);
+  TEST_ASSERT_EQUAL_STRING(SITE_ID, doc["site_id"].as<const char *>());
+  TEST_ASSERT_EQUAL_STRING(ROOM_ID, doc["room_id"].as<const char *>());
+  TEST_ASSERT_EQUAL_STRING(data.ts, doc["ts"].as<const char *>());
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 24.5, doc["temp_c"].as<double>());
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 81.0, doc["hum_rh"].as<double>());
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 1234.57, doc["light_lux"].as<double>());
+  TEST_ASSERT_EQUAL_INT(-67, doc["rssi"].as<int>());
+  TEST_ASSERT_EQUAL_UINT32(data.heap_block, doc["heap_block"].as<uint32_t>());
+}
+
+static void test_build_telemetry_too_small() {
+  TelemetryPayload data = makeTelemetry();
+  char output[64];
+  TEST_ASSERT_EQUAL_UINT(0, ApiPayload::buildTelemetry(&data, output, sizeof(output)));
+  TEST_ASSERT_EQUAL_STRING("", output);
+}
+
+static void test_build_telemetry_msgpack() {
+  TelemetryPayload data = makeTelemetry();
+  uint8_t output[TELEMETRY_BINARY_SIZE];
+  size_t length = ApiPayload::buildTelemetryMsgPack(&data, output, sizeof(output));
+  TEST_ASSERT_GREATER_THAN(0, length);
+  TEST_ASSERT_LESS_OR_EQUAL(60, length); // Schema 1 worst case, see ApiPayload.h
+
+  StaticJsonDocument<JSON_ARRAY_SIZE(TELEMETRY_SCHEMA_FIELDS)> doc;
+  TEST_ASSERT_TRUE(deserializeMsgPack(doc, output, length) == DeserializationError::Ok);
+  JsonArray fields = doc.as<JsonArray>();
+  TEST_ASSERT_EQUAL_UINT(TELEMETRY_SCHEMA_FIELDS, fields.size());
+  TEST_ASSERT_EQUAL_INT(TELEMETRY_SCHEMA_VERSION, fields[0].as<int>());
+  TEST_ASSERT_EQUAL_UINT32(data.ts_unix, fields[1].as<uint32_t>());
+  TEST_ASSERT_EQUAL_INT(245, fields[2].as<int>());     // temp_c x10
+  TEST_ASSERT_EQUAL_INT(810, fields[3].as<int>());     // hum_rh x10
+  TEST_ASSERT_EQUAL_INT(123457, fields[5].as<int>());  // light_lux x100
+  TEST_ASSERT_EQUAL_INT(125, fields[6].as<int>());     // water_delta_l x1000
+  TEST_ASSERT_EQUAL_INT(42, fields[7].as<int>());      // energy_delta_kwh x10000
+  TEST_ASSERT_EQUAL_INT(-67, fields[8].as<int>());
+  TEST_ASSERT_EQUAL_UINT32(data.stack_min, fields[13].as<uint32_t>());
+}
+
+static void test_build_telemetry_msgpack_too_small() {
+  TelemetryPayload data = makeTelemetry();
+  uint8_t output[16];
+  TEST_ASSERT_EQUAL_UINT(0, ApiPayload::buildTelemetryMsgPack(&data, output, sizeof(output)));
+}
+
+static void test_build_relay_trigger_optional_fields() {
+  char output[API_PAYLOAD_SIZE];
+  size_t length = ApiPayload::buildRelayTrigger(true, "timer", "timer", 2, 0.0f, 0.0f, NULL, output, sizeof(output));
+  TEST_ASSERT_GREATER_THAN(0, length);
+
+  StaticJsonDocument<512> doc;
+  TEST_ASSERT_TRUE(deserializeJson(doc, output, length) == DeserializationError::Ok);
+  TEST_ASSERT_EQUAL_STRING("turn_on", doc["action"].as<const char *>());
+  TEST_ASSERT_EQUAL_STRING(USER_ID, doc["userId"].as<const char *>());
+  TEST_ASSERT_EQUAL_INT(2, doc["timerId"].as<int>());
+  TEST_ASSERT_TRUE(doc["triggerValue"].isNull());
+  TEST_ASSERT_TRUE(doc["message"].isNull());
+
+  length = ApiPayload::buildRelayTrigger(false, "sensor", "temperature", -1, 31.5f, 30.0f, "hot", output, sizeof(output));
+  TEST_ASSERT_TRUE(deserializeJson(doc, output, length) == DeserializationError::Ok);
+  TEST_ASSERT_EQUAL_STRING("turn_off", doc["action"].as<const char *>());
+  TEST_ASSERT_TRUE(doc["timerId"].isNull());
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 31.5, doc["triggerValue"].as<float>());
+  TEST_ASSERT_EQUAL_STRING("hot", doc["message"].as<const char *>());
+}
+
+static void test_build_status_and_log_event() {
+  char output[API_PAYLOAD_SIZE];
+  StaticJsonDocument<512> doc;
+
+  size_t length = ApiPayload::buildStatus(3, true, "sensor", false, true, NULL, output, sizeof(output));
+  TEST_ASSERT_TRUE(deserializeJson(doc, output, length) == DeserializationError::Ok);
+  TEST_ASSERT_EQUAL_INT(3, doc["relayId"].as<int>());
+  TEST_ASSERT_TRUE(doc["currentState"].as<bool>());
+  TEST_ASSERT_TRUE(doc["sensorActive"].as<bool>());
+  TEST_ASSERT_TRUE(doc["triggerType"].isNull());
+
+  length = ApiPayload::buildLogEvent(1, "relay_change", "MANUAL_MQTT", false, true, -1, 0.0f, NULL,
+                                     output, sizeof(output));
+  TEST_ASSERT_TRUE(deserializeJson(doc, output, length) == DeserializationError::Ok);
+  TEST_ASSERT_EQUAL_STRING("MANUAL_MQTT", doc["eventSource"].as<const char *>());
+  TEST_ASSERT_FALSE(doc["oldState"].as<bool>());
+  TEST_ASSERT_TRUE(doc["newState"].as<bool>());
+  TEST_ASSERT_TRUE(doc["timerId"].isNull());
+}
+
+static void test_build_switch_state() {
+  char output[128];
+  size_t length = ApiPayload::buildSwitchState(2, 1, 413, "DEVICE_SYNC", output, sizeof(output));
+  StaticJsonDocument<256> doc;
+  TEST_ASSERT_TRUE(deserializeJson(doc, output, length) == DeserializationError::Ok);
+  TEST_ASSERT_EQUAL_INT(2, doc["id"].as<int>());
+  TEST_ASSERT_EQUAL_STRING("on", doc["state"].as<const char *>());
+  TEST_ASSERT_EQUAL_UINT32(413, doc["version"].as<uint32_t>());
+  TEST_ASSERT_EQUAL_STRING("DEVICE_SYNC", doc["origin"].as<const char *>());
+
+  length = ApiPayload::buildSwitchState(1, 0, 0, NULL, output, sizeof(output));
+  TEST_ASSERT_EQUAL_STRING("{\"id\":1,\"state\":\"off\"}", output);
+  TEST_ASSERT_EQUAL_UINT(strlen(output), length);
+}
+
+static void test_parse_switch_states() {
+  int states[4] = {-1, -1, -1, -1};
+  uint32_t versions[4] = {99, 99, 99, 99};
+  TEST_ASSERT_TRUE(ApiPayload::parseSwitchStates(SWITCH_LIST_JSON, strlen(SWITCH_LIST_JSON), states, versions, 4));
+  TEST_ASSERT_EQUAL_INT(1, states[0]);
+  TEST_ASSERT_EQUAL_INT(0, states[1]);
+  TEST_ASSERT_EQUAL_INT(-1, states[2]); // Not in the response, untouched
+  TEST_ASSERT_EQUAL_INT(1, states[3]);
+  TEST_ASSERT_EQUAL_UINT32(412, versions[0]);
+  TEST_ASSERT_EQUAL_UINT32(87, versions[1]);
+  TEST_ASSERT_EQUAL_UINT32(99, versions[2]);
+  TEST_ASSERT_EQUAL_UINT32(0, versions[3]); // No version from the server
+
+  // Without versions
+  TEST_ASSERT_TRUE(ApiPayload::parseSwitchStates(SWITCH_LIST_JSON, strlen(SWITCH_LIST_JSON), states, NULL, 4));
+}
+
+static void test_parse_switch_states_rejects() {
+  int states[4];
+  const char *failed = "{\"success\":false,\"data\":[]}";
+  const char *not_array = "{\"success\":true,\"data\":{}}";
+  const char *broken = "{\"success\":true,\"data\":[";
+  TEST_ASSERT_FALSE(ApiPayload::parseSwitchStates(failed, strlen(failed), states, NULL, 4));
+  TEST_ASSERT_FALSE(ApiPayload::parseSwitchStates(not_array, strlen(not_array), states, NULL, 4));
+  TEST_ASSERT_FALSE(ApiPayload::parseSwitchStates(broken, strlen(broken), states, NULL, 4));
+}
+
+static void test_parse_switch_state() {
+  const char *on = "{\"success\":true,\"data\":{\"id\":2,\"state\":\"on\"}}";
+  const char *failed = "{\"success\":false}";
+  int state = -1;
+  TEST_ASSERT_TRUE(ApiPayload::parseSwitchState(on, strlen(on), &state));
+  TEST_ASSERT_EQUAL_INT(1, state);
+  TEST_ASSERT_FALSE(ApiPayload::parseSwitchState(failed, strlen(failed), &state));
+}
+
+static void test_parse_automation_sync() {
+  AutomationTimer timers[2];
+  AutomationSensor sensors[4];
+  AutomationSyncData data;
+  data.timers = timers;
+  data.max_timers = 2; // One more in the response, dropped
+  data.sensors = sensors;
+  data.max_sensors = 4;
+
+  TEST_ASSERT_TRUE(ApiPayload::parseAutomationSync(SYNC_JSON, strlen(SYNC_JSON), &data));
+  TEST_ASSERT_EQUAL_STRING("7f3c2a91e4b05d68", data.sync_token);
+
+  TEST_ASSERT_EQUAL_INT(5, data.intervals[POLL_SWITCH]);
+  TEST_ASSERT_EQUAL_INT(0, data.intervals[POLL_AUTOMATION_SYNC]);
+  TEST_ASSERT_EQUAL_INT(-1, data.intervals[POLL_TELEMETRY]); // Not a number
+  TEST_ASSERT_EQUAL_INT(-1, data.intervals[POLL_TIMER_CHECK]);
+
+  TEST_ASSERT_EQUAL_INT(2, data.timer_count);
+  TEST_ASSERT_EQUAL_UINT8(1, timers[0].relay_id);
+  TEST_ASSERT_EQUAL_UINT8(2, timers[0].timer_id);
+  TEST_ASSERT_TRUE(timers[0].enabled);
+  TEST_ASSERT_TRUE(timers[0].days[0]);
+  TEST_ASSERT_FALSE(timers[0].days[1]);
+  TEST_ASSERT_EQUAL_INT(450, timers[0].time_on);
+  TEST_ASSERT_EQUAL_INT(1140, timers[0].time_off);
+  TEST_ASSERT_TRUE(IS_TIMER_DISABLED(timers[1].time_on, timers[1].time_off));
+
+  TEST_ASSERT_EQUAL_INT(2, data.sensor_count);
+  TEST_ASSERT_EQUAL_STRING("temperature", sensors[0].sensor_type);
+  TEST_ASSERT_EQUAL_STRING("turn_off", sensors[0].action);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 30.5, sensors[0].max_value);
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 2.0, sensors[0].hysteresis); // Default
+  TEST_ASSERT_EQUAL_STRING("", sensors[1].action);             // Follow the threshold
+  TEST_ASSERT_FLOAT_WITHIN(0.001, 5.0, sensors[1].hysteresis);
+}
+
+static void test_parse_automation_sync_without_sensors() {
+  AutomationTimer timers[4];
+  AutomationSyncData data;
+  data.timers = timers;
+  data.max_timers = 4;
+  data.sensors = NULL;
+  data.max_sensors = 0;
+  TEST_ASSERT_TRUE(ApiPayload::parseAutomationSync(SYNC_JSON, strlen(SYNC_JSON), &data));
+  TEST_ASSERT_EQUAL_INT(3, data.timer_count);
+  TEST_ASSERT_EQUAL_INT(0, data.sensor_count);
+
+  const char *failed = "{\"success\":false,\"error\":{\"message\":\"no room\"}}";
+  TEST_ASSERT_FALSE(ApiPayload::parseAutomationSync(failed, strlen(failed), &data));
+  TEST_ASSERT_EQUAL_INT(0, data.timer_count);
+}
+
+static void test_normalize_action() {
+  char action[10];
+  ApiPayload::normalizeAction("On", action, sizeof(action));
+  TEST_ASSERT_EQUAL_STRING("turn_on", action);
+  ApiPayload::normalizeAction("turn-off", action, sizeof(action));
+  TEST_ASSERT_EQUAL_STRING("turn_off", action);
+  ApiPayload::normalizeAction("TurnOff", action, sizeof(action));
+  TEST_ASSERT_EQUAL_STRING("turn_off", action);
+  ApiPayload::normalizeAction(NULL, action, sizeof(action));
+  TEST_ASSERT_EQUAL_STRING("turn_on", action);
+  ApiPayload::normalizeAction("toggle relay now", action, sizeof(action));
+  TEST_ASSERT_EQUAL_STRING("toggle_re", action); // Truncated to the buffer
+}
+
+static void test_state_from_string() {
+  TEST_ASSERT_EQUAL_INT(1, ApiPayload::stateFromString("on"));
+  TEST_ASSERT_EQUAL_INT(0, ApiPayload::stateFromString("off"));
+  TEST_ASSERT_EQUAL_INT(0, ApiPayload::stateFromString("ON"));
+  TEST_ASSERT_EQUAL_INT(0, ApiPayload::stateFromString(NULL));
+}
+
+static void test_parse_seconds() {
+  uint32_t seconds = 0;
+  TEST_ASSERT_TRUE(ApiPayload::parseSeconds("120", &seconds));
+  TEST_ASSERT_EQUAL_UINT32(120, seconds);
+  TEST_ASSERT_TRUE(ApiPayload::parseSeconds(" 5 ", &seconds));
+  TEST_ASSERT_EQUAL_UINT32(5, seconds);
+  TEST_ASSERT_TRUE(ApiPayload::parseSeconds("4294967295", &seconds));
+  TEST_ASSERT_EQUAL_UINT32(4294967295u, seconds);
+}
+
+static void test_parse_seconds_rejects() {
+  const char* bad[] = { "", " ", "0", "-5", "+5", "1.5", "30s", "0x10", "4294967296",
+                        "99999999999999999999", "Wed, 21 Oct 2015 07:28:00 GMT" };
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+    uint32_t seconds = 77;
+    TEST_ASSERT_FALSE_MESSAGE(ApiPayload::parseSeconds(bad[i], &seconds), bad[i]);
+    TEST_ASSERT_EQUAL_UINT32(77, seconds); // Untouched
+  }
+  TEST_ASSERT_FALSE(ApiPayload::parseSeconds(NULL, NULL));
+}
+
+void run_payload_tests() {
+  RUN_TEST(test_build_telemetry);
+  RUN_TEST(test_build_telemetry_too_small);
+  RUN_TEST(test_build_telemetry_msgpack);
+  RUN_TEST(test_build_telemetry_msgpack_too_small);
+  RUN_TEST(test_build_relay_trigger_optional_fields);
+  RUN_TEST(test_build_status_and_log_event);
+  RUN_TEST(test_build_switch_state);
+  RUN_TEST(test_parse_switch_states);
+  RUN_TEST(test_parse_switch_states_rejects);
+  RUN_TEST(test_parse_switch_state);
+  RUN_TEST(test_parse_automation_sync);
+  RUN_TEST(test_parse_automation_sync_without_sensors);
+  RUN_TEST(test_normalize_action);
+  RUN_TEST(test_state_from_string);
+  RUN_TEST(test_parse_seconds);
+  RUN_TEST(test_parse_seconds_rejects);
+}
@@ -0,0 +1,154 @@
+#include <unity.h>
+#include <string.h>
+#include "AutomationSchedule.h"
+
+#define MINUTES(h, m) ((h) * 60 + (m))
+
+enum { MON = 0, TUE, WED, THU, FRI, SAT, SUN };
+
+static AutomationTimer makeTimer(int on, int off, const bool days[7]) {
+  AutomationTimer timer;
+  memset(&timer, 0, sizeof(timer));
+  timer.enabled = true;
+  timer.time_on = on;
+  timer.time_off = off;
+  memcpy(timer.days, days, sizeof(timer.days));
+  return timer;
+}
+
+static const bool WEEKDAYS[7] = {true, true, true, true, true, false, false};
+static const bool EVERY_DAY[7] = {true, true, true, true, true, true, true};
+static const bool MONDAY_ONLY[7] = {true, false, false, false, false, false, false};
+static const bool SUNDAY_ONLY[7] = {false, false, false, false, false, false, true};
+
+static void test_time_string_to_minutes() {
+  TEST_ASSERT_EQUAL_INT(480, AutomationSchedule::timeStringToMinutes("08:00:00"));
+  TEST_ASSERT_EQUAL_INT(MINUTES(23, 59), AutomationSchedule::timeStringToMinutes("23:59:59"));
+  TEST_ASSERT_EQUAL_INT(MINUTES(6, 5), AutomationSchedule::timeStringToMinutes("6:05"));
+  TEST_ASSERT_EQUAL_INT(3000, AutomationSchedule::timeStringToMinutes("50:00:00"));
+}
+
+static void test_time_string_to_minutes_rejects_garbage() {
+  TEST_ASSERT_EQUAL_INT(0, AutomationSchedule::timeStringToMinutes(NULL));
+  TEST_ASSERT_EQUAL_INT(0, AutomationSchedule::timeStringToMinutes(""));
+  TEST_ASSERT_EQUAL_INT(0, AutomationSchedule::timeStringToMinutes("noon"));
+  TEST_ASSERT_EQUAL_INT(0, AutomationSchedule::timeStringToMinutes("08"));
+}
+
+static void test_minutes_to_time_string_round_trip() {
+  char text[16];
+  for (int minutes = 0; minutes < 1440; minutes += 7) {
+    AutomationSchedule::minutesToTimeString(minutes, text);
+    TEST_ASSERT_EQUAL_INT(minutes, AutomationSchedule::timeStringToMinutes(text));
+  }
+  AutomationSchedule::minutesToTimeString(3000, text);
+  TEST_ASSERT_EQUAL_STRING("50:00:00", text);
+  AutomationSchedule::minutesToTimeString(-5, text);
+  TEST_ASSERT_EQUAL_STRING("00:00:00", text);
+}
+
+static void test_get_day_of_week() {
+  struct tm timeinfo;
+  memset(&timeinfo, 0, sizeof(timeinfo));
+  timeinfo.tm_wday = 0; // Sunday
+  TEST_ASSERT_EQUAL_INT(SUN, AutomationSchedule::getDayOfWeek(&timeinfo));
+  timeinfo.tm_wday = 1;
+  TEST_ASSERT_EQUAL_INT(MON, AutomationSchedule::getDayOfWeek(&timeinfo));
+  timeinfo.tm_wday = 6;
+  TEST_ASSERT_EQUAL_INT(SAT, AutomationSchedule::getDayOfWeek(&timeinfo));
+}
+
+static void test_timer_active_window() {
+  AutomationTimer timer = makeTimer(MINUTES(8, 0), MINUTES(8, 30), WEEKDAYS);
+  TEST_ASSERT_FALSE(AutomationSchedule::isTimerActive(&timer, MINUTES(7, 59), MON));
+  TEST_ASSERT_TRUE(AutomationSchedule::isTimerActive(&timer, MINUTES(8, 0), MON));
+  TEST_ASSERT_TRUE(AutomationSchedule::isTimerActive(&timer, MINUTES(8, 29), FRI));
+  TEST_ASSERT_FALSE(AutomationSchedule::isTimerActive(&timer, MINUTES(8, 30), MON)); // time_off excluded
+  TEST_ASSERT_FALSE(AutomationSchedule::isTimerActive(&timer, MINUTES(8, 10), SAT));
+}
+
+static void test_timer_inactive_when_disabled() {
+  AutomationTimer timer = makeTimer(MINUTES(8, 0), MINUTES(9, 0), EVERY_DAY);
+  timer.enabled = false;
+  TEST_ASSERT_FALSE(AutomationSchedule::isTimerActive(&timer, MINUTES(8, 30), MON));
+
+  AutomationTimer marker = makeTimer(3000, 3000, EVERY_DAY);
+  TEST_ASSERT_FALSE(AutomationSchedule::isTimerActive(&marker, MINUTES(8, 30), MON));
+
+  TEST_ASSERT_FALSE(AutomationSchedule::isTimerActive(NULL, MINUTES(8, 30), MON));
+  TEST_ASSERT_FALSE(AutomationSchedule::isTimerActive(&timer, MINUTES(8, 30), 7));
+  TEST_ASSERT_FALSE(AutomationSchedule::isTimerActive(&timer, MINUTES(8, 30), -1));
+}
+
+static void test_next_edge_same_day() {
+  AutomationTimer timer = makeTimer(MINUTES(8, 0), MINUTES(8, 30), WEEKDAYS);
+  TEST_ASSERT_EQUAL_INT(60, AutomationSchedule::getMinutesToNextEdge(&timer, 1, MINUTES(7, 0), MON));
+  TEST_ASSERT_EQUAL_INT(20, AutomationSchedule::getMinutesToNextEdge(&timer, 1, MINUTES(8, 10), MON));
+}
+
+static void test_next_edge_skips_to_next_scheduled_day() {
+  AutomationTimer timer = makeTimer(MINUTES(8, 0), MINUTES(8, 30), WEEKDAYS);
+  // Friday after the window -> Monday 08:00
+  int expected = 3 * 1440 + MINUTES(8, 0) - MINUTES(9, 0);
+  TEST_ASSERT_EQUAL_INT(expected, AutomationSchedule::getMinutesToNextEdge(&timer, 1, MINUTES(9, 0), FRI));
+
+  // Only on Sunday, asked on Sunday after the window -> next Sunday
+  AutomationTimer weekly = makeTimer(MINUTES(6, 0), MINUTES(6, 15), SUNDAY_ONLY);
+  expected = 7 * 1440 + MINUTES(6, 0) - MINUTES(7, 0);
+  TEST_ASSERT_EQUAL_INT(expected, AutomationSchedule::getMinutesToNextEdge(&weekly, 1, MINUTES(7, 0), SUN));
+}
+
+static void test_next_edge_is_nearest_of_all_timers() {
+  AutomationTimer timers[3];
+  timers[0] = makeTimer(MINUTES(18, 0), MINUTES(18, 15), EVERY_DAY);
+  timers[1] = makeTimer(MINUTES(12, 0), MINUTES(12, 15), EVERY_DAY);
+  timers[2] = makeTimer(MINUTES(10, 0), MINUTES(10, 5), EVERY_DAY);
+  timers[2].enabled = false;
+  TEST_ASSERT_EQUAL_INT(MINUTES(1, 0), AutomationSchedule::getMinutesToNextEdge(timers, 3, MINUTES(11, 0), TUE));
+}
+
+static void test_overnight_timer_single_day() {
+  // Monday 22:00 -> Tuesday 06:00, Tuesday itself not enabled
+  AutomationTimer timer = makeTimer(MINUTES(22, 0), MINUTES(6, 0), MONDAY_ONLY);
+  TEST_ASSERT_FALSE(AutomationSchedule::isTimerActive(&timer, MINUTES(5, 0), MON)); // Sunday not enabled
+  TEST_ASSERT_TRUE(AutomationSchedule::isTimerActive(&timer, MINUTES(23, 0), MON));
+  TEST_ASSERT_TRUE(AutomationSchedule::isTimerActive(&timer, MINUTES(5, 59), TUE));
+  TEST_ASSERT_FALSE(AutomationSchedule::isTimerActive(&timer, MINUTES(6, 0), TUE));
+  TEST_ASSERT_FALSE(AutomationSchedule::isTimerActive(&timer, MINUTES(23, 0), TUE));
+
+  // The off edge is on Tuesday, not next Monday's time_on
+  TEST_ASSERT_EQUAL_INT(MINUTES(2, 0), AutomationSchedule::getMinutesToNextEdge(&timer, 1, MINUTES(20, 0), MON));
+  TEST_ASSERT_EQUAL_INT(MINUTES(7, 0), AutomationSchedule::getMinutesToNextEdge(&timer, 1, MINUTES(23, 0), MON));
+  TEST_ASSERT_EQUAL_INT(MINUTES(1, 0), AutomationSchedule::getMinutesToNextEdge(&timer, 1, MINUTES(5, 0), TUE));
+  // After it, next Monday 22:00
+  int expected = 6 * 1440 + MINUTES(22, 0) - MINUTES(7, 0);
+  TEST_ASSERT_EQUAL_INT(expected, AutomationSchedule::getMinutesToNextEdge(&timer, 1, MINUTES(7, 0), TUE));
+
+  // Sunday night into Monday wraps the week
+  AutomationTimer sunday = makeTimer(MINUTES(22, 0), MINUTES(6, 0), SUNDAY_ONLY);
+  TEST_ASSERT_TRUE(AutomationSchedule::isTimerActive(&sunday, MINUTES(1, 0), MON));
+  TEST_ASSERT_EQUAL_INT(MINUTES(5, 0), AutomationSchedule::getMinutesToNextEdge(&sunday, 1, MINUTES(1, 0), MON));
+}
+
+static void test_next_edge_none() {
+  AutomationTimer timers[2];
+  timers[0] = makeTimer(3000, 3000, EVERY_DAY);
+  timers[1] = makeTimer(MINUTES(8, 0), MINUTES(9, 0), EVERY_DAY);
+  timers[1].enabled = false;
+  TEST_ASSERT_EQUAL_INT(-1, AutomationSchedule::getMinutesToNextEdge(timers, 2, MINUTES(8, 0), MON));
+  TEST_ASSERT_EQUAL_INT(-1, AutomationSchedule::getMinutesToNextEdge(timers, 0, MINUTES(8, 0), MON));
+}
+
+void run_schedule_tests() {
+  RUN_TEST(test_time_string_to_minutes);
+  RUN_TEST(test_time_string_to_minutes_rejects_garbage);
+  RUN_TEST(test_minutes_to_time_string_round_trip);
+  RUN_TEST(test_get_day_of_week);
+  RUN_TEST(test_timer_active_window);
+  RUN_TEST(test_timer_inactive_when_disabled);
+  RUN_TEST(test_next_edge_same_day);
+  RUN_TEST(test_next_edge_skips_to_next_scheduled_day);
+  RUN_TEST(test_next_edge_is_nearest_of_all_timers);
+  RUN_TEST(test_overnight_timer_single_day);
+  RUN_TEST(test_next_edge_none);
+}
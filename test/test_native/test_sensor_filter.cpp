@@ -0,0 +1,164 @@
+#include <unity.h>
+#include <math.h>
+#include "SensorFilter.h"
+
+#define SAMPLE_MS 1000
+
+static SensorFilter makeFilter(uint8_t medianWindow, float emaAlpha, float maxRate) {
+  SensorFilterConfig config = { medianWindow, emaAlpha, maxRate };
+  SensorFilter filter;
+  filter.setup(config);
+  return filter;
+}
+
+// Feed values one per SAMPLE_MS from t = 0, return the last output
+static float feed(SensorFilter *filter, const float *values, int count) {
+  float output = NAN;
+  for (int i = 0; i < count; i++) {
+    TEST_ASSERT_TRUE(filter->update(values[i], i * SAMPLE_MS, &output));
+  }
+  return output;
+}
+
+static void test_filter_off_pass_through() {
+  SensorFilter filter; // Default config: every stage off
+  float output;
+  const float values[] = { 10.0f, -4.5f, 1000.0f, 0.0f };
+  for (int i = 0; i < 4; i++) {
+    TEST_ASSERT_TRUE(filter.update(values[i], i * SAMPLE_MS, &output));
+    TEST_ASSERT_EQUAL_FLOAT(values[i], output);
+  }
+}
+
+static void test_filter_median_removes_single_spike() {
+  SensorFilter filter = makeFilter(3, 1.0f, 0.0f);
+  float output;
+  TEST_ASSERT_TRUE(filter.update(10.0f, 0, &output));
+  TEST_ASSERT_TRUE(filter.update(10.0f, 1000, &output));
+  TEST_ASSERT_TRUE(filter.update(50.0f, 2000, &output)); // Median of 10, 10, 50
+  TEST_ASSERT_EQUAL_FLOAT(10.0f, output);
+  TEST_ASSERT_TRUE(filter.update(11.0f, 3000, &output)); // Median of 10, 50, 11
+  TEST_ASSERT_EQUAL_FLOAT(11.0f, output);
+}
+
+static void test_filter_median_window_fill_and_wrap() {
+  SensorFilter filter = makeFilter(4, 1.0f, 0.0f);
+  const float filling[] = { 1.0f, 2.0f };
+  TEST_ASSERT_EQUAL_FLOAT(1.5f, feed(&filter, filling, 2)); // Median of what is there so far
+
+  const float values[] = { 1.0f, 2.0f, 3.0f, 4.0f };
+  filter.reset();
+  TEST_ASSERT_EQUAL_FLOAT(2.5f, feed(&filter, values, 4)); // Even window, mean of the middle two
+
+  const float wrapped[] = { 1.0f, 2.0f, 3.0f, 4.0f, 9.0f, 9.0f };
+  filter.reset();
+  TEST_ASSERT_EQUAL_FLOAT(6.5f, feed(&filter, wrapped, 6)); // Window is 3, 4, 9, 9
+}
+
+static void test_filter_setup_clamps_config() {
+  SensorFilter filter = makeFilter(0, 0.0f, 0.0f); // Window 1, alpha 1
+  float output;
+  TEST_ASSERT_TRUE(filter.update(5.0f, 0, &output));
+  TEST_ASSERT_TRUE(filter.update(7.0f, 1000, &output));
+  TEST_ASSERT_EQUAL_FLOAT(7.0f, output);
+
+  filter = makeFilter(200, 1.5f, 0.0f); // Window SENSOR_FILTER_MAX_WINDOW, alpha 1
+  for (int i = 0; i < SENSOR_FILTER_MAX_WINDOW; i++) {
+    TEST_ASSERT_TRUE(filter.update((i < SENSOR_FILTER_MAX_WINDOW / 2 + 1) ? 1.0f : 100.0f, i * SAMPLE_MS, &output));
+  }
+  TEST_ASSERT_EQUAL_FLOAT(1.0f, output); // Majority still 1, so the window really is 9
+}
+
+static void test_filter_ema_converges() {
+  SensorFilter filter = makeFilter(1, 0.5f, 0.0f);
+  float output;
+  TEST_ASSERT_TRUE(filter.update(0.0f, 0, &output)); // First value seed the EMA
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, output);
+
+  float previous = output;
+  for (int i = 1; i <= 20; i++) {
+    TEST_ASSERT_TRUE(filter.update(10.0f, i * SAMPLE_MS, &output));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 10.0f * (1.0f - powf(0.5f, i)), output);
+    TEST_ASSERT_TRUE(output > previous);
+    previous = output;
+  }
+  TEST_ASSERT_FLOAT_WITHIN(1e-4, 10.0f, output);
+}
+
+static void test_filter_rate_limit_rejects_spike() {
+  SensorFilter filter = makeFilter(1, 1.0f, 2.0f); // 2 units per second
+  float output;
+  TEST_ASSERT_TRUE(filter.update(25.0f, 0, &output));
+  TEST_ASSERT_TRUE(filter.update(25.5f, 1000, &output));
+
+  output = -1.0f;
+  TEST_ASSERT_FALSE(filter.update(40.0f, 2000, &output));
+  TEST_ASSERT_EQUAL_FLOAT(-1.0f, output); // Untouched on reject
+  TEST_ASSERT_EQUAL_UINT32(1, filter.getRejectCount());
+
+  // Rate is against the last accepted value and its time
+  TEST_ASSERT_TRUE(filter.update(27.0f, 3000, &output));
+  TEST_ASSERT_EQUAL_FLOAT(27.0f, output);
+  TEST_ASSERT_TRUE(filter.update(35.0f, 8000, &output)); // 8 in 5 s, slow enough
+  TEST_ASSERT_EQUAL_FLOAT(35.0f, output);
+}
+
+static void test_filter_accepts_real_step_after_rejects() {
+  SensorFilter filter = makeFilter(3, 0.5f, 2.0f);
+  float output;
+  uint32_t now = 0;
+  for (int i = 0; i < 3; i++, now += SAMPLE_MS) {
+    TEST_ASSERT_TRUE(filter.update(25.0f, now, &output));
+  }
+  for (int i = 0; i < SENSOR_FILTER_MAX_REJECTS; i++, now += SAMPLE_MS) {
+    TEST_ASSERT_FALSE(filter.update(60.0f, now, &output));
+  }
+  // Still far above the rate, taken now and the filter start over from it
+  TEST_ASSERT_TRUE(filter.update(60.0f, now, &output));
+  TEST_ASSERT_EQUAL_FLOAT(60.0f, output);
+  now += SAMPLE_MS;
+  TEST_ASSERT_TRUE(filter.update(60.5f, now, &output)); // Not averaged with the old 25
+  TEST_ASSERT_TRUE(output >= 60.0f);
+  TEST_ASSERT_EQUAL_UINT32(SENSOR_FILTER_MAX_REJECTS, filter.getRejectCount());
+}
+
+static void test_filter_accepted_value_resets_reject_run() {
+  SensorFilter filter = makeFilter(1, 1.0f, 2.0f);
+  float output;
+  uint32_t now = 0;
+  TEST_ASSERT_TRUE(filter.update(25.0f, now, &output));
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < SENSOR_FILTER_MAX_REJECTS - 1; i++) {
+      now += SAMPLE_MS;
+      TEST_ASSERT_FALSE(filter.update(80.0f, now, &output));
+    }
+    now += SAMPLE_MS;
+    TEST_ASSERT_TRUE(filter.update(25.0f, now, &output)); // Spikes never reach the limit in a row
+    TEST_ASSERT_EQUAL_FLOAT(25.0f, output);
+  }
+}
+
+static void test_filter_nan_rejected() {
+  SensorFilter filter = makeFilter(3, 0.5f, 2.0f);
+  float output = 1.0f;
+  TEST_ASSERT_FALSE(filter.update(NAN, 0, &output));
+  TEST_ASSERT_EQUAL_FLOAT(1.0f, output);
+  TEST_ASSERT_TRUE(filter.update(25.0f, 1000, &output)); // Not started by the NAN
+  TEST_ASSERT_EQUAL_FLOAT(25.0f, output);
+  TEST_ASSERT_EQUAL_UINT32(1, filter.getRejectCount());
+
+  filter.reset();
+  TEST_ASSERT_EQUAL_UINT32(0, filter.getRejectCount());
+}
+
+void run_sensor_filter_tests() {
+  RUN_TEST(test_filter_off_pass_through);
+  RUN_TEST(test_filter_median_removes_single_spike);
+  RUN_TEST(test_filter_median_window_fill_and_wrap);
+  RUN_TEST(test_filter_setup_clamps_config);
+  RUN_TEST(test_filter_ema_converges);
+  RUN_TEST(test_filter_rate_limit_rejects_spike);
+  RUN_TEST(test_filter_accepts_real_step_after_rejects);
+  RUN_TEST(test_filter_accepted_value_resets_reject_run);
+  RUN_TEST(test_filter_nan_rejected);
+}
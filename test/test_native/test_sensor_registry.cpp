@@ -0,0 +1,185 @@
+#include <unity.h>
+#include <math.h>
+#include "SensorRegistry.h"
+#include "MockSensorDriver.h"
+
+#define CLIMATE_MASK (SENSOR_CH_MASK(SENSOR_TEMP) | SENSOR_CH_MASK(SENSOR_HUMI))
+
+// arg = float value, same for every channel and sample
+static float constantSource(SensorChannel, uint32_t, void *arg) {
+  return *(float *) arg;
+}
+
+// 25.0 C / 80 %RH with one 80.0 C spike on sample 3
+static float spikeSource(SensorChannel ch, uint32_t index, void *) {
+  if (ch == SENSOR_TEMP) {
+    return (index == 3) ? 80.0f : 25.0f;
+  }
+  return 80.0f;
+}
+
+static float noValueSource(SensorChannel, uint32_t, void *) {
+  return NAN;
+}
+
+// Call process() as the acquisition task would, from now for duration ms
+static uint32_t runFor(uint32_t now, uint32_t duration) {
+  uint32_t end = now + duration;
+  while ((int32_t) (end - now) > 0) {
+    now += SensorRegistry::process(now);
+  }
+  return now;
+}
+
+static void test_registry_add_skips_missing_driver() {
+  SensorRegistry::clear();
+  float value = 1.0f;
+  MockSensorDriver present("present", CLIMATE_MASK, 0, constantSource, &value);
+  MockSensorDriver missing("missing", CLIMATE_MASK, 0, constantSource, &value);
+  missing.setPresent(false);
+
+  TEST_ASSERT_TRUE(SensorRegistry::add(&present));
+  TEST_ASSERT_FALSE(SensorRegistry::add(&missing));
+  TEST_ASSERT_FALSE(SensorRegistry::add(NULL));
+  TEST_ASSERT_EQUAL_INT(1, SensorRegistry::count());
+  TEST_ASSERT_TRUE(SensorRegistry::get(0) == &present);
+  TEST_ASSERT_NULL(SensorRegistry::get(1));
+  TEST_ASSERT_NULL(SensorRegistry::get(-1));
+}
+
+static void test_registry_add_limit() {
+  SensorRegistry::clear();
+  float value = 1.0f;
+  MockSensorDriver driver("mock", SENSOR_CH_MASK(SENSOR_SOIL), 0, constantSource, &value);
+  for (int i = 0; i < SENSOR_MAX_DRIVERS; i++) {
+    TEST_ASSERT_TRUE(SensorRegistry::add(&driver));
+  }
+  TEST_ASSERT_FALSE(SensorRegistry::add(&driver));
+  TEST_ASSERT_EQUAL_INT(SENSOR_MAX_DRIVERS, SensorRegistry::count());
+}
+
+static void test_registry_conversions_overlap() {
+  SensorRegistry::clear();
+  float value = 20.0f;
+  MockSensorDriver slow("slow", CLIMATE_MASK, 10, constantSource, &value);
+  MockSensorDriver fast("fast", SENSOR_CH_MASK(SENSOR_SOIL), 0, constantSource, &value);
+  SensorRegistry::add(&slow);
+  SensorRegistry::add(&fast);
+
+  // Every driver is triggered before any is collected
+  TEST_ASSERT_EQUAL_UINT32(0, SensorRegistry::process(0));
+  TEST_ASSERT_EQUAL_UINT32(1, slow.getTriggerCount());
+  TEST_ASSERT_EQUAL_UINT32(1, fast.getTriggerCount());
+  TEST_ASSERT_EQUAL_UINT32(0, slow.getCollectCount());
+
+  // Fast one right away, then wait for the slow conversion only
+  TEST_ASSERT_EQUAL_UINT32(10, SensorRegistry::process(0));
+  TEST_ASSERT_EQUAL_UINT32(1, fast.getCollectCount());
+  TEST_ASSERT_EQUAL_UINT32(0, slow.getCollectCount());
+
+  TEST_ASSERT_EQUAL_UINT32(0, SensorRegistry::process(10));
+  TEST_ASSERT_EQUAL_UINT32(1, slow.getCollectCount());
+  TEST_ASSERT_EQUAL_UINT32(1, SensorRegistry::getCycleCount());
+
+  // Idle for the rest of the interval
+  TEST_ASSERT_EQUAL_UINT32(SENSOR_SAMPLE_INTERVAL - 10, SensorRegistry::process(10));
+}
+
+static void test_registry_cycle_every_interval() {
+  SensorRegistry::clear();
+  float value = 20.0f;
+  MockSensorDriver driver("mock", CLIMATE_MASK, 30, constantSource, &value);
+  SensorRegistry::add(&driver);
+
+  runFor(0, 10 * SENSOR_SAMPLE_INTERVAL);
+  TEST_ASSERT_EQUAL_UINT32(10, SensorRegistry::getCycleCount());
+  TEST_ASSERT_EQUAL_UINT32(10, driver.getTriggerCount());
+  TEST_ASSERT_EQUAL_UINT32(10, driver.getCollectCount());
+}
+
+static void test_registry_publish_samples() {
+  SensorRegistry::clear();
+  float value = 42.0f;
+  MockSensorDriver driver("mock", CLIMATE_MASK, 0, constantSource, &value);
+  SensorRegistry::add(&driver);
+
+  SensorSample sample;
+  TEST_ASSERT_FALSE(SensorRegistry::getSample(SENSOR_TEMP, &sample, 0)); // Nothing yet
+
+  uint32_t now = runFor(0, SENSOR_SAMPLE_INTERVAL);
+  TEST_ASSERT_TRUE(SensorRegistry::getSample(SENSOR_TEMP, &sample, now));
+  TEST_ASSERT_EQUAL_FLOAT(42.0f, sample.value);
+  TEST_ASSERT_TRUE(SensorRegistry::getSample(SENSOR_HUMI, &sample, now));
+  TEST_ASSERT_FALSE(SensorRegistry::getSample(SENSOR_SOIL, &sample, now)); // Not a channel of the driver
+  TEST_ASSERT_FALSE(SensorRegistry::getSample(SENSOR_CHANNEL_COUNT, &sample, now));
+}
+
+static void test_registry_filter_drops_spike() {
+  SensorRegistry::clear();
+  MockSensorDriver driver("mock", CLIMATE_MASK, 0, spikeSource);
+  SensorRegistry::add(&driver);
+
+  SensorSample sample;
+  uint32_t now = 0;
+  for (int cycle = 0; cycle < 6; cycle++) {
+    now = runFor(now, SENSOR_SAMPLE_INTERVAL);
+    TEST_ASSERT_TRUE(SensorRegistry::getSample(SENSOR_TEMP, &sample, now));
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 25.0f, sample.value); // SENSOR_FILTER_TEMP rate limit
+  }
+  TEST_ASSERT_EQUAL_UINT32(1, SensorRegistry::getRejectCount(0, SENSOR_TEMP));
+  TEST_ASSERT_EQUAL_UINT32(0, SensorRegistry::getRejectCount(0, SENSOR_HUMI));
+}
+
+static void test_registry_failed_driver_goes_stale() {
+  SensorRegistry::clear();
+  float value = 25.0f;
+  MockSensorDriver driver("mock", CLIMATE_MASK, 0, constantSource, &value);
+  SensorRegistry::add(&driver);
+
+  uint32_t now = runFor(0, 3 * SENSOR_SAMPLE_INTERVAL);
+  SensorSample sample;
+  TEST_ASSERT_TRUE(SensorRegistry::getInstanceSample(0, SENSOR_TEMP, &sample, now));
+  uint32_t lastGood = sample.timestamp;
+
+  driver.setFailTrigger(true);
+  uint32_t collected = driver.getCollectCount();
+  now = runFor(now, SENSOR_SAMPLE_MAX_AGE);
+  TEST_ASSERT_EQUAL_UINT32(collected, driver.getCollectCount()); // Failed trigger is not collected
+
+  // Last value is kept until it is too old
+  TEST_ASSERT_TRUE(SensorRegistry::getInstanceSample(0, SENSOR_TEMP, &sample, lastGood + SENSOR_SAMPLE_MAX_AGE));
+  TEST_ASSERT_FALSE(SensorRegistry::getInstanceSample(0, SENSOR_TEMP, &sample, lastGood + SENSOR_SAMPLE_MAX_AGE + 1));
+  TEST_ASSERT_FALSE(SensorRegistry::getSample(SENSOR_TEMP, &sample, now));
+
+  // Back on the next cycle
+  driver.setFailTrigger(false);
+  now = runFor(now, 2 * SENSOR_SAMPLE_INTERVAL);
+  TEST_ASSERT_TRUE(SensorRegistry::getSample(SENSOR_TEMP, &sample, now));
+}
+
+static void test_registry_sample_from_first_valid_instance() {
+  SensorRegistry::clear();
+  float value = 30.0f;
+  MockSensorDriver broken("broken", CLIMATE_MASK, 0, noValueSource);
+  MockSensorDriver backup("backup", SENSOR_CH_MASK(SENSOR_TEMP), 0, constantSource, &value);
+  SensorRegistry::add(&broken);
+  SensorRegistry::add(&backup);
+
+  uint32_t now = runFor(0, 2 * SENSOR_SAMPLE_INTERVAL);
+  SensorSample sample;
+  TEST_ASSERT_FALSE(SensorRegistry::getInstanceSample(0, SENSOR_TEMP, &sample, now)); // NAN never published
+  TEST_ASSERT_TRUE(SensorRegistry::getSample(SENSOR_TEMP, &sample, now));
+  TEST_ASSERT_EQUAL_FLOAT(30.0f, sample.value);
+  TEST_ASSERT_FALSE(SensorRegistry::getSample(SENSOR_HUMI, &sample, now));
+}
+
+void run_sensor_registry_tests() {
+  RUN_TEST(test_registry_add_skips_missing_driver);
+  RUN_TEST(test_registry_add_limit);
+  RUN_TEST(test_registry_conversions_overlap);
+  RUN_TEST(test_registry_cycle_every_interval);
+  RUN_TEST(test_registry_publish_samples);
+  RUN_TEST(test_registry_filter_drops_spike);
+  RUN_TEST(test_registry_failed_driver_goes_stale);
+  RUN_TEST(test_registry_sample_from_first_valid_instance);
+}
@@ -0,0 +1,79 @@
+#include <unity.h>
+#include "SwitchSync.h"
+
+// Device and server agree on state 0 at version 10
+static SwitchSyncState synced() {
+  SwitchSyncState s = {};
+  SwitchSync::remote(&s, 0, 10);
+  return s;
+}
+
+static void test_sync_first_poll_keeps_device_state() {
+  SwitchSyncState s = {};
+  s.state = 1;
+  TEST_ASSERT_EQUAL_INT(SWITCH_SYNC_SEND, SwitchSync::remote(&s, 0, 10));
+  TEST_ASSERT_EQUAL_UINT32(11, s.version);
+  TEST_ASSERT_EQUAL_UINT32(11, s.pending);
+}
+
+static void test_sync_newer_server_state_applies() {
+  SwitchSyncState s = synced();
+  TEST_ASSERT_EQUAL_INT(SWITCH_SYNC_APPLY, SwitchSync::remote(&s, 1, 11));
+  TEST_ASSERT_EQUAL_INT(1, s.state);
+  TEST_ASSERT_EQUAL_INT(SWITCH_SYNC_NONE, SwitchSync::remote(&s, 1, 11));
+}
+
+static void test_sync_echo_of_write_in_flight_is_stale() {
+  SwitchSyncState s = synced();
+  uint32_t version = SwitchSync::change(&s, 1);
+  TEST_ASSERT_EQUAL_INT(SWITCH_SYNC_STALE, SwitchSync::remote(&s, 0, 10));
+  SwitchSync::ack(&s, version);
+  TEST_ASSERT_EQUAL_INT(SWITCH_SYNC_NONE, SwitchSync::remote(&s, 1, version));
+}
+
+static void test_sync_failed_put_is_sent_again() {
+  SwitchSyncState s = synced();
+  uint32_t version = SwitchSync::change(&s, 1);
+  SwitchSync::ack(&s, version); // Dropped or failed, the worker still ack
+  TEST_ASSERT_EQUAL_INT(SWITCH_SYNC_SEND, SwitchSync::remote(&s, 0, 10));
+  TEST_ASSERT_EQUAL_UINT32(version, s.pending);
+}
+
+static void test_sync_older_ack_keeps_newer_pending() {
+  SwitchSyncState s = synced();
+  uint32_t first = SwitchSync::change(&s, 1);
+  uint32_t second = SwitchSync::change(&s, 0);
+  SwitchSync::ack(&s, first);
+  TEST_ASSERT_EQUAL_UINT32(second, s.pending);
+}
+
+static void test_sync_lost_ack_stops_holding_polls() {
+  SwitchSyncState s = synced();
+  uint32_t version = SwitchSync::change(&s, 1);
+  for (int i = 1; i < SWITCH_SYNC_MAX_STALE; i++) {
+    TEST_ASSERT_EQUAL_INT(SWITCH_SYNC_STALE, SwitchSync::remote(&s, 0, 10));
+  }
+  TEST_ASSERT_EQUAL_INT(SWITCH_SYNC_SEND, SwitchSync::remote(&s, 0, 10));
+  TEST_ASSERT_EQUAL_UINT32(version, s.pending);
+}
+
+static void test_sync_lost_ack_without_versions() {
+  SwitchSyncState s = {};
+  SwitchSync::remote(&s, 0, 0);
+  SwitchSync::change(&s, 1);
+  for (int i = 1; i < SWITCH_SYNC_MAX_STALE; i++) {
+    TEST_ASSERT_EQUAL_INT(SWITCH_SYNC_STALE, SwitchSync::remote(&s, 0, 0));
+  }
+  TEST_ASSERT_EQUAL_INT(SWITCH_SYNC_APPLY, SwitchSync::remote(&s, 0, 0)); // Server state win
+  TEST_ASSERT_EQUAL_UINT32(0, s.pending);
+}
+
+void run_switch_sync_tests() {
+  RUN_TEST(test_sync_first_poll_keeps_device_state);
+  RUN_TEST(test_sync_newer_server_state_applies);
+  RUN_TEST(test_sync_echo_of_write_in_flight_is_stale);
+  RUN_TEST(test_sync_failed_put_is_sent_again);
+  RUN_TEST(test_sync_older_ack_keeps_newer_pending);
+  RUN_TEST(test_sync_lost_ack_stops_holding_polls);
+  RUN_TEST(test_sync_lost_ack_without_versions);
+}
@@ -0,0 +1,400 @@
+#!/usr/bin/env python3
+# Local stand-in for the .NET API (DOTNET_BASE_URL) with fault injection.
+#
+#   python tools/mock_api_server.py --port 8080 --latency 200 --jitter 100 --error-rate 0.05 \
+#       --timeout-rate 0.02 --drop-rate 0.02 --command-every 15
+#
+# Point the firmware at it with -DDOTNET_BASE_URL=\"http://<pc ip>:8080/minapi/v1\" in build_flags,
+# or run the host harness: .pio/build/native/program net http://127.0.0.1:8080/minapi/v1 120
+#
+# Control endpoints (no prefix, never faulted):
+#   GET  /mock/stats     per route count / rate / status, command latency
+#   POST /mock/faults    {"latency":200,"error_rate":0.1,...} change faults while running
+#   POST /mock/command   {"id":2,"state":"on"} switch change as if from the web
+#   POST /mock/reset     clear stats
+#
+# Switch versions: every change take the next "version" of that switch with its "origin".
+# A PUT with a lower version (or the same version and another state) get 409 and the
+# current switch, like the .NET API. A PUT without a version always win (old firmware).
+#
+# Server hints: --retry-after s sent with injected errors, --poll-interval s sent as
+# X-Poll-Interval on GET /api/switch, "intervals" object in the --fixture sync data.
+#
+# Command latency: "poll" = command -> first GET /api/switch that return it,
+# "ack" = command -> first automation status / log POST for that relay after.
+
+import argparse
+import json
+import random
+import re
+import socket
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import urlparse
+
+DEFAULT_API_KEY = "DD5B523CF73EF3386DB2DE4A7AEDD"
+
+DEFAULT_SYNC = {
+    "syncToken": "mock-1",
+    "timers": [
+        {"id": 1, "relayId": 0, "timerId": 0, "enabled": True, "days": [1, 1, 1, 1, 1, 1, 1],
+         "timeOn": "06:00:00", "timeOff": "06:15:00"},
+        {"id": 2, "relayId": 1, "timerId": 0, "enabled": True, "days": [1, 1, 1, 1, 1, 0, 0],
+         "timeOn": "07:00:00", "timeOff": "19:00:00"},
+    ],
+    "sensors": [
+        {"id": 1, "relayId": 2, "sensorType": "humidity", "enabled": True, "controlMode": "min_trigger",
+         "minValue": 80.0, "maxValue": 95.0, "hysteresis": 2.0, "actionOnTrigger": "turn_on"},
+        {"id": 2, "relayId": 3, "sensorType": "temperature", "enabled": True, "controlMode": "max_trigger",
+         "minValue": 0, "maxValue": 30.0, "hysteresis": 2.0, "actionOnTrigger": "turn_on"},
+    ],
+}
+
+FAULT_KEYS = ("latency", "jitter", "error_rate", "error_code", "timeout_rate", "hang", "drop_rate", "fault_path",
+              "retry_after", "poll_interval")
+
+
+def now_iso():
+    return time.strftime("%Y-%m-%dT%H:%M:%S", time.gmtime()) + ".000Z"
+
+
+def percentile(values, p):
+    if not values:
+        return 0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+class MockState:
+    def __init__(self, args):
+        self.lock = threading.Lock()
+        self.faults = {key: getattr(args, key) for key in FAULT_KEYS}
+        self.api_key = args.api_key
+        self.sync = DEFAULT_SYNC
+        if args.fixture:
+            with open(args.fixture) as f:
+                self.sync = json.load(f)
+        self.switches = {i: {"id": i, "name": "Switch %d" % i, "state": "off", "version": 0, "origin": "",
+                             "updatedAt": now_iso()} for i in range(1, 5)}
+        self.status = {}
+        self.logs = []
+        self.reset()
+
+    def reset(self):
+        self.started = time.time()
+        self.routes = {}        # "GET /api/switch" -> {"count", "codes": {}, "faults": {}}
+        self.commands = []      # {"id", "state", "t0", "poll", "ack"}
+
+    def route(self, key):
+        return self.routes.setdefault(key, {"count": 0, "codes": {}, "faults": {}})
+
+    def count(self, key, code=None, fault=None):
+        with self.lock:
+            r = self.route(key)
+            r["count"] += 1
+            if code is not None:
+                r["codes"][str(code)] = r["codes"].get(str(code), 0) + 1
+            if fault:
+                r["faults"][fault] = r["faults"].get(fault, 0) + 1
+
+    def store(self, switch_id, state, version, origin):
+        # Caller hold the lock. Return False when the write lose to a newer one
+        sw = self.switches[switch_id]
+        if version is None:
+            version = sw["version"] + 1
+        elif version < sw["version"] or (version == sw["version"] and state != sw["state"]):
+            return False
+        sw.update(state=state, version=version, origin=origin, updatedAt=now_iso())
+        return True
+
+    def command(self, switch_id, state):
+        with self.lock:
+            self.store(switch_id, state, None, "web")
+            self.commands.append({"id": switch_id, "state": state, "t0": time.time(), "poll": None, "ack": None})
+
+    def observed_poll(self, switch_ids):
+        with self.lock:
+            t = time.time()
+            for c in self.commands:
+                if c["poll"] is None and c["id"] in switch_ids and self.switches[c["id"]]["state"] == c["state"]:
+                    c["poll"] = t - c["t0"]
+
+    def observed_ack(self, relay_id):
+        with self.lock:
+            t = time.time()
+            for c in self.commands:
+                if c["poll"] is not None and c["ack"] is None and c["id"] == relay_id + 1:
+                    c["ack"] = t - c["t0"]
+
+    def stats(self):
+        with self.lock:
+            elapsed = max(time.time() - self.started, 0.001)
+            routes = {key: dict(r, rate_per_min=round(r["count"] * 60.0 / elapsed, 2)) for key, r in sorted(self.routes.items())}
+            result = {"elapsed_s": round(elapsed, 1), "faults": dict(self.faults), "routes": routes,
+                      "commands": {"sent": len(self.commands)}}
+            for phase in ("poll", "ack"):
+                values = [c[phase] * 1000 for c in self.commands if c[phase] is not None]
+                result["commands"][phase] = {
+                    "n": len(values),
+                    "avg_ms": round(sum(values) / len(values), 1) if values else 0,
+                    "p50_ms": round(percentile(values, 50), 1),
+                    "p95_ms": round(percentile(values, 95), 1),
+                    "max_ms": round(max(values), 1) if values else 0,
+                }
+            return result
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    server_version = "MockDotNet/1.0"
+    state = None
+    prefix = ""
+
+    def log_message(self, format, *args):
+        if self.server.verbose:
+            sys.stderr.write("%s %s\n" % (time.strftime("%H:%M:%S"), format % args))
+
+    def do_GET(self):
+        self.handle_request("GET")
+
+    def do_POST(self):
+        self.handle_request("POST")
+
+    def do_PUT(self):
+        self.handle_request("PUT")
+
+    def read_body(self):
+        length = int(self.headers.get("Content-Length") or 0)
+        body = self.rfile.read(length) if length else b""
+        try:
+            return json.loads(body) if body else {}
+        except ValueError:
+            return None
+
+    def reply(self, code, payload, headers=None):
+        body = json.dumps(payload).encode()
+        self.send_response(code)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.send_header("Connection", "close")
+        for name, value in (headers or {}).items():
+            self.send_header(name, value)
+        self.end_headers()
+        self.wfile.write(body)
+        self.close_connection = True
+
+    def handle_request(self, method):
+        path = urlparse(self.path).path
+        body = self.read_body()
+
+        if path.startswith("/mock/"):
+            return self.handle_control(method, path, body)
+
+        if not path.startswith(self.prefix):
+            return self.reply(404, {"success": False, "error": {"message": "not found"}})
+        path = path[len(self.prefix):]
+        key = method + " " + re.sub(r"/\d+(?=/|$)", "/{id}", path)
+
+        fault = self.inject_fault(path)
+        if fault in ("timeout", "drop"):
+            self.state.count(key, fault=fault)
+            if fault == "timeout":
+                time.sleep(self.state.faults["hang"])  # Longer than the client timeout, then close without a reply
+            self.close_connection = True
+            return
+        if fault == "error":
+            code = self.state.faults["error_code"]
+            retry_after = self.state.faults["retry_after"]
+            self.state.count(key, code, fault)
+            return self.reply(code, {"success": False, "error": {"message": "injected fault"}},
+                              {"Retry-After": "%d" % retry_after} if retry_after else None)
+
+        if self.state.api_key and self.headers.get("X-API-KEY") != self.state.api_key:
+            self.state.count(key, 401)
+            return self.reply(401, {"success": False, "error": {"message": "invalid API key"}})
+        if body is None:
+            self.state.count(key, 400)
+            return self.reply(400, {"success": False, "error": {"message": "invalid JSON"}})
+
+        code, payload = self.route(method, path, body)
+        self.state.count(key, code)
+        poll_interval = self.state.faults["poll_interval"]
+        self.reply(code, payload, {"X-Poll-Interval": "%d" % poll_interval}
+                   if poll_interval and key == "GET /api/switch" else None)
+
+    def inject_fault(self, path):
+        f = self.state.faults
+        if f["fault_path"] and not re.search(f["fault_path"], path):
+            return None
+        delay = f["latency"] + random.uniform(-f["jitter"], f["jitter"])
+        if delay > 0:
+            time.sleep(delay / 1000.0)
+        roll = random.random()
+        if roll < f["drop_rate"]:
+            try:
+                self.connection.shutdown(socket.SHUT_RDWR)
+            except OSError:
+                pass
+            return "drop"
+        roll -= f["drop_rate"]
+        if roll < f["timeout_rate"]:
+            return "timeout"
+        roll -= f["timeout_rate"]
+        if roll < f["error_rate"]:
+            return "error"
+        return None
+
+    def route(self, method, path, body):
+        s = self.state
+        ok = lambda data=None: (200, {"success": True, "data": data})
+
+        if path == "/api/telemetry" and method == "POST":
+            return 201, {"success": True, "data": {"id": random.randint(1, 1 << 30)}}
+
+        if path == "/api/switch" and method == "GET":
+            with s.lock:
+                data = [dict(v) for v in s.switches.values()]
+            s.observed_poll({1, 2, 3, 4})
+            return ok(data)
+
+        m = re.fullmatch(r"/api/switch/(\d+)", path)
+        if m:
+            switch_id = int(m.group(1))
+            if switch_id not in s.switches:
+                return 404, {"success": False, "error": {"message": "switch not found"}}
+            if method == "PUT":
+                version = body.get("version")
+                if (body.get("id") != switch_id or body.get("state") not in ("on", "off")
+                        or (version is not None and not isinstance(version, int))):
+                    return 400, {"success": False, "error": {"message": "invalid state or id mismatch"}}
+                with s.lock:
+                    if not s.store(switch_id, body["state"], version, body.get("origin", "")):
+                        return 409, {"success": False, "error": {"message": "newer version on server"},
+                                     "data": dict(s.switches[switch_id])}
+            else:
+                s.observed_poll({switch_id})
+            with s.lock:
+                return ok(dict(s.switches[switch_id]))
+
+        if path == "/api/automation/sync" and method == "GET":
+            return ok(dict(s.sync, serverTime=now_iso()))
+
+        if path in ("/api/automation/timers", "/api/automation/sensors") and method == "GET":
+            return ok(s.sync.get(path.rsplit("/", 1)[1], []))
+
+        m = re.fullmatch(r"/api/automation/relay/(\d+)/(trigger|control)", path)
+        if m and method == "POST":
+            s.observed_ack(int(m.group(1)))
+            return ok({"relayId": int(m.group(1)), "action": body.get("action")})
+
+        if path == "/api/automation/status":
+            if method == "POST":
+                with s.lock:
+                    s.status[body.get("relayId")] = dict(body, updatedAt=now_iso())
+                s.observed_ack(body.get("relayId", -1))
+                return ok()
+            with s.lock:
+                return ok(list(s.status.values()))
+
+        if path in ("/api/automation/override", "/api/automation/override/cancel") and method == "POST":
+            return ok()
+
+        if path == "/api/automation/logs":
+            if method == "POST":
+                with s.lock:
+                    s.logs = (s.logs + [dict(body, createdAt=now_iso())])[-200:]
+                s.observed_ack(body.get("relayId", -1))
+                return 201, {"success": True, "data": None}
+            with s.lock:
+                return ok(list(s.logs))
+
+        return 404, {"success": False, "error": {"message": "not found"}}
+
+    def handle_control(self, method, path, body):
+        s = self.state
+        if path == "/mock/stats" and method == "GET":
+            return self.reply(200, s.stats())
+        if path == "/mock/faults" and method == "POST" and body is not None:
+            with s.lock:
+                for key, value in body.items():
+                    if key in FAULT_KEYS:
+                        s.faults[key] = value
+                faults = dict(s.faults)
+            return self.reply(200, faults)
+        if path == "/mock/command" and method == "POST" and body:
+            switch_id, switch_state = body.get("id"), body.get("state")
+            if switch_id not in s.switches or switch_state not in ("on", "off"):
+                return self.reply(400, {"error": "id 1..4, state on / off"})
+            s.command(switch_id, switch_state)
+            return self.reply(200, {"id": switch_id, "state": switch_state})
+        if path == "/mock/reset" and method == "POST":
+            with s.lock:
+                s.reset()
+            return self.reply(200, {})
+        return self.reply(404, {"error": "unknown control endpoint"})
+
+
+def command_loop(state, every):
+    while True:
+        time.sleep(every)
+        switch_id = random.randint(1, 4)
+        with state.lock:
+            current = state.switches[switch_id]["state"]
+        state.command(switch_id, "off" if current == "on" else "on")
+
+
+def stats_loop(state, every):
+    while True:
+        time.sleep(every)
+        sys.stderr.write(json.dumps(state.stats()) + "\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Mock .NET API with fault injection")
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--prefix", default="/minapi/v1", help="path of DOTNET_BASE_URL")
+    parser.add_argument("--api-key", default=DEFAULT_API_KEY, help="X-API-KEY to accept, empty = any")
+    parser.add_argument("--fixture", help="JSON file with the automation sync data object")
+    parser.add_argument("--latency", type=float, default=0, help="ms added before every reply")
+    parser.add_argument("--jitter", type=float, default=0, help="+/- ms on the latency")
+    parser.add_argument("--error-rate", type=float, default=0, help="0..1, reply --error-code")
+    parser.add_argument("--error-code", type=int, default=503)
+    parser.add_argument("--timeout-rate", type=float, default=0, help="0..1, hang --hang s then close")
+    parser.add_argument("--hang", type=float, default=15, help="s, longer than DOTNET_API_TIMEOUT")
+    parser.add_argument("--drop-rate", type=float, default=0, help="0..1, close the connection without reply")
+    parser.add_argument("--fault-path", default="", help="regex, fault only matching paths (e.g. ^/api/switch)")
+    parser.add_argument("--retry-after", type=int, default=0, help="s, Retry-After on injected errors, 0 = none")
+    parser.add_argument("--poll-interval", type=int, default=0, help="s, X-Poll-Interval on GET /api/switch, 0 = none")
+    parser.add_argument("--command-every", type=float, default=0, help="s, flip a random switch like a web user")
+    parser.add_argument("--stats-every", type=float, default=0, help="s, print stats JSON to stderr")
+    parser.add_argument("--seed", type=int)
+    parser.add_argument("-v", "--verbose", action="store_true", help="log every request")
+    args = parser.parse_args()
+
+    if args.seed is not None:
+        random.seed(args.seed)
+
+    Handler.state = MockState(args)
+    Handler.prefix = args.prefix.rstrip("/")
+    server = ThreadingHTTPServer((args.host, args.port), Handler)
+    server.daemon_threads = True
+    server.verbose = args.verbose
+
+    if args.command_every > 0:
+        threading.Thread(target=command_loop, args=(Handler.state, args.command_every), daemon=True).start()
+    if args.stats_every > 0:
+        threading.Thread(target=stats_loop, args=(Handler.state, args.stats_every), daemon=True).start()
+
+    sys.stderr.write("Mock API on http://%s:%d%s\n" % (args.host, args.port, Handler.prefix))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    print(json.dumps(Handler.state.stats(), indent=2))
+
+
+if __name__ == "__main__":
+    main()
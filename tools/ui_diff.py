@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+# Compare two headless UI simulator runs (src/NativeUiSim.cpp), screenshots and render time.
+#
+#   .pio/build/ui_sim/program ui_base        (on the old tree)
+#   .pio/build/ui_sim/program ui_new         (with the asset / font / layout change)
+#   python tools/ui_diff.py ui_base ui_new --diff-dir ui_diff
+#
+# Per screen: changed pixels + bounding box (diff image = changed pixels red over the
+# dimmed old screenshot) and full / update redraw time old -> new.
+# Exit 1 if a screen change more than --pixels pixels or a redraw get slower than
+# --tolerance %, so it can gate a change; times only compare on the same machine.
+
+import argparse
+import csv
+import os
+import sys
+
+TIME_COLUMNS = ("full_med_us", "update_avg_us")
+
+
+def read_ppm(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    fields = []
+    pos = 0
+    while len(fields) < 4:  # magic, width, height, maxval
+        while data[pos:pos + 1].isspace():
+            pos += 1
+        if data[pos:pos + 1] == b"#":
+            pos = data.index(b"\n", pos)
+            continue
+        end = pos
+        while not data[end:end + 1].isspace():
+            end += 1
+        fields.append(data[pos:end])
+        pos = end
+    if fields[0] != b"P6" or fields[3] != b"255":
+        raise ValueError("%s: only binary 8 bit PPM (P6)" % path)
+    width, height = int(fields[1]), int(fields[2])
+    pixels = data[pos + 1:pos + 1 + width * height * 3]
+    return width, height, pixels
+
+
+def write_ppm(path, width, height, pixels):
+    with open(path, "wb") as f:
+        f.write(b"P6\n%d %d\n255\n" % (width, height))
+        f.write(pixels)
+
+
+def diff_image(old, new):
+    width, height, a = old
+    if (width, height) != new[:2]:
+        return width * height, (0, 0, width - 1, height - 1), None
+    b = new[2]
+    changed = 0
+    x1, y1, x2, y2 = width, height, -1, -1
+    out = bytearray(len(a))
+    for i in range(0, len(a), 3):
+        if a[i:i + 3] != b[i:i + 3]:
+            changed += 1
+            x, y = (i // 3) % width, (i // 3) // width
+            x1, y1, x2, y2 = min(x1, x), min(y1, y), max(x2, x), max(y2, y)
+            out[i:i + 3] = b"\xff\x00\x00"
+        else:
+            gray = (a[i] + a[i + 1] + a[i + 2]) // 12 + 160
+            out[i:i + 3] = bytes((gray, gray, gray))
+    return changed, (x1, y1, x2, y2) if changed else None, bytes(out)
+
+
+def read_frames(run_dir):
+    path = os.path.join(run_dir, "frames.csv")
+    if not os.path.exists(path):
+        return {}
+    with open(path, newline="") as f:
+        return {row["screen"]: row for row in csv.DictReader(f)}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare two headless UI simulator runs")
+    parser.add_argument("old", help="baseline run directory")
+    parser.add_argument("new", help="run directory to check")
+    parser.add_argument("--diff-dir", help="write <screen>.ppm diff images here")
+    parser.add_argument("--pixels", type=int, default=0, help="changed pixels allowed per screen")
+    parser.add_argument("--tolerance", type=float, default=25.0, help="redraw time regression allowed, %%")
+    args = parser.parse_args()
+
+    old_frames = read_frames(args.old)
+    new_frames = read_frames(args.new)
+    screens = sorted({name[:-4] for name in os.listdir(args.old) if name.endswith(".ppm")} |
+                     {name[:-4] for name in os.listdir(args.new) if name.endswith(".ppm")})
+    if args.diff_dir:
+        os.makedirs(args.diff_dir, exist_ok=True)
+
+    failed = False
+    print("%-14s %9s %-20s %22s %22s" % ("screen", "changed", "bbox", "full_med_us", "update_avg_us"))
+    for screen in screens:
+        old_path = os.path.join(args.old, screen + ".ppm")
+        new_path = os.path.join(args.new, screen + ".ppm")
+        if not os.path.exists(old_path) or not os.path.exists(new_path):
+            print("%-14s %s" % (screen, "only in " + (args.new if os.path.exists(new_path) else args.old)))
+            failed = True
+            continue
+
+        old = read_ppm(old_path)
+        changed, bbox, image = diff_image(old, read_ppm(new_path))
+        if changed > args.pixels:
+            failed = True
+        if image is not None and changed and args.diff_dir:
+            write_ppm(os.path.join(args.diff_dir, screen + ".ppm"), old[0], old[1], image)
+
+        times = []
+        for column in TIME_COLUMNS:
+            before = old_frames.get(screen, {}).get(column)
+            after = new_frames.get(screen, {}).get(column)
+            if before is None or after is None:
+                times.append("-")
+                continue
+            before, after = int(before), int(after)
+            change = (after - before) * 100.0 / before if before else 0.0
+            if change > args.tolerance:
+                failed = True
+            times.append("%d -> %d (%+.0f%%)" % (before, after, change))
+
+        print("%-14s %9d %-20s %22s %22s" % (screen, changed, "%d,%d-%d,%d" % bbox if bbox else "-", *times))
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())